@@ -0,0 +1,146 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Microbenchmark for bufio delimiter scanning: the byte loop ReadSlice
+// used before (std::find) against ScanByte, and the scalar set loop
+// against ScanAny, over lines shaped like logs and HTTP headers. Then
+// ReadSlice/ReadSliceAny end to end through a 4 KiB Reader.
+
+#include <absl/strings/string_view.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "tin/bufio/bufio.h"
+#include "tin/bufio/scan.h"
+#include "tin/error/error.h"
+
+namespace {
+
+const size_t kCorpusSize = 8 << 20;
+const int kRounds = 20;
+
+// Lines seen; printed so the scans cannot be optimized away.
+size_t lines_seen = 0;
+
+// Lines of log-normal length (median ~median bytes) ending in "\r\n".
+std::string MakeCorpus(double median, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::lognormal_distribution<double> length(std::log(median), 0.6);
+  std::uniform_int_distribution<int> letter(' ' + 1, '~');
+  std::string corpus;
+  corpus.reserve(kCorpusSize + 4096);
+  while (corpus.size() < kCorpusSize) {
+    size_t n = std::min<size_t>(static_cast<size_t>(length(rng)), 4000);
+    for (size_t i = 0; i < n; ++i) {
+      corpus.push_back(static_cast<char>(letter(rng)));
+    }
+    corpus += "\r\n";
+  }
+  return corpus;
+}
+
+class StringReader : public tin::io::Reader {
+ public:
+  explicit StringReader(const std::string& data) : data_(data) {}
+  tin::Result<size_t> Read(void* buf, int nbytes) override {
+    if (pos_ == data_.size()) {
+      return tin::Result<size_t>::Err(TIN_EOF);
+    }
+    size_t n = std::min(static_cast<size_t>(nbytes), data_.size() - pos_);
+    data_.copy(static_cast<char*>(buf), n, pos_);
+    pos_ += n;
+    return tin::Result<size_t>::Ok(n);
+  }
+
+ private:
+  const std::string& data_;
+  size_t pos_ = 0;
+};
+
+// GB/s for kRounds passes over corpus since start.
+double Throughput(const std::string& corpus,
+                  std::chrono::steady_clock::time_point start) {
+  std::chrono::duration<double> secs =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(corpus.size()) * kRounds / secs.count() / 1e9;
+}
+
+// Runs scan(p, end) line by line over the corpus kRounds times.
+template <typename Scan>
+double Measure(const std::string& corpus, Scan scan) {
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(corpus.data());
+  const uint8_t* end = begin + corpus.size();
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; ++round) {
+    for (const uint8_t* p = begin; p < end;) {
+      p = scan(p, end) + 1;
+      ++lines_seen;
+    }
+  }
+  return Throughput(corpus, start);
+}
+
+template <typename Next>
+double MeasureReader(const std::string& corpus, Next next) {
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; ++round) {
+    StringReader src(corpus);
+    tin::bufio::Reader reader(&src);
+    absl::string_view line;
+    while (next(&reader, &line)) {
+      ++lines_seen;
+    }
+  }
+  return Throughput(corpus, start);
+}
+
+void Run(const char* name, double median) {
+  std::string corpus = MakeCorpus(median, 42);
+  printf("%s (median line %.0f bytes)\n", name, median);
+
+  double find = Measure(corpus, [](const uint8_t* p, const uint8_t* end) {
+    return std::find(p, end, '\n');
+  });
+  double byte = Measure(corpus, [](const uint8_t* p, const uint8_t* end) {
+    return tin::bufio::ScanByte(p, end, '\n');
+  });
+  printf("  '\\n'    std::find %6.2f GB/s  ScanByte %6.2f GB/s\n",
+         find, byte);
+
+  double scalar = Measure(corpus, [](const uint8_t* p, const uint8_t* end) {
+    return tin::bufio::ScanAnyScalar(p, end, "\r\n");
+  });
+  double any = Measure(corpus, [](const uint8_t* p, const uint8_t* end) {
+    return tin::bufio::ScanAny(p, end, "\r\n");
+  });
+  printf("  \"\\r\\n\"  scalar    %6.2f GB/s  ScanAny  %6.2f GB/s\n",
+         scalar, any);
+
+  double slice = MeasureReader(corpus, [](tin::bufio::Reader* r,
+                                          absl::string_view* line) {
+    return r->ReadSlice('\n', line).code() != TIN_EOF;
+  });
+  double slice_any = MeasureReader(corpus, [](tin::bufio::Reader* r,
+                                              absl::string_view* line) {
+    return r->ReadSliceAny("\r\n", line).code() != TIN_EOF;
+  });
+  printf("  Reader  ReadSlice %6.2f GB/s  ReadSliceAny %6.2f GB/s\n",
+         slice, slice_any);
+}
+
+}  // namespace
+
+int main() {
+  Run("HTTP headers", 28);
+  Run("log lines", 120);
+  Run("long records", 1500);
+  printf("%zu lines scanned\n", lines_seen);
+  return 0;
+}
@@ -5,12 +5,12 @@
 #include "tin/time.h"
 #include "tin/runtime.h"
 #include "tin/net/tcp.h"
+#include "tin/io/buffer_pool.h"
 
 #include <absl/log/log.h>
 #include <absl/log/check.h>
 #include <absl/log/globals.h>
 #include <thread>
-#include <memory>
 #include <cstdint>
 
 // case 0
@@ -21,13 +21,13 @@ void HandleClient0(tin::net::TcpConn conn) {
 
   // user space buffer size.
   const int kIoBufferSize = 4 * 1024;
-  std::unique_ptr<char[]> buf(new char[kIoBufferSize]);
+  tin::io::PooledBuffer buf(kIoBufferSize);
 
   // set read, write deadline.
   const int64_t kRWDeadline = 20 * tin::kSecond;
   conn.SetDeadline(kRWDeadline);
   while (true) {
-    auto read_result = conn.Read(buf.get(), kIoBufferSize);
+    auto read_result = conn.Read(buf.data(), kIoBufferSize);
     size_t n = read_result.value_or(0);
     if (n > 0) {
       conn.SetReadDeadline(kRWDeadline);
@@ -37,7 +37,7 @@ void HandleClient0(tin::net::TcpConn conn) {
       // FIN received, graceful close, we can still send.
       if (read_result.error().IsEOF()) {
         if (n > 0) {
-          conn.Write(buf.get(), static_cast<int>(n));
+          conn.Write(buf.data(), static_cast<int>(n));
         }
         conn.CloseWrite();
         // delay a while to avoid RST.
@@ -46,7 +46,7 @@ void HandleClient0(tin::net::TcpConn conn) {
       break;
     }
     DCHECK_GT(n, 0u);
-    auto write_result = conn.Write(buf.get(), static_cast<int>(n));
+    auto write_result = conn.Write(buf.data(), static_cast<int>(n));
     if (!write_result.ok()) {
       VLOG(1) << "Write failed due to " << write_result.error().ToString();
       break;
@@ -64,7 +64,7 @@ void HandleClient1(tin::net::TcpConn conn) {
 
   // user space buffer size.
   const int kIoBufferSize = 4 * 1024;
-  std::unique_ptr<char[]> buf(new char[kIoBufferSize]);
+  tin::io::PooledBuffer buf(kIoBufferSize);
 
   // record read,  write timestamp.
   int64_t last_set_recv_time = tin::MonoNow();
@@ -74,7 +74,7 @@ void HandleClient1(tin::net::TcpConn conn) {
   const int64_t kRWDeadline = 20 * tin::kSecond;
   conn.SetDeadline(kRWDeadline);
   while (true) {
-    auto read_result = conn.Read(buf.get(), kIoBufferSize);
+    auto read_result = conn.Read(buf.data(), kIoBufferSize);
     size_t n = read_result.value_or(0);
     if (n > 0) {
       int64_t now = tin::MonoNow();
@@ -90,7 +90,7 @@ void HandleClient1(tin::net::TcpConn conn) {
       // FIN received, graceful close, we can still send.
       if (read_result.error().IsEOF()) {
         if (n > 0) {
-          conn.Write(buf.get(), static_cast<int>(n));
+          conn.Write(buf.data(), static_cast<int>(n));
         }
         conn.CloseWrite();
         // delay a while to avoid RST.
@@ -99,7 +99,7 @@ void HandleClient1(tin::net::TcpConn conn) {
       break;
     }
     DCHECK_GT(n, 0u);
-    auto write_result = conn.Write(buf.get(), static_cast<int>(n));
+    auto write_result = conn.Write(buf.data(), static_cast<int>(n));
     if (!write_result.ok()) {
       VLOG(1) << "Write failed due to " << write_result.error().ToString();
       break;
@@ -124,7 +124,7 @@ void HandleClient2(tin::net::TcpConn conn) {
 
   // user space buffer size.
   const int kIoBufferSize = 4 * 1024;
-  std::unique_ptr<char[]> buf(new char[kIoBufferSize]);
+  tin::io::PooledBuffer buf(kIoBufferSize);
 
   // record read, write timestamp.
   int64_t last_recv_time = tin::MonoNow();
@@ -134,7 +134,7 @@ void HandleClient2(tin::net::TcpConn conn) {
   const int64_t kRWDeadline = 20 * tin::kSecond;
   conn.SetDeadline(kRWDeadline);
   while (true) {
-    auto read_result = conn.Read(buf.get(), kIoBufferSize);
+    auto read_result = conn.Read(buf.data(), kIoBufferSize);
     size_t n = read_result.value_or(0);
     if (n > 0) {
       // update last recv time.
@@ -152,7 +152,7 @@ void HandleClient2(tin::net::TcpConn conn) {
       // FIN received, graceful close, we can still send.
       if (read_result.error().IsEOF()) {
         if (n > 0) {
-          conn.Write(buf.get(), static_cast<int>(n));
+          conn.Write(buf.data(), static_cast<int>(n));
         }
         conn.CloseWrite();
         // delay a while to avoid RST.
@@ -165,7 +165,7 @@ void HandleClient2(tin::net::TcpConn conn) {
     bool write_failed = false;
     int left = static_cast<int>(n);
     while (left > 0) {
-      auto write_result = conn.Write(buf.get(), static_cast<int>(n));
+      auto write_result = conn.Write(buf.data(), static_cast<int>(n));
       size_t written = write_result.value_or(0);
       if (written > 0) {
         left -= static_cast<int>(written);
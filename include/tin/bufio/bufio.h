@@ -6,15 +6,24 @@
 #define TIN_BUFIO_BUFIO_H_
 #include <cstdlib>
 #include <cstdint>
+#include <memory>
 #include <absl/strings/string_view.h>
 
 #include "tin/io/io.h"
 #include "tin/result.h"
 
 
+namespace tin {
+class Timer;
+namespace net {
+class TcpConn;
+}  // namespace net
+}  // namespace tin
+
 namespace tin::bufio {
 
 const int kDefaultReaderBufSize = 4096;
+const int kDefaultWriterBufSize = 4096;
 
 /*
 +--------------+--------------------------------+
@@ -41,6 +50,11 @@ class Reader : public tin::io::Reader {
   // (including the delimiter). On error, *line contains the data read so far.
   Status ReadSlice(uint8_t delim, absl::string_view* line);
 
+  // Like ReadSlice, but stops at the first byte that is any of delims,
+  // e.g. "\r\n". An empty delims is TIN_EINVAL.
+  Status ReadSliceAny(const absl::string_view& delims,
+                      absl::string_view* line);
+
   // Reads a line. Returns Status and sets *line (without trailing \r\n or \n)
   // and *is_prefix (true if the line was longer than the buffer).
   Status ReadLine(absl::string_view* line, bool* is_prefix);
@@ -54,6 +68,18 @@ class Reader : public tin::io::Reader {
   // Peeks n bytes without consuming. Returns Status and sets *piece.
   Status Peek(int n, absl::string_view* piece);
 
+  // Lets the buffer grow from the constructor's size up to max_size on
+  // bulk streams, so they take fewer, larger reads. Before reading, Fill
+  // sizes the buffer to what a TcpConn has queued (FIONREAD) and doubles
+  // it after consecutive reads that filled it. Once the buffer is drained
+  // and the socket has nothing queued, or after several short reads from
+  // other readers, it shrinks back, so an idle connection holds only the
+  // small buffer. max_size <= size turns this off.
+  void SetMaxBufferSize(size_t max_size);
+
+  // The current buffer size.
+  int size() const { return storage_size_; }
+
   // inline functions
   int buffered() const { return write_idx_ - read_idx_; }
   int free() const { return (storage_size_ - write_idx_); }
@@ -75,6 +101,10 @@ class Reader : public tin::io::Reader {
  private:
   int ReadErr();
   void Fill();
+  void Adapt();
+  void Resize(int size);
+  template <typename Scan>
+  Status ReadSliceWith(Scan scan, absl::string_view* line);
 
   static absl::string_view ToStringPiece(const uint8_t* p, absl::string_view::size_type n) {
     return {reinterpret_cast<const char*>(p),n};
@@ -88,14 +118,66 @@ class Reader : public tin::io::Reader {
   int err_;
   tin::io::Reader* rd_;
   int last_byte_;
+  tin::net::TcpConn* tcp_;  // rd_ if it is a TcpConn, for FIONREAD
+  int min_size_;
+  int max_size_;
+  int full_reads_;   // consecutive reads that filled the buffer
+  int short_reads_;  // consecutive reads of under a quarter of it
 };
 
+struct WriterShared;
+
+// Writer coalesces small writes into one buffer and writes it out when it
+// fills up or on Flush. A write that does not fit goes straight to the
+// underlying writer; when that is a TcpConn, the buffered bytes and the
+// write leave in one writev. The first error is sticky: later calls
+// return it. Buffered data is dropped, not flushed, on destruction.
 class Writer : public tin::io::Writer {
  public:
-  virtual ~Writer() {}
-  virtual Result<size_t> Write(const void* buf, int nbytes) = 0;
-};
+  explicit Writer(tin::io::Writer* wr, size_t size = kDefaultWriterBufSize);
+  ~Writer() override;
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  // Drops buffered data and any error and writes to wr from now on.
+  void Reset(tin::io::Writer* wr);
+
+  // Returns nbytes, or the error that kept buf from being written in full.
+  Result<size_t> Write(const void* buf, int nbytes) override;
+  Result<size_t> WriteString(const absl::string_view& str);
+  Status WriteByte(uint8_t c);
 
+  // Writes the buffered data to the underlying writer.
+  Status Flush();
+
+  // Flushes on its own once nothing has been written for delay
+  // nanoseconds while data is buffered; 0 turns that off. The flush runs
+  // from a runtime timer, so coroutines only.
+  void SetFlushOnIdle(int64_t delay);
+
+  int buffered() const { return n_; }
+  int available() const { return storage_size_ - n_; }
+  int size() const { return storage_size_; }
+
+ private:
+  Status FlushLocked();
+  void ArmIdleFlushLocked();
+  static void OnIdle(const std::shared_ptr<WriterShared>& shared);
+
+  uint8_t* storage_;
+  int storage_size_;
+  int n_;
+  int err_;
+  tin::io::Writer* wr_;
+  tin::net::TcpConn* tcp_;  // wr_ if it is a TcpConn, for writev
+  int64_t idle_delay_;
+  int64_t last_write_;
+  bool idle_armed_;
+  std::unique_ptr<tin::Timer> idle_timer_;
+  // Serializes the idle flush with the owner and outlives the Writer.
+  std::shared_ptr<WriterShared> shared_;
+};
 
 
 } // namespace tin::bufio
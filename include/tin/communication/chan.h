@@ -67,6 +67,53 @@ class Channel
     return ok;
   }
 
+  // TryPush enqueues t only if there is free space, without parking.
+  // Returns false if the channel is full or closed. Unlike Push, this is
+  // safe to call from runtime timer callbacks.
+  bool TryPush(const T& t) {
+    if (IsClosed())
+      return false;
+    if (!runtime::CanSemAcquire(&free_space_sem_))
+      return false;
+    bool ok;
+    {
+      runtime::RawMutexGuard guard(&lock_);
+      ok = !IsClosed();
+      if (ok) {
+        queue_.push_back(t);
+      }
+    }
+    if (ok) {
+      runtime::SemRelease(&used_space_sem_);
+    } else {
+      runtime::SemRelease(&free_space_sem_);
+    }
+    return ok;
+  }
+
+  // TryPop dequeues into *t only if an element is ready, without parking.
+  bool TryPop(T* t) {
+    if (IsClosed())
+      return false;
+    if (!runtime::CanSemAcquire(&used_space_sem_))
+      return false;
+    bool ok;
+    {
+      runtime::RawMutexGuard guard(&lock_);
+      ok = !IsClosed();
+      if (ok) {
+        *t = queue_.front();
+        queue_.pop_front();
+      }
+    }
+    if (ok) {
+      runtime::SemRelease(&free_space_sem_);
+    } else {
+      runtime::SemRelease(&used_space_sem_);
+    }
+    return ok;
+  }
+
   void Close() {
     if (atomic::exchange32(&closed_, 1) != 0) {  // seq_cst
       // already closed.
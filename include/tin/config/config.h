@@ -5,10 +5,19 @@
 #ifndef TIN_CONFIG_CONFIG_H_
 #define TIN_CONFIG_CONFIG_H_
 
+#include <cstdint>
+
 #include "tin/config/default.h"
 
 namespace tin {
 
+// Network poller backend.
+enum class NetPoller {
+  kDefault,  // epoll (Linux), kqueue (BSD/macOS), IOCP (Windows)
+  kIoUring,  // Linux io_uring multishot poll; falls back to epoll when the
+             // kernel lacks support (needs 5.13+)
+};
+
 class Config {
  public:
   int MaxProcs() const { return max_procs_; }
@@ -26,6 +35,31 @@ class Config {
   void SetMaxMachines(int max_machine) { max_machine_ = max_machine; }
   bool IsStackProtectionEnabled() const { return enable_stack_protection_; }
   void EnableStackProtection(bool enable) { enable_stack_protection_ = enable; }
+  NetPoller GetNetPoller() const { return net_poller_; }
+  void SetNetPoller(NetPoller poller) { net_poller_ = poller; }
+  // epoll only: one epoll set per P. Descriptors register on the P that
+  // opened them and each P polls its own set before stealing from others.
+  bool IsNetPollShardingEnabled() const { return enable_netpoll_sharding_; }
+  void EnableNetPollSharding(bool enable) { enable_netpoll_sharding_ = enable; }
+  // Thread-per-core mode for Ps 0..n-1: they never steal, are never
+  // stolen from, keep their Gs off the global runq and poll their own
+  // epoll set (Linux epoll only; implies netpoll sharding).
+  int NoStealProcs() const { return no_steal_procs_; }
+  void SetNoStealProcs(int n) { no_steal_procs_ = n; }
+
+  // POSIX only: ResolveHostname queries the name servers itself, on
+  // coroutines (tin/net/dns_resolver.h), instead of calling getaddrinfo
+  // on the resolver thread pool. nsswitch.conf sources other than files
+  // and dns are then not consulted.
+  bool IsNativeResolverEnabled() const { return enable_native_resolver_; }
+  void EnableNativeResolver(bool enable) { enable_native_resolver_ = enable; }
+
+  // Bytes of free buffers the I/O buffer pool (tin/io/buffer_pool.h) may
+  // keep for reuse; buffers freed beyond that go back to the allocator.
+  int64_t BufferPoolIdleLimit() const { return buffer_pool_idle_limit_; }
+  void SetBufferPoolIdleLimit(int64_t bytes) {
+    buffer_pool_idle_limit_ = bytes;
+  }
 
  private:
   int max_procs_ = 1;
@@ -34,6 +68,11 @@ class Config {
   int os_thread_stack_size_ = kDefaultOSThreadStackSize;
   bool ignore_sigpipe_ = true;
   bool enable_stack_protection_ = false;
+  NetPoller net_poller_ = NetPoller::kDefault;
+  bool enable_netpoll_sharding_ = false;
+  int no_steal_procs_ = 0;
+  bool enable_native_resolver_ = false;
+  int64_t buffer_pool_idle_limit_ = kDefaultBufferPoolIdleLimit;
 };
 
 }  // namespace tin
@@ -5,6 +5,8 @@
 #ifndef TIN_CONFIG_DEFAULT_H_
 #define TIN_CONFIG_DEFAULT_H_
 
+#include <cstdint>
+
 namespace tin {
 
 const int kDefaultStackSize = 64 * 1024;
@@ -15,6 +17,8 @@ const int kDefaultOSThreadStackSize = 640 * 1024;
 
 constexpr int kCacheLineSize = 64;
 
+const int64_t kDefaultBufferPoolIdleLimit = 64 * 1024 * 1024;
+
 }  // namespace tin
 
 #endif  // TIN_CONFIG_DEFAULT_H_
@@ -0,0 +1,92 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: the I/O buffer pool. Read buffers, bufio storage and IoBuf
+// blocks are allocated and freed once per connection; at high connection
+// rates that churn shows up in malloc. The pool rounds sizes up to a power
+// of two between 512 B and 1 MiB, leaving smaller and larger ones to
+// malloc, and recycles buffers through per-P caches backed by a global
+// depot, so a coroutine gets a buffer without a lock or a malloc in the
+// common case. sysmon returns depot buffers that stay
+// unused to the allocator, and Config::SetBufferPoolIdleLimit caps what
+// the pool may hold. Usable from any thread; off the runtime every call
+// goes to the depot.
+
+#ifndef TIN_IO_BUFFER_POOL_H_
+#define TIN_IO_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tin::io {
+
+const size_t kMinPooledBufferSize = 512;
+const size_t kMaxPooledBufferSize = 1 << 20;
+
+// Returns at least size bytes; *capacity, if given, receives the usable
+// size. Sizes below kMinPooledBufferSize or above kMaxPooledBufferSize
+// are plain allocations of exactly size bytes.
+void* AllocBuffer(size_t size, size_t* capacity = nullptr);
+
+// size: the size passed to AllocBuffer or the capacity it reported.
+void FreeBuffer(void* buf, size_t size);
+
+// Owns one pooled buffer and gives it back on destruction.
+class PooledBuffer {
+ public:
+  PooledBuffer() : data_(nullptr), size_(0) {}
+  explicit PooledBuffer(size_t size)
+      : data_(static_cast<char*>(AllocBuffer(size, &size_))) {}
+  ~PooledBuffer() { reset(); }
+
+  PooledBuffer(PooledBuffer&& other) noexcept
+      : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+      reset();
+      data_ = other.data_;
+      size_ = other.size_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+  PooledBuffer(const PooledBuffer&) = delete;
+  PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+  char* data() const { return data_; }
+  // The capacity, at least the size asked for.
+  size_t size() const { return size_; }
+
+  void reset() {
+    if (data_ != nullptr) {
+      FreeBuffer(data_, size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+ private:
+  char* data_;
+  size_t size_;
+};
+
+struct BufferPoolStats {
+  uint64_t cache_hits;  // served from a P's cache
+  uint64_t depot_hits;  // served from the global depot
+  uint64_t allocs;      // fell through to the allocator
+  uint64_t depot_bytes;  // held by the depot right now
+};
+
+BufferPoolStats GetBufferPoolStats();
+
+// Frees every buffer in the depot. P caches are handed back to the depot
+// on their next use.
+void TrimBufferPool();
+
+}  // namespace tin::io
+#endif  // TIN_IO_BUFFER_POOL_H_
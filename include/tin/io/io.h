@@ -35,6 +35,43 @@ class IoReadWriter : public Reader, public Writer {
 // Deprecated alias for backward compatibility. Use IoReadWriter instead.
 using IOReadWriter = IoReadWriter;
 
+// Implemented by writers that can pull from a Reader without a user-space
+// buffer (e.g. TcpConn splicing from another TcpConn). Copy uses it.
+class ReaderFrom {
+ public:
+  virtual ~ReaderFrom() {}
+  // Reads from r until EOF or error. Returns the number of bytes copied.
+  virtual Result<size_t> ReadFrom(Reader* r) = 0;
+};
+
+// Implemented by readers that can push into a Writer without a user-space
+// buffer. Copy prefers it over ReaderFrom.
+class WriterTo {
+ public:
+  virtual ~WriterTo() {}
+  // Writes to w until there is no more data or an error occurs. Returns the
+  // number of bytes copied.
+  virtual Result<size_t> WriteTo(Writer* w) = 0;
+};
+
+// Caller-owned memory regions for vectored I/O (iovec / WSABUF).
+struct ConstBuffer {
+  ConstBuffer() : data(nullptr), size(0) {}
+  ConstBuffer(const void* d, size_t n) : data(d), size(n) {}
+  ConstBuffer(absl::string_view s) : data(s.data()), size(s.size()) {}
+
+  const void* data;
+  size_t size;
+};
+
+struct MutableBuffer {
+  MutableBuffer() : data(nullptr), size(0) {}
+  MutableBuffer(void* d, size_t n) : data(d), size(n) {}
+
+  void* data;
+  size_t size;
+};
+
 // Reads from reader into buf until at least min bytes are read or an error
 // occurs. Returns the number of bytes read and a status.
 Result<size_t> ReadAtLeast(Reader* reader, void* buf, int nbytes, int min);
@@ -48,5 +85,14 @@ Result<size_t> Write(Writer* writer, const void* buf, int len);
 // Writes a string to writer.
 Result<size_t> WriteString(Writer* writer, const absl::string_view& str);
 
+// Copies from src to dst until EOF on src, which is not an error. Takes
+// src's WriterTo or dst's ReaderFrom fast path when there is one, else
+// copies through a 32 KiB buffer. On error the count is dropped.
+Result<size_t> Copy(Writer* dst, Reader* src);
+
+// Like Copy, but always copies through buf and never takes the fast
+// paths. ReaderFrom/WriterTo implementations fall back to it.
+Result<size_t> CopyBuffer(Writer* dst, Reader* src, void* buf, int len);
+
 }  // namespace tin::io
 #endif  // TIN_IO_IO_H_
@@ -0,0 +1,126 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: IoBuf, a byte string kept as a chain of slices of refcounted
+// blocks (folly IOBuf / absl::Cord). Unlike IoBuffer it never moves bytes
+// to grow: appending raw bytes fills the free tail of the last block or
+// chains a new one, and copying, Append(IoBuf), Cut and Sub share blocks
+// instead of copying them. A proxy or framer can read into an IoBuf, cut
+// a message off the front and hand it to the write path, which sends the
+// slices with one writev, without touching the payload. Blocks come from
+// the I/O buffer pool (tin/io/buffer_pool.h).
+
+#ifndef TIN_IO_IO_BUF_H_
+#define TIN_IO_IO_BUF_H_
+
+#include <absl/strings/string_view.h>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "tin/io/io.h"
+#include "tin/result.h"
+
+namespace tin {
+
+struct IoBlock;
+
+// An IoBuf is not synchronized, but IoBufs that share blocks may be used
+// from different coroutines and threads: bytes reachable from more than
+// one IoBuf are never written again.
+class IoBuf : public io::IoReadWriter,
+              public io::ReaderFrom,
+              public io::WriterTo {
+ public:
+  // Size of the blocks Append and ReadFrom allocate, header included.
+  static constexpr size_t kBlockSize = 8192;
+
+  IoBuf();
+  ~IoBuf() override;
+  // Shares other's blocks.
+  IoBuf(const IoBuf& other);
+  IoBuf& operator=(const IoBuf& other);
+  IoBuf(IoBuf&& other) noexcept;
+  IoBuf& operator=(IoBuf&& other) noexcept;
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // Slices in the chain, i.e. the number of buffers GetBuffers adds.
+  size_t slice_count() const { return slices_.size(); }
+
+  void Clear();
+
+  // Copies n bytes to the end.
+  void Append(const void* data, size_t n);
+  void Append(absl::string_view s) { Append(s.data(), s.size()); }
+  // Shares other's blocks; nothing is copied.
+  void Append(const IoBuf& other);
+  void Append(IoBuf&& other);
+
+  // Copies n bytes to the front: into free space before the first slice
+  // when its block is not shared, else into a new block.
+  void Prepend(const void* data, size_t n);
+  void Prepend(absl::string_view s) { Prepend(s.data(), s.size()); }
+  // Shares other's blocks; nothing is copied.
+  void Prepend(const IoBuf& other);
+  void Prepend(IoBuf&& other);
+
+  // Removes the first n bytes (all of them if n > size()) and returns
+  // them. The block that straddles the cut ends up shared.
+  IoBuf Cut(size_t n);
+  void TrimFront(size_t n);
+  void TrimBack(size_t n);
+  // Bytes [pos, pos + n), clamped to size(), sharing blocks.
+  IoBuf Sub(size_t pos, size_t n) const;
+
+  // Copies up to n bytes starting at pos into dst. Returns the count.
+  size_t CopyTo(void* dst, size_t n, size_t pos = 0) const;
+  std::string ToString() const;
+
+  // Adds one buffer per slice to out, in order, e.g. for TcpConn::Writev.
+  // The buffers stay valid until this IoBuf changes.
+  void GetBuffers(std::vector<io::ConstBuffer>* out) const;
+
+  // Reading straight into the chain: PrepareAppend returns at least min
+  // writable bytes at the end (the unshared tail of the last block, else
+  // a new block with room for min and at least kBlockSize in all);
+  // CommitAppend(n) then appends the first n of them. Nothing else may
+  // touch the IoBuf in between.
+  io::MutableBuffer PrepareAppend(size_t min = 1);
+  void CommitAppend(size_t n);
+
+  // One r->Read into PrepareAppend's space. Returns the bytes read; EOF
+  // and errors as r returns them.
+  Result<size_t> ReadOnce(io::Reader* r);
+
+  // io::Reader: copies from the front and drops what it copied. TIN_EOF
+  // once empty.
+  Result<size_t> Read(void* buf, int nbytes) override;
+  // io::Writer: Append.
+  Result<size_t> Write(const void* buf, int nbytes) override;
+  // io::ReaderFrom: ReadOnce until r reports EOF.
+  Result<size_t> ReadFrom(io::Reader* r) override;
+  // io::WriterTo: writes and drops everything; a TcpConn gets the slices
+  // in writev batches. On error the count is dropped.
+  Result<size_t> WriteTo(io::Writer* w) override;
+
+ private:
+  struct Slice {
+    IoBlock* block;
+    size_t off;
+    size_t len;
+  };
+
+  void AppendSlice(const Slice& s);
+  void PrependSlice(const Slice& s);
+
+  std::deque<Slice> slices_;
+  size_t size_;
+};
+
+}  // namespace tin
+
+#endif  // TIN_IO_IO_BUF_H_
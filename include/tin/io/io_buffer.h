@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "tin/io/buffer_pool.h"
 
 namespace tin {
 
@@ -85,7 +86,7 @@ class IoBuffer {
   }
 
   IoBuffer& operator=(IoBuffer&& rvalue) noexcept {
-    delete[] storage_;  // fixed: was 'delete storage_' (UB)
+    io::FreeBuffer(storage_, storage_size_);
     storage_ = rvalue.storage_;
     write_idx_ = rvalue.write_idx_;
     read_idx_ = rvalue.read_idx_;
@@ -0,0 +1,93 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: IoRingBuffer, a ring-buffer variant of IoBuffer for streaming
+// protocols. IoBuffer::ReserveMore moves unread bytes to the front to make
+// room, so a connection that keeps a partial frame buffered copies the same
+// bytes again on every read. IoRingBuffer never moves them: its capacity is
+// a power of two, and on Linux the storage is one memfd mapped twice, back
+// to back, so a span that runs past the end continues in the mirror and
+// GetReadablePtr/GetWritablePtr always return one contiguous span. Where
+// the mirror cannot be set up (other platforms, no memfd_create) the buffer
+// falls back to pooled storage and compacts like IoBuffer does.
+//
+// Mapping a ring costs a few syscalls, so it suits long-lived connections;
+// use IoBuffer for short-lived ones.
+
+#ifndef TIN_IO_IO_RING_BUFFER_H_
+#define TIN_IO_IO_RING_BUFFER_H_
+
+#include <cstddef>
+#include <string>
+
+namespace tin {
+
+class IoRingBuffer {
+ public:
+  IoRingBuffer();
+  // size is rounded up to a power of two, and for the mirror to a whole
+  // number of pages.
+  explicit IoRingBuffer(size_t size);
+  ~IoRingBuffer();
+
+  IoRingBuffer(IoRingBuffer&& rvalue) noexcept;
+  IoRingBuffer& operator=(IoRingBuffer&& rvalue) noexcept;
+  IoRingBuffer(const IoRingBuffer&) = delete;
+  IoRingBuffer& operator=(const IoRingBuffer&) = delete;
+
+  std::string str() const;
+
+  int buffered() const { return static_cast<int>(write_idx_ - read_idx_); }
+  int buffer_size() const { return static_cast<int>(storage_size_); }
+  int free() const { return buffer_size() - buffered(); }
+  bool empty() const { return read_idx_ == write_idx_; }
+  bool full() const { return free() == 0; }
+
+  // True when the storage is double-mapped; false on the compacting
+  // fallback.
+  bool mirrored() const { return mirrored_; }
+
+  // removes all data from the ring buffer
+  void clear() { read_idx_ = write_idx_ = 0; }
+
+  // Appends all size bytes, growing the buffer if they do not fit.
+  int Write(const void* ptr, size_t size);
+
+  // With the mirror *size is free(): all free space is one span. The
+  // fallback may return only the tail, which is at least half of free();
+  // it compacts here, hence not const.
+  void GetWritablePtr(char** ptr, int* size);
+
+  // *size is buffered(): all unread data is one span.
+  void GetReadablePtr(char** ptr, int* size) const;
+
+  int Read(char* bytes, size_t size);
+
+  // Makes free() at least size, moving to a larger ring if needed. Unlike
+  // IoBuffer, space is never reclaimed by copying. Returns true if the
+  // storage changed.
+  bool ReserveMore(int size);
+
+  void AdvanceReadablePtr(int amount_to_advance);
+
+  void AdvanceWritablePtr(int amount_to_advance);
+
+  void Swap(IoRingBuffer* other);
+
+ private:
+  void Allocate(size_t size);
+  void Release();
+
+  char* storage_;
+  size_t storage_size_;
+  // read_idx_ < storage_size_ and write_idx_ <= read_idx_ + storage_size_;
+  // with the mirror, write_idx_ may run into the second mapping.
+  size_t read_idx_;
+  size_t write_idx_;
+  bool mirrored_;
+};
+
+}  // namespace tin
+
+#endif  // TIN_IO_IO_RING_BUFFER_H_
@@ -0,0 +1,102 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: ConnPool, a pool of outbound TCP connections keyed by
+// endpoint ("ip:port" or "host:port"). Idle connections are kept in one
+// list per P, so a checkout and a return on the same P only take that
+// list's lock. A checkout probes the idle connection with a non-blocking
+// recv(MSG_PEEK) and drops it if the peer closed it or sent unsolicited
+// data. Idle connections are closed after idle_timeout by a timer on the
+// runtime timer heap. Use a ConnPool, including its destruction, from
+// coroutines only.
+
+#ifndef TIN_NET_CONN_POOL_H_
+#define TIN_NET_CONN_POOL_H_
+
+#include <absl/strings/string_view.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "tin/net/ip_endpoint.h"
+#include "tin/net/tcp_conn.h"
+#include "tin/result.h"
+#include "tin/time/time.h"
+
+namespace tin::net {
+
+class ConnPoolImpl;
+struct ConnPoolEntry;
+
+struct ConnPoolOptions {
+  // Idle connections kept per endpoint.
+  int max_idle = 16;
+  // Open connections (idle, checked out or being dialed) per endpoint;
+  // 0 means unlimited. Get waits for one to come back beyond that.
+  int max_active = 0;
+  // Idle connections older than this are closed.
+  int64_t idle_timeout = 90 * kSecond;
+};
+
+// A connection checked out of a ConnPool. Goes back to the pool when
+// released or destroyed, unless discarded.
+class PooledConn {
+ public:
+  PooledConn() = default;
+  ~PooledConn();
+  PooledConn(PooledConn&& other) noexcept;
+  PooledConn& operator=(PooledConn&& other) noexcept;
+
+  // A caller that takes the connection and resets conn() closes it
+  // itself; Release or Discard still give back its max_active slot.
+  TcpConn& conn() { return conn_; }
+  TcpConn* operator->() { return &conn_; }
+
+  // Returns the connection to the pool. It must be idle: no request in
+  // flight and nothing left unread.
+  void Release();
+  // Closes the connection instead, e.g. after an I/O error.
+  void Discard();
+
+  bool IsValid() const { return conn_.IsValid(); }
+
+ private:
+  friend class ConnPoolImpl;
+  PooledConn(std::shared_ptr<ConnPoolImpl> pool, ConnPoolEntry* entry,
+             TcpConn conn);
+  PooledConn(const PooledConn&) = delete;
+  PooledConn& operator=(const PooledConn&) = delete;
+
+  std::shared_ptr<ConnPoolImpl> pool_;
+  ConnPoolEntry* entry_ = nullptr;
+  TcpConn conn_;
+};
+
+class ConnPool {
+ public:
+  explicit ConnPool(const ConnPoolOptions& options = ConnPoolOptions());
+  // Closes the idle connections. Checked-out ones are closed when they
+  // come back.
+  ~ConnPool();
+  ConnPool(const ConnPool&) = delete;
+  ConnPool& operator=(const ConnPool&) = delete;
+
+  // Returns an idle connection to endpoint, or dials a new one.
+  // timeout: nanoseconds (0 = none); bounds both the wait for a
+  // max_active slot and the dial. TIN_ETIMEDOUT when it expires.
+  Result<PooledConn> Get(const IpEndpoint& endpoint, int64_t timeout = 0);
+  // As above; host is resolved only when a new connection is dialed.
+  Result<PooledConn> Get(const absl::string_view& host, uint16_t port,
+                         int64_t timeout = 0);
+
+  // Closes every idle connection.
+  void CloseIdle();
+
+ private:
+  std::shared_ptr<ConnPoolImpl> impl_;
+};
+
+}  // namespace tin::net
+
+#endif  // TIN_NET_CONN_POOL_H_
@@ -5,13 +5,22 @@
 #ifndef TIN_NET_DIALER_H_
 #define TIN_NET_DIALER_H_
 #include <absl/strings/string_view.h>
+#include <vector>
+
 #include "tin/net/ip_address.h"
 #include "tin/net/tcp_conn.h"
 #include "tin/net/listener.h"
 #include "tin/result.h"
+#include "tin/time/time.h"
 
 namespace tin::net {
 
+// Delay between two Happy Eyeballs connection attempts (RFC 8305).
+const int64_t kDefaultFallbackDelay = 250 * kMillisecond;
+
+// deadline: timeout in nanoseconds from now (0 = none).
+// The string_view overloads take an IP literal or a hostname; a hostname
+// is resolved and all of its addresses are dialed with DialTcpParallel.
 Result<TcpConn> DialTcp(const IpAddress& address, uint16_t port);
 
 Result<TcpConn> DialTcp(const absl::string_view& addr, uint16_t port);
@@ -22,11 +31,33 @@ Result<TcpConn> DialTcpTimeout(const IpAddress& address, uint16_t port,
 Result<TcpConn> DialTcpTimeout(const absl::string_view& addr, uint16_t port,
                                int64_t deadline);
 
+// Happy Eyeballs (RFC 8305): connection attempts to addresses start
+// fallback_delay apart, alternating between IPv6 and IPv4 beginning with
+// the family of the first address; an attempt that fails starts the next
+// one at once. The first connection wins and the others are cancelled.
+// timeout (nanoseconds, 0 = none) bounds the whole dial.
+Result<TcpConn> DialTcpParallel(const std::vector<IpAddress>& addresses,
+                                uint16_t port, int64_t timeout = 0,
+                                int64_t fallback_delay = kDefaultFallbackDelay);
+
 Result<TcpListener> ListenTcp(const IpAddress& address, uint16_t port,
                               int backlog = 511);
 
 Result<TcpListener> ListenTcp(const absl::string_view& addr, uint16_t port,
                               int backlog = 511);
 
+// Opens n SO_REUSEPORT listeners on address:port (n <= 0 means one per P).
+// With steer_by_cpu (Linux), a SO_ATTACH_REUSEPORT_CBPF program hands each
+// connection to shard (cpu % n), where cpu is the CPU that received it.
+Result<ShardedTcpListener> ListenTcpSharded(const IpAddress& address,
+                                            uint16_t port, int n,
+                                            bool steer_by_cpu = false,
+                                            int backlog = 511);
+
+Result<ShardedTcpListener> ListenTcpSharded(const absl::string_view& addr,
+                                            uint16_t port, int n,
+                                            bool steer_by_cpu = false,
+                                            int backlog = 511);
+
 }  // namespace tin::net
 #endif  // TIN_NET_DIALER_H_
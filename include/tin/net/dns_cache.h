@@ -0,0 +1,60 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: the process-wide hostname cache in front of ResolveHostname.
+// DialTcp(hostname, port) and ConnPool resolve through it. getaddrinfo does
+// not report record TTLs, so the lifetimes are the configured ones.
+//
+// - Lookups of the same name that miss at the same time share one
+//   getaddrinfo call.
+// - TIN_EAI_NONAME/TIN_EAI_NODATA answers are cached for negative_ttl;
+//   other failures are not cached.
+// - For stale_ttl after an entry expires it is still served, while one
+//   background coroutine refreshes it.
+
+#ifndef TIN_NET_DNS_CACHE_H_
+#define TIN_NET_DNS_CACHE_H_
+
+#include <absl/strings/string_view.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "tin/net/address_family.h"
+#include "tin/net/ip_address.h"
+#include "tin/result.h"
+#include "tin/time/time.h"
+
+namespace tin::net {
+
+struct DnsCacheOptions {
+  int64_t ttl = 30 * kSecond;
+  int64_t negative_ttl = 5 * kSecond;
+  int64_t stale_ttl = 30 * kSecond;
+  // Entries kept; the cache is cleared shard by shard when it overflows.
+  int max_entries = 16384;
+};
+
+struct DnsCacheStats {
+  int64_t hits;           // fresh positive or negative answers
+  int64_t stale_hits;     // expired answers served during a refresh
+  int64_t misses;         // lookups that called getaddrinfo
+  int64_t coalesced;      // lookups that waited for another one's call
+  int64_t refreshes;      // background refreshes started
+};
+
+// As ResolveHostname, through the cache.
+Status ResolveHostnameCached(const absl::string_view& hostname,
+                             AddressFamily af,
+                             std::vector<IpAddress>* addresses);
+
+// Takes effect for entries resolved afterwards.
+void SetDnsCacheOptions(const DnsCacheOptions& options);
+
+DnsCacheStats GetDnsCacheStats();
+
+void ClearDnsCache();
+
+}  // namespace tin::net
+#endif  // TIN_NET_DNS_CACHE_H_
@@ -0,0 +1,79 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: a DNS stub resolver that runs on coroutines (POSIX only).
+// A/AAAA queries go over UDP through the netpoller and are retried over
+// TCP when the answer is truncated; timeouts are netpoller deadlines, so a
+// lookup in flight costs a coroutine instead of a getaddrinfo thread.
+// The static host table (hosts(5)) is consulted before any query.
+// Config::EnableNativeResolver routes ResolveHostname through
+// ResolveHostnameNative.
+
+#ifndef TIN_NET_DNS_RESOLVER_H_
+#define TIN_NET_DNS_RESOLVER_H_
+
+#include <absl/strings/string_view.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tin/net/address_family.h"
+#include "tin/net/ip_address.h"
+#include "tin/net/ip_endpoint.h"
+#include "tin/result.h"
+#include "tin/time/time.h"
+
+namespace tin::net {
+
+class DnsResolverImpl;
+
+struct DnsConfig {
+  // Name servers; 127.0.0.1:53 when empty.
+  std::vector<IpEndpoint> servers;
+  // Suffixes tried for relative names.
+  std::vector<std::string> search;
+  // Names with at least ndots dots are tried as is before the suffixes.
+  int ndots = 1;
+  // Per query sent to one server.
+  int64_t timeout = 5 * kSecond;
+  // Passes over the server list.
+  int attempts = 2;
+  // Spread queries over the servers instead of always starting with the
+  // first one.
+  bool rotate = false;
+};
+
+// Parses resolv.conf(5) text into config: nameserver, search, domain and
+// the ndots, timeout, attempts and rotate options. Other lines are ignored.
+void ParseResolvConf(const absl::string_view& content, DnsConfig* config);
+
+class DnsResolver {
+ public:
+  explicit DnsResolver(const DnsConfig& config);
+  ~DnsResolver();
+  DnsResolver(const DnsResolver&) = delete;
+  DnsResolver& operator=(const DnsResolver&) = delete;
+
+  // Replaces the static host table with the entries of hosts(5) text.
+  void SetHosts(const absl::string_view& content);
+
+  // As ResolveHostname. IPv4 addresses come first for
+  // ADDRESS_FAMILY_UNSPECIFIED; both queries are sent at once.
+  Status Resolve(const absl::string_view& hostname, AddressFamily af,
+                 std::vector<IpAddress>* addresses);
+
+ private:
+  std::unique_ptr<DnsResolverImpl> impl_;
+};
+
+// Resolves through a process-wide DnsResolver set up from
+// /etc/resolv.conf and /etc/hosts on first use.
+Status ResolveHostnameNative(const absl::string_view& hostname,
+                             AddressFamily af,
+                             std::vector<IpAddress>* addresses);
+
+}  // namespace tin::net
+#endif  // TIN_NET_DNS_RESOLVER_H_
@@ -9,7 +9,9 @@
 #define TIN_NET_LISTENER_H_
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "tin/net/tcp_conn.h"
 #include "tin/result.h"
@@ -17,6 +19,7 @@
 namespace tin::net {
 
 class TcpListenerImpl;
+class ShardedTcpListener;
 
 class TcpListener {
  public:
@@ -27,19 +30,72 @@ class TcpListener {
 
   Status SetDeadline(int64_t t);
   Result<TcpConn> Accept();
+
+  // Waits for at least one connection, then drains up to max pending ones
+  // from the backlog with one lock and one readiness wait.
+  Result<std::vector<TcpConn>> AcceptBatch(int max);
+
+  // Accept loop: accepts in batches of up to max_batch and spawns one
+  // handler coroutine per connection, the whole batch with a single runq
+  // publish. Returns OK once the listener is closed, else the error that
+  // stopped the loop.
+  Status Serve(std::function<void(TcpConn)> handler, int max_batch = 64);
+
   Status Close();
 
+  // Returns a close-on-exec duplicate of the listening socket, owned by
+  // the caller, e.g. to hand it to a new process with UnixConn::SendFds
+  // (see FileTcpListener). TIN_ENOSYS on Windows.
+  Result<int> File();
+
   bool IsValid() const { return impl_ != nullptr; }
 
  private:
   friend Result<TcpListener> ListenTcp(const class IpAddress&,
                                        uint16_t, int);
+  friend Result<TcpListener> FileTcpListener(int fd);
+  friend Result<ShardedTcpListener> ListenTcpSharded(const class IpAddress&,
+                                                     uint16_t, int, bool,
+                                                     int);
   explicit TcpListener(std::shared_ptr<TcpListenerImpl> impl)
     : impl_(std::move(impl)) {}
 
   std::shared_ptr<TcpListenerImpl> impl_;
 };
 
+// N SO_REUSEPORT listeners bound to the same address (see ListenTcpSharded).
+// The kernel spreads incoming connections over the shards, so accepts do
+// not serialize on one socket and one FdMutex.
+class ShardedTcpListener {
+ public:
+  ShardedTcpListener() = default;
+  ~ShardedTcpListener() = default;
+  ShardedTcpListener(const ShardedTcpListener& other) = default;
+  ShardedTcpListener& operator=(const ShardedTcpListener& other) = default;
+
+  size_t Size() const { return shards_.size(); }
+  TcpListener Shard(size_t i) const { return shards_[i]; }
+
+  // Runs one accept loop coroutine per shard, loop i on P i % MaxProcs,
+  // and blocks until all of them stop. Each handler coroutine is spawned
+  // by the loop that accepted the connection, so it starts on that loop's
+  // P; with Config::SetNoStealProcs it never leaves it. Returns OK once
+  // every shard was closed, else the first error that stopped a loop.
+  Status Serve(std::function<void(TcpConn)> handler);
+
+  // Closes every shard. Returns the first error.
+  Status Close();
+
+ private:
+  friend Result<ShardedTcpListener> ListenTcpSharded(const class IpAddress&,
+                                                     uint16_t, int, bool,
+                                                     int);
+  explicit ShardedTcpListener(std::vector<TcpListener> shards)
+    : shards_(std::move(shards)) {}
+
+  std::vector<TcpListener> shards_;
+};
+
 // Deprecated alias for backward compatibility. Use TcpListener instead.
 using TCPListener = TcpListener;
 
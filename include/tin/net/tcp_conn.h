@@ -3,8 +3,9 @@
 // found in the LICENSE file.
 //
 // P2-1 PIMPL: TcpConn's implementation (TcpConnImpl) is hidden behind a
-// forward-declared Impl class. Users no longer see NetFD, sys_socket.h,
-// or io::IoReadWriter. All methods are explicit forwarding wrappers.
+// forward-declared Impl class. Users no longer see NetFD or sys_socket.h.
+// TcpConn itself implements the io::Reader/Writer/ReaderFrom interfaces so
+// it plugs into io::Copy. All methods are explicit forwarding wrappers.
 //
 // NOTE: socklen_t is replaced with int in the public API to avoid leaking
 // platform socket headers. The implementation translates int ? socklen_t
@@ -14,8 +15,11 @@
 #define TIN_NET_TCP_CONN_H_
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
 
+#include "tin/io/io.h"
 #include "tin/result.h"
 
 namespace tin::net {
@@ -23,7 +27,7 @@ namespace tin::net {
 // PIMPL: forward-declared implementation. Defined in tcp_conn_impl.h (internal).
 class TcpConnImpl;
 
-class TcpConn {
+class TcpConn : public io::IoReadWriter, public io::ReaderFrom {
  public:
   TcpConn() = default;
   ~TcpConn() = default;
@@ -34,8 +38,43 @@ class TcpConn {
   // On error, the Result's status() carries the error code.
   // If some data was read before an error (e.g. EOF), Ok(n) is returned
   // and the error surfaces on the next call to Read().
-  Result<size_t> Read(void* buf, int nbytes);
-  Result<size_t> Write(const void* buf, int nbytes);
+  Result<size_t> Read(void* buf, int nbytes) override;
+  Result<size_t> Write(const void* buf, int nbytes) override;
+
+  // Vectored Write: writes every buffer, in order, with writev (WSASend on
+  // Windows) and continues across buffers after a partial write. Errors
+  // and the write deadline behave as for Write; the result is the number
+  // of bytes written.
+  Result<size_t> Writev(std::span<const io::ConstBuffer> bufs);
+  // Vectored Read: one readv filling the buffers in order. Returns like
+  // Read.
+  Result<size_t> Readv(std::span<const io::MutableBuffer> bufs);
+
+  // Bytes queued in the socket's receive buffer (FIONREAD): what the next
+  // Read can return without waiting.
+  Result<size_t> Available() const;
+
+  // Sends count bytes (count < 0: up to EOF) of the open file fd starting
+  // at offset, with sendfile(2) where available; the file offset is left
+  // alone. Deadlines behave as for Write. Returns the bytes sent, fewer
+  // than count if the file ended first.
+  Result<size_t> SendFile(int fd, int64_t offset, int64_t count);
+
+  // Large-send path (Linux MSG_ZEROCOPY): the kernel transmits straight
+  // from buf, which must stay unmodified until done runs. done runs inside
+  // a later WriteZeroCopy or WaitZeroCopy on this connection once the
+  // kernel has released buf, or when the connection is destroyed. Where
+  // zerocopy is unavailable this is Write followed by done(). Pays off for
+  // buffers of 64 KiB and up; deadlines behave as for Write.
+  Result<size_t> WriteZeroCopy(const void* buf, int nbytes,
+                               std::function<void()> done);
+  // Blocks, under the write deadline, until every WriteZeroCopy buffer is
+  // released and its done has run.
+  Status WaitZeroCopy();
+
+  // io::ReaderFrom, so io::Copy(&conn, &other_conn) splices (see Splice).
+  // Other readers are copied through a buffer.
+  Result<size_t> ReadFrom(io::Reader* r) override;
 
   // t: absolute deadline in nanoseconds since epoch (0 = no deadline).
   // The deadline applies to both Read and Write operations.
@@ -60,6 +99,11 @@ class TcpConn {
   Status CloseWrite();
   void Close();
 
+  // Returns a close-on-exec duplicate of the socket, owned by the caller,
+  // e.g. to hand the connection to another process with
+  // UnixConn::SendFds (see FileTcpConn). TIN_ENOSYS on Windows.
+  Result<int> File();
+
   int64_t TotalReadBytes() const;
 
   // Returns true if this TcpConn holds a valid connection.
@@ -67,12 +111,19 @@ class TcpConn {
 
  private:
   friend TcpConn MakeTcpConn(std::unique_ptr<class NetFD> netfd);
+  friend Result<size_t> Splice(TcpConn& src, TcpConn& dst);
+  friend bool ProbeIdleTcpConn(const TcpConn& conn);
   explicit TcpConn(std::shared_ptr<TcpConnImpl> impl)
     : impl_(std::move(impl)) {}
 
   std::shared_ptr<TcpConnImpl> impl_;
 };
 
+// Moves everything read from src to dst until EOF on src, through a kernel
+// pipe with splice(2) on Linux (a user-space copy elsewhere). Read and
+// write deadlines of src and dst apply. Returns the number of bytes moved.
+Result<size_t> Splice(TcpConn& src, TcpConn& dst);
+
 }  // namespace tin::net
 
 #endif  // TIN_NET_TCP_CONN_H_
@@ -0,0 +1,110 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: UDP sockets (POSIX only for now). Like TcpConn, UdpConn is a
+// PIMPL handle; copies share the socket. ReadBatch/WriteBatch move many
+// datagrams per system call (recvmmsg/sendmmsg on Linux), and
+// EnableGso/EnableGro let the kernel split and coalesce large sends and
+// receives into MTU-sized datagrams.
+
+#ifndef TIN_NET_UDP_CONN_H_
+#define TIN_NET_UDP_CONN_H_
+
+#include <absl/strings/string_view.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "tin/net/ip_address.h"
+#include "tin/net/ip_endpoint.h"
+#include "tin/result.h"
+
+namespace tin::net {
+
+class UdpConnImpl;
+
+// One datagram of a ReadBatch/WriteBatch.
+struct Datagram {
+  // Read: buffer of size bytes, len receives the payload length.
+  // Write: size bytes of payload; len is ignored.
+  void* data = nullptr;
+  size_t size = 0;
+  size_t len = 0;
+  // Read: with GRO enabled, the length of the datagrams coalesced into
+  // data (the last one may be shorter); 0 if it is a single datagram.
+  // Write: GSO segment size for this message only (0: the socket
+  // default set by EnableGso).
+  size_t segment_size = 0;
+  // Read: the sender. Write: the destination, ignored on a connected
+  // socket.
+  IpEndpoint addr;
+};
+
+class UdpConn {
+ public:
+  UdpConn() = default;
+  ~UdpConn() = default;
+  UdpConn(const UdpConn& other) = default;
+  UdpConn& operator=(const UdpConn& other) = default;
+
+  // Receives one datagram into buf (truncated to nbytes) and its sender.
+  Result<size_t> ReadFrom(void* buf, int nbytes, IpEndpoint* addr);
+  Result<size_t> WriteTo(const void* buf, int nbytes, const IpEndpoint& addr);
+
+  // Connected sockets (DialUdp) only.
+  Result<size_t> Read(void* buf, int nbytes);
+  Result<size_t> Write(const void* buf, int nbytes);
+
+  // Waits for at least one datagram, then takes as many as are queued, up
+  // to msgs.size(). Returns the number of entries filled.
+  Result<int> ReadBatch(std::span<Datagram> msgs);
+  // Sends every entry unless an error or the write deadline stops it.
+  // Returns the number sent; an error is reported only if none was.
+  Result<int> WriteBatch(std::span<const Datagram> msgs);
+
+  // UDP_SEGMENT (Linux 4.18+): every write of more than segment_size
+  // bytes goes out as segment_size datagrams (0 turns it off).
+  Status EnableGso(int segment_size);
+  // UDP_GRO (Linux 5.0+): ReadBatch may return several datagrams from the
+  // same sender coalesced into one entry, see Datagram::segment_size.
+  Status EnableGro(bool enable);
+
+  // t: absolute deadline in nanoseconds since epoch (0 = no deadline).
+  void SetDeadline(int64_t t);
+  void SetReadDeadline(int64_t t);
+  void SetWriteDeadline(int64_t t);
+
+  void SetReadBuffer(int bytes);
+  void SetWriteBuffer(int bytes);
+
+  // The bound address, e.g. to learn the port picked for port 0.
+  Result<IpEndpoint> LocalAddr() const;
+
+  void Close();
+
+  bool IsValid() const { return impl_ != nullptr; }
+
+ private:
+  friend UdpConn MakeUdpConn(std::unique_ptr<class NetFD> netfd);
+  explicit UdpConn(std::shared_ptr<UdpConnImpl> impl)
+    : impl_(std::move(impl)) {}
+
+  std::shared_ptr<UdpConnImpl> impl_;
+};
+
+// Binds an unconnected socket to address:port (port 0 picks one).
+Result<UdpConn> ListenUdp(const IpAddress& address, uint16_t port);
+
+Result<UdpConn> ListenUdp(const absl::string_view& addr, uint16_t port);
+
+// Returns a socket connected to address:port, for Read/Write.
+Result<UdpConn> DialUdp(const IpAddress& address, uint16_t port);
+
+Result<UdpConn> DialUdp(const absl::string_view& addr, uint16_t port);
+
+}  // namespace tin::net
+
+#endif  // TIN_NET_UDP_CONN_H_
@@ -0,0 +1,130 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: Unix domain sockets (POSIX only). UnixConn/UnixListener are
+// PIMPL handles like TcpConn/TcpListener, for stream and seqpacket
+// sockets. SendFds/RecvFds pass descriptors with SCM_RIGHTS; together
+// with TcpConn::File/TcpListener::File and FileTcpConn/FileTcpListener
+// they let a process hand live connections or its listening socket to
+// another one, e.g. for a restart that keeps the listen backlog.
+//
+// A path starting with '@' names a socket in the Linux abstract namespace.
+
+#ifndef TIN_NET_UNIX_CONN_H_
+#define TIN_NET_UNIX_CONN_H_
+
+#include <absl/strings/string_view.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "tin/io/io.h"
+#include "tin/net/listener.h"
+#include "tin/net/tcp_conn.h"
+#include "tin/result.h"
+
+namespace tin::net {
+
+class UnixConnImpl;
+class UnixListenerImpl;
+
+enum class UnixType {
+  kStream,     // SOCK_STREAM
+  kSeqPacket,  // SOCK_SEQPACKET: reliable, ordered, message boundaries kept
+};
+
+class UnixConn : public io::IoReadWriter {
+ public:
+  // At most this many descriptors travel with one message.
+  static const int kMaxFds = 64;
+
+  UnixConn() = default;
+  ~UnixConn() = default;
+  UnixConn(const UnixConn& other) = default;
+  UnixConn& operator=(const UnixConn& other) = default;
+
+  // As TcpConn::Read/Write. On a seqpacket socket each call moves one
+  // message; Read truncates it to nbytes.
+  Result<size_t> Read(void* buf, int nbytes) override;
+  Result<size_t> Write(const void* buf, int nbytes) override;
+  Result<size_t> Writev(std::span<const io::ConstBuffer> bufs);
+
+  // Writes buf (nbytes > 0) with fds attached to its first byte. The
+  // descriptors stay open here; the peer gets duplicates. Unlike Write, an
+  // error after a partial write is returned: the peer may then have
+  // received the descriptors with only a prefix of buf.
+  Result<size_t> SendFds(const void* buf, int nbytes,
+                         std::span<const int> fds);
+  // Reads like Read and appends the descriptors that came with the data
+  // to *fds; the caller owns them. They are close-on-exec.
+  Result<size_t> RecvFds(void* buf, int nbytes, std::vector<int>* fds);
+
+  // t: absolute deadline in nanoseconds since epoch (0 = no deadline).
+  void SetDeadline(int64_t t);
+  void SetReadDeadline(int64_t t);
+  void SetWriteDeadline(int64_t t);
+
+  void SetReadBuffer(int bytes);
+  void SetWriteBuffer(int bytes);
+
+  Status CloseRead();
+  Status CloseWrite();
+  void Close();
+
+  bool IsValid() const { return impl_ != nullptr; }
+
+ private:
+  friend UnixConn MakeUnixConn(std::unique_ptr<class NetFD> netfd);
+  explicit UnixConn(std::shared_ptr<UnixConnImpl> impl)
+    : impl_(std::move(impl)) {}
+
+  std::shared_ptr<UnixConnImpl> impl_;
+};
+
+class UnixListener {
+ public:
+  UnixListener() = default;
+  ~UnixListener() = default;
+  UnixListener(const UnixListener& other) = default;
+  UnixListener& operator=(const UnixListener& other) = default;
+
+  Status SetDeadline(int64_t t);
+  Result<UnixConn> Accept();
+
+  // Closes the socket and removes the socket file ListenUnix created.
+  Status Close();
+
+  // As TcpListener::File.
+  Result<int> File();
+
+  bool IsValid() const { return impl_ != nullptr; }
+
+ private:
+  friend Result<UnixListener> ListenUnix(const absl::string_view&, UnixType,
+                                         int);
+  explicit UnixListener(std::shared_ptr<UnixListenerImpl> impl)
+    : impl_(std::move(impl)) {}
+
+  std::shared_ptr<UnixListenerImpl> impl_;
+};
+
+// Binds path, which must not exist yet, and listens on it.
+Result<UnixListener> ListenUnix(const absl::string_view& path,
+                                UnixType type = UnixType::kStream,
+                                int backlog = 511);
+
+Result<UnixConn> DialUnix(const absl::string_view& path,
+                          UnixType type = UnixType::kStream);
+
+// Adopt a connected or listening TCP socket, e.g. one from RecvFds. They
+// take ownership of fd, also on failure. Other sockets are rejected with
+// TIN_EAFNOSUPPORT (not AF_INET/AF_INET6) or TIN_EPROTOTYPE (not TCP).
+Result<TcpConn> FileTcpConn(int fd);
+Result<TcpListener> FileTcpListener(int fd);
+
+}  // namespace tin::net
+
+#endif  // TIN_NET_UNIX_CONN_H_
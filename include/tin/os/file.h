@@ -0,0 +1,82 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: File, disk file I/O that parks the calling coroutine rather
+// than its thread (POSIX only). With the io_uring netpoller
+// (Config::SetNetPoller(kIoUring)) reads, writes and fsync are io_uring
+// requests, batched with other coroutines' socket and file requests into
+// one submission, and reaped by the scheduler's netpoll;
+// otherwise they run on the blocking-work pool (tin::Blocking). Either
+// way the P keeps running other coroutines and sysmon has nothing to
+// retake. Open runs on the blocking-work pool. Use from coroutines only.
+
+#ifndef TIN_OS_FILE_H_
+#define TIN_OS_FILE_H_
+
+#include <absl/strings/string_view.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "tin/io/io.h"
+#include "tin/result.h"
+
+namespace tin::os {
+
+class FileImpl;
+
+// Open flags; kRead, kWrite or kReadWrite, optionally or'ed with the rest.
+enum OpenFlags : int {
+  kRead = 1,
+  kWrite = 2,
+  kReadWrite = kRead | kWrite,
+  kCreate = 4,
+  kTruncate = 8,
+  kAppend = 16,
+  kExclusive = 32,  // with kCreate: fail if the file exists
+};
+
+class File : public io::IoReadWriter {
+ public:
+  File() = default;
+  ~File() = default;
+  File(const File& other) = default;
+  File& operator=(const File& other) = default;
+
+  // At the file offset, which they advance. Read returns TIN_EOF at the
+  // end of the file; Write writes all of buf or fails.
+  Result<size_t> Read(void* buf, int nbytes) override;
+  Result<size_t> Write(const void* buf, int nbytes) override;
+
+  // At offset, leaving the file offset alone, so several coroutines may
+  // read or write one File at once.
+  Result<size_t> ReadAt(void* buf, int nbytes, int64_t offset);
+  Result<size_t> WriteAt(const void* buf, int nbytes, int64_t offset);
+
+  Status Fsync();
+  Result<int64_t> Size();
+
+  // Not while other calls on the File are in flight.
+  Status Close();
+
+  int Fd() const;
+  bool IsValid() const { return impl_ != nullptr; }
+
+ private:
+  friend Result<File> Open(const absl::string_view& path, int flags,
+                           int mode);
+  explicit File(std::shared_ptr<FileImpl> impl) : impl_(std::move(impl)) {}
+
+  std::shared_ptr<FileImpl> impl_;
+};
+
+// mode: permission bits for a file created by kCreate.
+Result<File> Open(const absl::string_view& path, int flags = kRead,
+                  int mode = 0644);
+
+// Open(path, kReadWrite | kCreate | kTruncate).
+Result<File> Create(const absl::string_view& path);
+
+}  // namespace tin::os
+#endif  // TIN_OS_FILE_H_
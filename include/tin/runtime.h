@@ -9,6 +9,8 @@
 #define TIN_RUNTIME_H_
 
 #include <functional>
+#include <optional>
+#include <type_traits>
 #include <utility>
 
 namespace tin {
@@ -32,6 +34,25 @@ void Spawn(Functor&& functor, Args&&... args) {
 void SpawnClosure(std::function<void()> closure,
                   const SpawnOptions& opts = {});
 
+// Type-erased internal entry point (called by the Blocking template below).
+void BlockingClosure(std::function<void()> closure);
+
+// Runs fn on the blocking-work thread pool and returns its result; an
+// exception thrown by fn is rethrown here. The calling coroutine is parked
+// meanwhile and its P runs other coroutines, so use it for calls that block
+// the thread: file I/O, synchronous third-party SDKs. Coroutines only.
+template <typename Fn>
+std::invoke_result_t<Fn&> Blocking(Fn&& fn) {
+  using R = std::invoke_result_t<Fn&>;
+  if constexpr (std::is_void_v<R>) {
+    BlockingClosure([&fn]() { fn(); });
+  } else {
+    std::optional<R> result;
+    BlockingClosure([&fn, &result]() { result.emplace(fn()); });
+    return std::move(*result);
+  }
+}
+
 // Scheduling and exception helpers.
 void Sched();
 void LockOSThread();
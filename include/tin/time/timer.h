@@ -0,0 +1,97 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Public API: Timer, Ticker and AfterFunc (Go time.Timer / time.Ticker /
+// time.AfterFunc). All of them are backed by the per-P timer heap, so
+// arming and firing never involve an extra thread. Durations are in
+// nanoseconds (see tin/time/time.h for kMillisecond, kSecond, ...).
+//
+// Construction, Reset and Stop must be called from a coroutine.
+
+#ifndef TIN_TIME_TIMER_H_
+#define TIN_TIME_TIMER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "tin/communication/chan.h"
+#include "tin/time/time.h"
+
+namespace tin {
+
+// PIMPL: forward-declared implementation. Defined in tin/time/timer.cc.
+class TimerImpl;
+
+// Timer delivers MonoNow() on C() once, after the given duration.
+// A Timer that fired or was stopped releases its runtime resources on its
+// own; dropping the handle does NOT stop a pending Timer (as in Go).
+class Timer {
+ public:
+  // Fires once, d nanoseconds from now. d <= 0 fires immediately.
+  explicit Timer(int64_t d);
+  ~Timer();
+  Timer(Timer&& other) noexcept;
+  Timer& operator=(Timer&& other) noexcept;
+
+  // Channel (capacity 1) the fire time is delivered on. Never written to
+  // for timers created by AfterFunc.
+  Chan<int64_t> C() const;
+
+  // Prevents the Timer from firing. Returns true if the call stopped the
+  // timer, false if it had already fired or been stopped. Stop does not
+  // drain C(); use C()->TryPop() for that.
+  bool Stop();
+
+  // Re-arms the Timer to fire d nanoseconds from now. Returns true if the
+  // timer had been active.
+  bool Reset(int64_t d);
+
+ private:
+  friend Timer AfterFunc(int64_t d, std::function<void()> fn);
+  explicit Timer(std::shared_ptr<TimerImpl> impl);
+
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+
+  std::shared_ptr<TimerImpl> impl_;
+};
+
+// Ticker delivers MonoNow() on C() every period. Ticks are dropped, not
+// queued, when the reader falls behind (C() has capacity 1). Unlike Timer,
+// a Ticker never stops by itself, so the destructor stops it.
+class Ticker {
+ public:
+  // d must be positive.
+  explicit Ticker(int64_t d);
+  ~Ticker();
+  Ticker(Ticker&& other) noexcept;
+  Ticker& operator=(Ticker&& other) noexcept;
+
+  Chan<int64_t> C() const;
+
+  // Turns off the ticker. No more ticks are sent after Stop returns,
+  // except for one that may already be in flight.
+  void Stop();
+
+  // Stops the ticker and restarts it with period d (must be positive).
+  void Reset(int64_t d);
+
+ private:
+  Ticker(const Ticker&) = delete;
+  Ticker& operator=(const Ticker&) = delete;
+
+  std::shared_ptr<TimerImpl> impl_;
+};
+
+// AfterFunc runs fn in a new coroutine after d nanoseconds. The returned
+// Timer can be used to Stop or Reset it; it may also be discarded.
+Timer AfterFunc(int64_t d, std::function<void()> fn);
+
+// After is shorthand for Timer(d).C().
+Chan<int64_t> After(int64_t d);
+
+}  // namespace tin
+
+#endif  // TIN_TIME_TIMER_H_
@@ -0,0 +1,80 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Unit tests for the I/O buffer pool. They run off the runtime, where
+// every call goes to the global depot.
+
+#include "test.h"
+#include "tin/io/buffer_pool.h"
+
+#include <cstring>
+#include <utility>
+
+#include <absl/log/check.h>
+
+TEST(BufferPool, SizeClasses) {
+  size_t capacity = 0;
+  // Below the smallest class: a plain allocation the pool never holds.
+  uint64_t allocs = tin::io::GetBufferPoolStats().allocs;
+  void* small = tin::io::AllocBuffer(32, &capacity);
+  CHECK_EQ(capacity, 32u);
+  tin::io::FreeBuffer(small, capacity);
+  CHECK_EQ(tin::io::GetBufferPoolStats().allocs, allocs);
+  CHECK_EQ(tin::io::GetBufferPoolStats().depot_bytes, 0u);
+
+  void* smallest = tin::io::AllocBuffer(tin::io::kMinPooledBufferSize - 1,
+                                        &capacity);
+  CHECK_EQ(capacity, tin::io::kMinPooledBufferSize - 1);
+  tin::io::FreeBuffer(smallest, capacity);
+
+  void* first = tin::io::AllocBuffer(tin::io::kMinPooledBufferSize,
+                                     &capacity);
+  CHECK_EQ(capacity, tin::io::kMinPooledBufferSize);
+  tin::io::FreeBuffer(first, capacity);
+
+  void* mid = tin::io::AllocBuffer(3000, &capacity);
+  CHECK_EQ(capacity, 4096u);
+  std::memset(mid, 0xab, capacity);
+  tin::io::FreeBuffer(mid, capacity);
+
+  size_t huge = tin::io::kMaxPooledBufferSize + 1;
+  void* big = tin::io::AllocBuffer(huge, &capacity);
+  CHECK_EQ(capacity, huge);
+  tin::io::FreeBuffer(big, huge);
+  tin::io::TrimBufferPool();
+}
+
+TEST(BufferPool, Reuse) {
+  tin::io::TrimBufferPool();
+  void* first = tin::io::AllocBuffer(8192);
+  tin::io::FreeBuffer(first, 8192);
+  CHECK_EQ(tin::io::GetBufferPoolStats().depot_bytes, 8192u);
+
+  uint64_t hits = tin::io::GetBufferPoolStats().depot_hits;
+  // Same class, so the freed buffer comes back.
+  void* second = tin::io::AllocBuffer(5000);
+  CHECK(second == first);
+  CHECK_EQ(tin::io::GetBufferPoolStats().depot_hits, hits + 1);
+  CHECK_EQ(tin::io::GetBufferPoolStats().depot_bytes, 0u);
+  tin::io::FreeBuffer(second, 5000);
+
+  tin::io::TrimBufferPool();
+  CHECK_EQ(tin::io::GetBufferPoolStats().depot_bytes, 0u);
+}
+
+TEST(BufferPool, PooledBuffer) {
+  tin::io::TrimBufferPool();
+  tin::io::PooledBuffer a(2048);
+  CHECK(a.data() != nullptr);
+  CHECK_EQ(a.size(), 2048u);
+  char* data = a.data();
+
+  tin::io::PooledBuffer b(std::move(a));
+  CHECK(a.data() == nullptr);
+  CHECK(b.data() == data);
+  b.reset();
+  CHECK(b.data() == nullptr);
+  CHECK_EQ(tin::io::GetBufferPoolStats().depot_bytes, 2048u);
+  tin::io::TrimBufferPool();
+}
@@ -0,0 +1,189 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Unit tests for tin::bufio. They run on plain threads against in-memory
+// readers and writers, so nothing here needs the runtime.
+
+#include "test.h"
+#include "test_io.h"
+#include "tin/bufio/bufio.h"
+#include "tin/bufio/scan.h"
+#include "tin/error/error.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/log/check.h>
+
+namespace {
+
+// Records every Write call; fails once limit bytes have gone through.
+class RecordingWriter : public tin::io::Writer {
+ public:
+  explicit RecordingWriter(size_t limit = ~size_t(0)) : limit_(limit) {}
+
+  tin::Result<size_t> Write(const void* buf, int nbytes) override {
+    size_t n = std::min(static_cast<size_t>(nbytes), limit_ - data.size());
+    data.append(static_cast<const char*>(buf), n);
+    calls.push_back(static_cast<int>(n));
+    if (n < static_cast<size_t>(nbytes)) {
+      return tin::Result<size_t>::Err(TIN_EPIPE);
+    }
+    return tin::Result<size_t>::Ok(n);
+  }
+
+  std::string data;
+  std::vector<int> calls;
+
+ private:
+  size_t limit_;
+};
+
+}  // namespace
+
+TEST(BufioScan, MatchesScalar) {
+  const char* sets[] = {"\n", "\r\n", "\r\n\t ", ",;:=|"};
+  std::string text(200, 'a');
+  const uint8_t* base = reinterpret_cast<const uint8_t*>(text.data());
+  for (const char* set : sets) {
+    // Every hit position and every start offset, across vector widths.
+    for (size_t hit = 0; hit < 80; ++hit) {
+      text.assign(200, 'a');
+      text[hit] = set[hit % strlen(set)];
+      for (size_t from = 0; from < 40; ++from) {
+        const uint8_t* end = base + 100;
+        CHECK(tin::bufio::ScanAny(base + from, end, set) ==
+              tin::bufio::ScanAnyScalar(base + from, end, set));
+      }
+    }
+  }
+  CHECK(tin::bufio::ScanByte(base, base, 'a') == base);
+}
+
+TEST(BufioReader, ReadSliceAcrossFills) {
+  ChunkReader src("first line\nsecond\nlast", 3);
+  tin::bufio::Reader r(&src, 16);
+  absl::string_view line;
+  CHECK(r.ReadSlice('\n', &line).ok());
+  CHECK_EQ(line, "first line\n");
+  CHECK(r.ReadSlice('\n', &line).ok());
+  CHECK_EQ(line, "second\n");
+  CHECK_EQ(r.ReadSlice('\n', &line).code(), TIN_EOF);
+  CHECK_EQ(line, "last");
+}
+
+TEST(BufioReader, ReadSliceBufferFull) {
+  ChunkReader src("0123456789abcdefXYZ\n", 5);
+  tin::bufio::Reader r(&src, 16);
+  absl::string_view line;
+  CHECK_EQ(r.ReadSlice('\n', &line).code(), TIN_EBUFFERFULL);
+  CHECK_EQ(line, "0123456789abcdef");
+  CHECK(r.ReadSlice('\n', &line).ok());
+  CHECK_EQ(line, "XYZ\n");
+}
+
+TEST(BufioReader, ReadSliceAny) {
+  ChunkReader src("GET / HTTP/1.1\r\nHost: a\r\n", 4);
+  tin::bufio::Reader r(&src, 64);
+  absl::string_view field;
+  CHECK(r.ReadSliceAny(" \r", &field).ok());
+  CHECK_EQ(field, "GET ");
+  CHECK(r.ReadSliceAny(" \r", &field).ok());
+  CHECK_EQ(field, "/ ");
+  CHECK(r.ReadSliceAny(" \r", &field).ok());
+  CHECK_EQ(field, "HTTP/1.1\r");
+  CHECK_EQ(r.ReadSliceAny("", &field).code(), TIN_EINVAL);
+}
+
+TEST(BufioReader, ReadLine) {
+  ChunkReader src("crlf\r\nlf\nend", 2);
+  tin::bufio::Reader r(&src, 16);
+  absl::string_view line;
+  bool is_prefix = true;
+  CHECK(r.ReadLine(&line, &is_prefix).ok());
+  CHECK_EQ(line, "crlf");
+  CHECK(!is_prefix);
+  CHECK(r.ReadLine(&line, &is_prefix).ok());
+  CHECK_EQ(line, "lf");
+  CHECK(r.ReadLine(&line, &is_prefix).ok());
+  CHECK_EQ(line, "end");
+}
+
+TEST(BufioReader, AdaptiveSize) {
+  std::string data;
+  for (int i = 0; i < 20000; ++i) {
+    data += static_cast<char>('a' + i % 26);
+  }
+  ChunkReader src(data, data.size());
+  tin::bufio::Reader r(&src, 512);
+  r.SetMaxBufferSize(4096);
+  std::string got;
+  char out[100];
+  // Bulk: every read fills the buffer, so it doubles up to the cap.
+  while (got.size() < 10000) {
+    got.append(out, *r.Read(out, sizeof(out)));
+  }
+  CHECK_EQ(r.size(), 4096);
+
+  // Trickle: short reads shrink it back.
+  src.set_chunk(10);
+  tin::Result<size_t> n = r.Read(out, sizeof(out));
+  while (n.ok()) {
+    got.append(out, *n);
+    n = r.Read(out, sizeof(out));
+  }
+  CHECK_EQ(n.code(), TIN_EOF);
+  CHECK_EQ(got, data);
+  CHECK_EQ(r.size(), 512);
+}
+
+TEST(BufioWriter, CoalescesSmallWrites) {
+  RecordingWriter sink;
+  tin::bufio::Writer w(&sink, 16);
+  CHECK(w.WriteString("hello ").ok());
+  CHECK(w.WriteByte('w').ok());
+  CHECK(w.WriteString("orld").ok());
+  CHECK(sink.calls.empty());
+  CHECK_EQ(w.buffered(), 11);
+  CHECK_EQ(w.available(), 5);
+  CHECK(w.Flush().ok());
+  CHECK_EQ(sink.calls.size(), 1u);
+  CHECK_EQ(sink.data, "hello world");
+  CHECK_EQ(w.buffered(), 0);
+}
+
+TEST(BufioWriter, LargeWriteBypassesBuffer) {
+  RecordingWriter sink;
+  tin::bufio::Writer w(&sink, 8);
+  std::string big(20, 'x');
+  CHECK_EQ(*w.WriteString(big), big.size());
+  CHECK_EQ(sink.calls.size(), 1u);
+  CHECK_EQ(sink.calls[0], 20);
+  CHECK_EQ(w.buffered(), 0);
+
+  // Buffered bytes go out first, then the rest is buffered again.
+  CHECK(w.WriteString("abc").ok());
+  CHECK(w.WriteString("defghij").ok());
+  CHECK_EQ(sink.data, big + "abcdefgh");
+  CHECK_EQ(w.buffered(), 2);
+}
+
+TEST(BufioWriter, ErrorIsSticky) {
+  RecordingWriter sink(4);
+  tin::bufio::Writer w(&sink, 8);
+  CHECK(w.WriteString("abcdef").ok());
+  CHECK_EQ(w.Flush().code(), TIN_EPIPE);
+  CHECK_EQ(sink.data, "abcd");
+  CHECK_EQ(w.WriteByte('g').code(), TIN_EPIPE);
+  CHECK_EQ(w.Flush().code(), TIN_EPIPE);
+
+  RecordingWriter fresh;
+  w.Reset(&fresh);
+  CHECK(w.WriteString("ok").ok());
+  CHECK(w.Flush().ok());
+  CHECK_EQ(fresh.data, "ok");
+}
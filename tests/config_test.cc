@@ -44,6 +44,29 @@ TEST(Config, MaxMachines) {
   CHECK_EQ(c.MaxOSMachines(), 8);
 }
 
+TEST(Config, NetPoller) {
+  tin::Config c;
+  CHECK(c.GetNetPoller() == tin::NetPoller::kDefault);
+  c.SetNetPoller(tin::NetPoller::kIoUring);
+  CHECK(c.GetNetPoller() == tin::NetPoller::kIoUring);
+}
+
+TEST(Config, NetPollSharding) {
+  tin::Config c;
+  CHECK(!c.IsNetPollShardingEnabled());
+  c.EnableNetPollSharding(true);
+  CHECK(c.IsNetPollShardingEnabled());
+  c.EnableNetPollSharding(false);
+  CHECK(!c.IsNetPollShardingEnabled());
+}
+
+TEST(Config, NoStealProcs) {
+  tin::Config c;
+  CHECK_EQ(c.NoStealProcs(), 0);
+  c.SetNoStealProcs(4);
+  CHECK_EQ(c.NoStealProcs(), 4);
+}
+
 TEST(ConfigDefaults, DefaultStackSize) {
   CHECK_EQ(tin::kDefaultStackSize, 64 * 1024);
 }
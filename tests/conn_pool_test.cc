@@ -0,0 +1,190 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Tests for tin::net::ConnPool against a listener on 127.0.0.1: reuse of
+// idle connections, the max_active handoff to a waiting Get, the Get
+// timeout, and the idle reaper.
+
+#include "test.h"
+#include "tin/communication/chan.h"
+#include "tin/error/error.h"
+#include "tin/net/conn_pool.h"
+#include "tin/net/tcp.h"
+#include "tin/runtime.h"
+#include "tin/time.h"
+#include "tin/tin.h"
+
+#include <absl/log/check.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace {
+
+using tin::net::ConnPool;
+using tin::net::ConnPoolOptions;
+using tin::net::PooledConn;
+
+// Accepts connections and reads each one until it ends, counting both.
+struct Server {
+  Server() : accepted(0), closed(16) {}
+  tin::net::TcpListener listener;
+  tin::net::IpEndpoint endpoint;
+  std::atomic<int> accepted;
+  tin::Chan<int> closed;  // 1 per connection the pool closed
+};
+
+void Drain(std::shared_ptr<Server> server, tin::net::TcpConn conn) {
+  // Nothing here should take long; fail rather than hang.
+  conn.SetReadDeadline(tin::Now() + 5 * tin::kSecond);
+  char buf[64];
+  tin::Result<size_t> n = conn.Read(buf, sizeof(buf));
+  CHECK(!n.ok() && n.code() == TIN_EOF);
+  conn.Close();
+  server->closed->TryPush(1);
+}
+
+void Serve(std::shared_ptr<Server> server) {
+  for (;;) {
+    tin::Result<tin::net::TcpConn> conn = server->listener.Accept();
+    if (!conn.ok()) {
+      return;
+    }
+    server->accepted++;
+    tin::Spawn(Drain, server, *conn);
+  }
+}
+
+std::shared_ptr<Server> StartServer() {
+  auto server = std::make_shared<Server>();
+  tin::Result<tin::net::TcpListener> listener =
+      tin::net::ListenTcp("127.0.0.1", 0);
+  CHECK(listener.ok());
+  server->listener = *listener;
+  tin::Result<int> fd = listener->File();
+  CHECK(fd.ok());
+  sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  CHECK_EQ(getsockname(*fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  close(*fd);
+  server->endpoint = tin::net::IpEndpoint(tin::net::IpAddress(127, 0, 0, 1),
+                                          ntohs(addr.sin_port));
+  tin::Spawn(Serve, server);
+  return server;
+}
+
+PooledConn MustGet(ConnPool* pool, const Server& server) {
+  tin::Result<PooledConn> conn = pool->Get(server.endpoint, tin::kSecond);
+  CHECK(conn.ok());
+  return std::move(*conn);
+}
+
+}  // namespace
+
+TEST(ConnPool, ReusesIdle) {
+  std::shared_ptr<Server> server = StartServer();
+  {
+    ConnPool pool;
+    PooledConn conn = MustGet(&pool, *server);
+    conn.Release();
+    conn = MustGet(&pool, *server);
+    CHECK_EQ(server->accepted.load(), 1);
+    // A discarded connection is closed, not kept.
+    conn.Discard();
+    int v = 0;
+    server->closed->Pop(&v);
+    conn = MustGet(&pool, *server);
+    CHECK_EQ(server->accepted.load(), 2);
+  }
+  server->listener.Close();
+}
+
+// With max_active 1, a second Get waits for the first connection. A
+// Release hands the connection itself over; a Discard, or a Release
+// after the caller took the connection out, hands over the slot and the
+// waiter dials.
+TEST(ConnPool, WaiterHandoff) {
+  std::shared_ptr<Server> server = StartServer();
+  {
+    ConnPoolOptions options;
+    options.max_active = 1;
+    ConnPool pool(options);
+    PooledConn held = MustGet(&pool, *server);
+    enum { kRelease, kDiscard, kTakeOut };
+    const int want_accepted[] = {1, 2, 3};
+    for (int mode : {kRelease, kDiscard, kTakeOut}) {
+      tin::Chan<int> done(1);
+      tin::Spawn([&pool, server, done]() mutable {
+        PooledConn conn = MustGet(&pool, *server);
+        conn.Release();
+        done->Push(1);
+      });
+      // Let the waiter queue up behind held.
+      tin::Sleep(20);
+      int v = 0;
+      CHECK(!done->TryPop(&v));
+      if (mode == kRelease) {
+        held.Release();
+      } else if (mode == kDiscard) {
+        held.Discard();
+      } else {
+        tin::net::TcpConn taken = held.conn();
+        held.conn() = tin::net::TcpConn();
+        held.Release();
+        taken.Close();
+      }
+      done->Pop(&v);
+      CHECK_EQ(server->accepted.load(), want_accepted[mode]);
+      // The waiter returned its connection; it is idle again.
+      held = MustGet(&pool, *server);
+      CHECK_EQ(server->accepted.load(), want_accepted[mode]);
+    }
+  }
+  server->listener.Close();
+}
+
+TEST(ConnPool, GetTimeout) {
+  std::shared_ptr<Server> server = StartServer();
+  {
+    ConnPoolOptions options;
+    options.max_active = 1;
+    ConnPool pool(options);
+    PooledConn held = MustGet(&pool, *server);
+    int64_t start = tin::MonoNow();
+    tin::Result<PooledConn> conn =
+        pool.Get(server->endpoint, 50 * tin::kMillisecond);
+    CHECK_EQ(conn.code(), TIN_ETIMEDOUT);
+    CHECK_GE(tin::MonoNow() - start, 50 * tin::kMillisecond);
+    // The timed-out waiter left the queue: the slot goes straight to the
+    // next Get once held is back.
+    held.Release();
+    held = MustGet(&pool, *server);
+    CHECK_EQ(server->accepted.load(), 1);
+  }
+  server->listener.Close();
+}
+
+TEST(ConnPool, ReapsIdle) {
+  std::shared_ptr<Server> server = StartServer();
+  {
+    ConnPoolOptions options;
+    options.idle_timeout = 100 * tin::kMillisecond;
+    ConnPool pool(options);
+    PooledConn conn = MustGet(&pool, *server);
+    int64_t idle_since = tin::MonoNow();
+    conn.Release();
+    int v = 0;
+    server->closed->Pop(&v);
+    CHECK_GE(tin::MonoNow() - idle_since, options.idle_timeout);
+    conn = MustGet(&pool, *server);
+    CHECK_EQ(server->accepted.load(), 2);
+  }
+  server->listener.Close();
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Tests for DialTcpParallel (Happy Eyeballs) on loopback. A listener
+// whose accept queue is full stands in for an unreachable address: its
+// SYNs are dropped, so a connect to it stays in progress.
+
+#include "build/build_config.h"
+#include "test.h"
+#include "tin/communication/chan.h"
+#include "tin/error/error.h"
+#include "tin/net/dialer.h"
+#include "tin/net/tcp.h"
+#include "tin/runtime.h"
+#include "tin/time.h"
+#include "tin/tin.h"
+
+#include <absl/log/check.h>
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using tin::net::IpAddress;
+
+uint16_t ListenerPort(tin::net::TcpListener* listener) {
+  tin::Result<int> fd = listener->File();
+  CHECK(fd.ok());
+  sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  CHECK_EQ(getsockname(*fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  close(*fd);
+  return ntohs(addr.sin_port);
+}
+
+std::string PeerAddress(tin::net::TcpConn* conn) {
+  tin::Result<int> fd = conn->File();
+  CHECK(fd.ok());
+  sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  CHECK_EQ(getpeername(*fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  close(*fd);
+  char buf[INET_ADDRSTRLEN];
+  return inet_ntop(AF_INET, &addr.sin_addr, buf, sizeof(buf));
+}
+
+int OpenFds() {
+#if defined(OS_LINUX)
+  int n = 0;
+  DIR* dir = opendir("/proc/self/fd");
+  CHECK(dir != nullptr);
+  while (readdir(dir) != nullptr) {
+    n++;
+  }
+  closedir(dir);
+  return n;
+#else
+  return 0;
+#endif
+}
+
+// Accepts one connection and closes it.
+void AcceptOne(tin::net::TcpListener listener, tin::Chan<int> done) {
+  tin::Result<tin::net::TcpConn> conn = listener.Accept();
+  CHECK(conn.ok());
+  conn->Close();
+  done->Push(1);
+}
+
+}  // namespace
+
+// The first address never answers, so the second is tried after the
+// fallback delay and wins; the first attempt is still connecting when
+// the race ends and has to be cancelled.
+TEST(DialTcpParallel, FallbackPastStuckAddress) {
+  tin::Result<tin::net::TcpListener> stuck =
+      tin::net::ListenTcp("127.0.0.1", 0, 0);
+  CHECK(stuck.ok());
+  uint16_t port = ListenerPort(&*stuck);
+  // Fills the accept queue; SYNs past it are dropped.
+  tin::Result<tin::net::TcpConn> filler = tin::net::DialTcp("127.0.0.1", port);
+  CHECK(filler.ok());
+  tin::Result<tin::net::TcpListener> good =
+      tin::net::ListenTcp("127.0.0.2", port);
+  CHECK(good.ok());
+  tin::Chan<int> accepted(1);
+  tin::Spawn(AcceptOne, *good, accepted);
+  int fds = OpenFds();
+
+  std::vector<IpAddress> addresses = {IpAddress(127, 0, 0, 1),
+                                      IpAddress(127, 0, 0, 2)};
+  int64_t start = tin::MonoNow();
+  tin::Result<tin::net::TcpConn> conn =
+      tin::net::DialTcpParallel(addresses, port, 5 * tin::kSecond);
+  int64_t elapsed = tin::MonoNow() - start;
+  CHECK(conn.ok());
+  CHECK_EQ(PeerAddress(&*conn), "127.0.0.2");
+  CHECK_GE(elapsed, tin::net::kDefaultFallbackDelay);
+  CHECK_LT(elapsed, 2 * tin::kSecond);
+  int v = 0;
+  accepted->Pop(&v);
+  conn->Close();
+
+  // The losing attempt lets go of its socket once cancelled, well before
+  // the dial timeout would have ended it.
+  tin::Sleep(100);
+  CHECK_EQ(OpenFds(), fds);
+
+  filler->Close();
+  stuck->Close();
+  good->Close();
+}
+
+// A refused attempt starts the next one at once, without waiting out the
+// fallback delay.
+TEST(DialTcpParallel, RefusedStartsNextAtOnce) {
+  tin::Result<tin::net::TcpListener> good =
+      tin::net::ListenTcp("127.0.0.2", 0);
+  CHECK(good.ok());
+  uint16_t port = ListenerPort(&*good);
+  tin::Chan<int> accepted(1);
+  tin::Spawn(AcceptOne, *good, accepted);
+
+  std::vector<IpAddress> addresses = {IpAddress(127, 0, 0, 1),
+                                      IpAddress(127, 0, 0, 2)};
+  int64_t start = tin::MonoNow();
+  tin::Result<tin::net::TcpConn> conn =
+      tin::net::DialTcpParallel(addresses, port, 5 * tin::kSecond);
+  CHECK(conn.ok());
+  CHECK_LT(tin::MonoNow() - start, tin::net::kDefaultFallbackDelay);
+  CHECK_EQ(PeerAddress(&*conn), "127.0.0.2");
+  int v = 0;
+  accepted->Pop(&v);
+  conn->Close();
+  good->Close();
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Tests for the DNS cache. Lookups go to a fake that answers from a fixed
+// table, counts its calls and can be made slow, so expiry, negative
+// caching, coalescing and background refreshes are observable.
+
+#include "test.h"
+#include "tin/error/error.h"
+#include "tin/net/dns_cache.h"
+#include "tin/net/dns_cache_impl.h"
+#include "tin/runtime.h"
+#include "tin/sync/wait_group.h"
+#include "tin/time.h"
+#include "tin/tin.h"
+
+#include <absl/log/check.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using tin::net::ADDRESS_FAMILY_IPV4;
+using tin::net::DnsCacheOptions;
+using tin::net::DnsCacheStats;
+using tin::net::IpAddress;
+
+std::atomic<int> g_calls(0);
+std::atomic<int> g_delay_ms(0);
+// Last octet of the address www.test resolves to.
+std::atomic<int> g_octet(1);
+
+tin::Status FakeLookup(const absl::string_view& hostname,
+                       tin::net::AddressFamily af,
+                       std::vector<IpAddress>* addresses) {
+  g_calls++;
+  if (g_delay_ms.load() > 0) {
+    tin::Sleep(g_delay_ms.load());
+  }
+  addresses->clear();
+  if (hostname == "www.test") {
+    addresses->push_back(
+        IpAddress(192, 0, 2, static_cast<uint8_t>(g_octet.load())));
+    return tin::Status::OK();
+  }
+  if (hostname == "nodata.test") {
+    return tin::Status::FromErrno(TIN_EAI_NODATA);
+  }
+  if (hostname == "flaky.test") {
+    return tin::Status::FromErrno(TIN_EAI_AGAIN);
+  }
+  return tin::Status::FromErrno(TIN_EAI_NONAME);
+}
+
+// Points the cache at FakeLookup with the given lifetimes for the life of
+// a test.
+class FakeDns {
+ public:
+  explicit FakeDns(const DnsCacheOptions& options) {
+    g_calls = 0;
+    g_delay_ms = 0;
+    g_octet = 1;
+    tin::net::ClearDnsCache();
+    tin::net::SetDnsCacheOptions(options);
+    previous_ = tin::net::SetDnsCacheLookup(FakeLookup);
+  }
+
+  ~FakeDns() {
+    tin::net::SetDnsCacheLookup(previous_);
+    tin::net::SetDnsCacheOptions(DnsCacheOptions());
+    tin::net::ClearDnsCache();
+  }
+
+ private:
+  tin::net::DnsLookupFn previous_;
+};
+
+int Lookup(const char* hostname, std::vector<IpAddress>* addresses) {
+  return tin::net::ResolveHostnameCached(hostname, ADDRESS_FAMILY_IPV4,
+                                         addresses).code();
+}
+
+}  // namespace
+
+TEST(DnsCache, TtlExpiry) {
+  DnsCacheOptions options;
+  options.ttl = 100 * tin::kMillisecond;
+  options.stale_ttl = 0;
+  FakeDns dns(options);
+  std::vector<IpAddress> addresses;
+
+  DnsCacheStats before = tin::net::GetDnsCacheStats();
+  CHECK_EQ(Lookup("www.test", &addresses), 0);
+  CHECK_EQ(Lookup("www.test", &addresses), 0);
+  CHECK_EQ(addresses.size(), 1u);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 1));
+  CHECK_EQ(g_calls.load(), 1);
+  CHECK_EQ(tin::net::GetDnsCacheStats().hits - before.hits, 1);
+
+  // Past the TTL, with no stale window, the next lookup resolves again.
+  g_octet = 2;
+  tin::Sleep(150);
+  CHECK_EQ(Lookup("www.test", &addresses), 0);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 2));
+  CHECK_EQ(g_calls.load(), 2);
+}
+
+TEST(DnsCache, NegativeAnswers) {
+  DnsCacheOptions options;
+  options.negative_ttl = 100 * tin::kMillisecond;
+  FakeDns dns(options);
+  std::vector<IpAddress> addresses;
+
+  CHECK_EQ(Lookup("missing.test", &addresses), TIN_EAI_NONAME);
+  CHECK_EQ(Lookup("missing.test", &addresses), TIN_EAI_NONAME);
+  CHECK(addresses.empty());
+  CHECK_EQ(g_calls.load(), 1);
+  CHECK_EQ(Lookup("nodata.test", &addresses), TIN_EAI_NODATA);
+  CHECK_EQ(Lookup("nodata.test", &addresses), TIN_EAI_NODATA);
+  CHECK_EQ(g_calls.load(), 2);
+
+  // Transient failures are not cached.
+  CHECK_EQ(Lookup("flaky.test", &addresses), TIN_EAI_AGAIN);
+  CHECK_EQ(Lookup("flaky.test", &addresses), TIN_EAI_AGAIN);
+  CHECK_EQ(g_calls.load(), 4);
+
+  // Negative answers expire after negative_ttl.
+  tin::Sleep(150);
+  CHECK_EQ(Lookup("missing.test", &addresses), TIN_EAI_NONAME);
+  CHECK_EQ(g_calls.load(), 5);
+}
+
+// Lookups that miss while one resolves wait for its answer.
+TEST(DnsCache, Singleflight) {
+  DnsCacheOptions options;
+  FakeDns dns(options);
+  g_delay_ms = 50;
+  DnsCacheStats before = tin::net::GetDnsCacheStats();
+
+  const int kLookups = 20;
+  std::atomic<int> resolved(0);
+  tin::WaitGroup wg;
+  wg.Add(kLookups);
+  for (int i = 0; i < kLookups; ++i) {
+    tin::Spawn([&]() {
+      std::vector<IpAddress> out;
+      if (Lookup("www.test", &out) == 0 && out.size() == 1) {
+        resolved++;
+      }
+      wg.Done();
+    });
+  }
+  wg.Wait();
+  CHECK_EQ(resolved.load(), kLookups);
+  CHECK_EQ(g_calls.load(), 1);
+  DnsCacheStats after = tin::net::GetDnsCacheStats();
+  CHECK_EQ(after.misses - before.misses, 1);
+  CHECK_EQ(after.coalesced - before.coalesced, kLookups - 1);
+}
+
+// An expired answer is still served within stale_ttl while one
+// background lookup refreshes it.
+TEST(DnsCache, StaleWhileRefresh) {
+  DnsCacheOptions options;
+  options.ttl = 50 * tin::kMillisecond;
+  options.stale_ttl = 10 * tin::kSecond;
+  FakeDns dns(options);
+  std::vector<IpAddress> addresses;
+
+  CHECK_EQ(Lookup("www.test", &addresses), 0);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 1));
+  tin::Sleep(80);
+
+  g_octet = 2;
+  g_delay_ms = 100;
+  DnsCacheStats before = tin::net::GetDnsCacheStats();
+  int64_t start = tin::MonoNow();
+  CHECK_EQ(Lookup("www.test", &addresses), 0);
+  CHECK_EQ(Lookup("www.test", &addresses), 0);
+  // Served at once from the stale entry, not after the slow lookup.
+  CHECK_LT(tin::MonoNow() - start, 100 * tin::kMillisecond);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 1));
+  DnsCacheStats after = tin::net::GetDnsCacheStats();
+  CHECK_EQ(after.stale_hits - before.stale_hits, 2);
+  CHECK_EQ(after.refreshes - before.refreshes, 1);
+
+  // Once the refresh lands, the new answer is fresh. The longer TTL
+  // applies to it and keeps it from going stale before the check.
+  options.ttl = 10 * tin::kSecond;
+  tin::net::SetDnsCacheOptions(options);
+  tin::Sleep(200);
+  CHECK_EQ(Lookup("www.test", &addresses), 0);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 2));
+  CHECK_EQ(g_calls.load(), 2);
+}
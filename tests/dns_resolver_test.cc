@@ -0,0 +1,239 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Unit tests for tin::net::DnsResolver. The lookups run inside the tin
+// runtime against a fake DNS server on 127.0.0.1 that answers over UDP
+// and, for truncated answers, over TCP.
+
+#include "test.h"
+#include "tin/error/error.h"
+#include "tin/io/io.h"
+#include "tin/net/dialer.h"
+#include "tin/net/dns_resolver.h"
+#include "tin/net/udp_conn.h"
+#include "tin/runtime.h"
+#include "tin/sync/wait_group.h"
+#include "tin/tin.h"
+
+#include <absl/log/check.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+using tin::net::ADDRESS_FAMILY_IPV4;
+using tin::net::ADDRESS_FAMILY_IPV6;
+using tin::net::ADDRESS_FAMILY_UNSPECIFIED;
+using tin::net::IpAddress;
+
+void Put16(std::string* out, uint16_t v) {
+  out->push_back(static_cast<char>(v >> 8));
+  out->push_back(static_cast<char>(v & 0xff));
+}
+
+std::string Rdata(const char* literal) {
+  IpAddress address;
+  CHECK(address.AssignFromIPLiteral(literal));
+  return std::string(address.bytes().begin(), address.bytes().end());
+}
+
+// Answers query from a small fixed zone. With udp set, big.example.test
+// gets an empty truncated answer so the client has to retry over TCP.
+std::string FakeAnswer(const std::string& query, bool udp) {
+  size_t off = 12;
+  std::string name;
+  while (off < query.size() && query[off] != 0) {
+    size_t n = static_cast<uint8_t>(query[off]);
+    if (!name.empty()) {
+      name += '.';
+    }
+    name.append(query, off + 1, n);
+    off += 1 + n;
+  }
+  uint16_t qtype = static_cast<uint16_t>(
+      (static_cast<uint8_t>(query[off + 1]) << 8) |
+      static_cast<uint8_t>(query[off + 2]));
+  size_t question_end = off + 5;
+
+  std::vector<std::string> rdata;
+  bool exists = true;
+  bool truncated = false;
+  if (name == "www.example.test") {
+    rdata.push_back(Rdata(qtype == 1 ? "192.0.2.1" : "2001:db8::1"));
+  } else if (name == "big.example.test") {
+    if (udp) {
+      truncated = true;
+    } else if (qtype == 1) {
+      rdata.push_back(Rdata("192.0.2.7"));
+    }
+  } else if (name == "host.corp.test") {
+    if (qtype == 1) {
+      rdata.push_back(Rdata("192.0.2.9"));
+    }
+  } else {
+    exists = false;
+  }
+
+  std::string reply(query, 0, 2);
+  Put16(&reply, static_cast<uint16_t>(0x8180 | (truncated ? 0x0200 : 0) |
+                                      (exists ? 0 : 3)));
+  Put16(&reply, 1);
+  Put16(&reply, static_cast<uint16_t>(rdata.size()));
+  Put16(&reply, 0);
+  Put16(&reply, 0);
+  reply.append(query, 12, question_end - 12);
+  for (const std::string& rr : rdata) {
+    Put16(&reply, 0xc00c);
+    Put16(&reply, qtype);
+    Put16(&reply, 1);
+    Put16(&reply, 0);
+    Put16(&reply, 60);
+    Put16(&reply, static_cast<uint16_t>(rr.size()));
+    reply += rr;
+  }
+  return reply;
+}
+
+void ServeUdp(tin::net::UdpConn conn) {
+  char buf[1500];
+  tin::net::IpEndpoint from;
+  for (;;) {
+    tin::Result<size_t> n = conn.ReadFrom(buf, sizeof(buf), &from);
+    if (!n.ok()) {
+      return;
+    }
+    std::string reply = FakeAnswer(std::string(buf, *n), true);
+    conn.WriteTo(reply.data(), static_cast<int>(reply.size()), from);
+  }
+}
+
+void ServeTcp(tin::net::TcpListener listener) {
+  for (;;) {
+    tin::Result<tin::net::TcpConn> conn = listener.Accept();
+    if (!conn.ok()) {
+      return;
+    }
+    uint8_t len[2];
+    CHECK(tin::io::ReadFull(&*conn, len, 2).ok());
+    std::string query((len[0] << 8) | len[1], '\0');
+    CHECK(tin::io::ReadFull(&*conn, &query[0],
+                            static_cast<int>(query.size())).ok());
+    std::string reply;
+    std::string answer = FakeAnswer(query, false);
+    Put16(&reply, static_cast<uint16_t>(answer.size()));
+    reply += answer;
+    CHECK(tin::io::Write(&*conn, reply.data(),
+                         static_cast<int>(reply.size())).ok());
+    conn->Close();
+  }
+}
+
+int ResolverMain(int, char**) {
+  tin::Result<tin::net::UdpConn> udp = tin::net::ListenUdp("127.0.0.1", 0);
+  CHECK(udp.ok());
+  uint16_t port = udp->LocalAddr()->port();
+  tin::Result<tin::net::TcpListener> tcp =
+      tin::net::ListenTcp("127.0.0.1", port);
+  CHECK(tcp.ok());
+  tin::Spawn(ServeUdp, *udp);
+  tin::Spawn(ServeTcp, *tcp);
+
+  tin::net::DnsConfig config;
+  config.servers.emplace_back(IpAddress(127, 0, 0, 1), port);
+  config.search.push_back("corp.test");
+  config.timeout = tin::kSecond;
+  config.attempts = 1;
+  tin::net::DnsResolver resolver(config);
+  std::vector<IpAddress> addresses;
+
+  // Both families; IPv4 first.
+  CHECK(resolver.Resolve("www.example.test", ADDRESS_FAMILY_UNSPECIFIED,
+                         &addresses).ok());
+  CHECK_EQ(addresses.size(), 2u);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 1));
+  CHECK(addresses[1].IsIPv6());
+
+  CHECK(resolver.Resolve("WWW.example.test.", ADDRESS_FAMILY_IPV6,
+                         &addresses).ok());
+  CHECK_EQ(addresses.size(), 1u);
+  CHECK_EQ(addresses[0].ToString(), "2001:db8::1");
+
+  // Truncated over UDP, answered over TCP.
+  CHECK(resolver.Resolve("big.example.test", ADDRESS_FAMILY_IPV4,
+                         &addresses).ok());
+  CHECK_EQ(addresses.size(), 1u);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 7));
+
+  // A single label is below ndots, so the search list comes first.
+  CHECK(resolver.Resolve("host", ADDRESS_FAMILY_UNSPECIFIED,
+                         &addresses).ok());
+  CHECK_EQ(addresses.size(), 1u);
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 9));
+
+  CHECK_EQ(resolver.Resolve("host", ADDRESS_FAMILY_IPV6,
+                            &addresses).code(), TIN_EAI_NODATA);
+  CHECK_EQ(resolver.Resolve("missing.example.test",
+                            ADDRESS_FAMILY_UNSPECIFIED,
+                            &addresses).code(), TIN_EAI_NONAME);
+
+  // The host table wins over DNS.
+  resolver.SetHosts("# comment\n192.0.2.50 www.example.test alias\n");
+  CHECK(resolver.Resolve("Alias", ADDRESS_FAMILY_IPV4,
+                         &addresses).ok());
+  CHECK(addresses[0] == IpAddress(192, 0, 2, 50));
+  resolver.SetHosts("");
+
+  // Many lookups in flight at once, each one a coroutine.
+  const int kLookups = 200;
+  std::atomic<int> resolved(0);
+  tin::WaitGroup wg;
+  wg.Add(kLookups);
+  for (int i = 0; i < kLookups; ++i) {
+    tin::Spawn([&]() {
+      std::vector<IpAddress> out;
+      if (resolver.Resolve("www.example.test", ADDRESS_FAMILY_IPV4,
+                           &out).ok() && out.size() == 1) {
+        resolved++;
+      }
+      wg.Done();
+    });
+  }
+  wg.Wait();
+  CHECK_EQ(resolved.load(), kLookups);
+
+  udp->Close();
+  tcp->Close();
+  return 0;
+}
+
+}  // namespace
+
+TEST(DnsResolver, ParseResolvConf) {
+  tin::net::DnsConfig config;
+  tin::net::ParseResolvConf(
+      "# generated\n"
+      "nameserver 10.0.0.1\n"
+      "nameserver 2001:db8::53 ; comment\n"
+      "nameserver bogus\n"
+      "domain example.test\n"
+      "search a.test b.test\n"
+      "options ndots:2 timeout:3 attempts:9 rotate\n",
+      &config);
+  CHECK_EQ(config.servers.size(), 2u);
+  CHECK_EQ(config.servers[0].ToString(), "10.0.0.1:53");
+  CHECK(config.servers[1].address().IsIPv6());
+  CHECK_EQ(config.search.size(), 2u);
+  CHECK_EQ(config.search[1], "b.test");
+  CHECK_EQ(config.ndots, 2);
+  CHECK_EQ(config.timeout, 3 * tin::kSecond);
+  CHECK_EQ(config.attempts, 5);
+  CHECK(config.rotate);
+}
+
+TEST(DnsResolver, FakeServer) {
+  CHECK_EQ(tin::Run(ResolverMain, 0, nullptr), 0);
+}
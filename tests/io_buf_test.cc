@@ -0,0 +1,125 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Unit tests for tin::IoBuf. Sharing is observed through the buffers
+// GetBuffers returns: shared slices point at the same bytes.
+
+#include "test.h"
+#include "test_io.h"
+#include "tin/error/error.h"
+#include "tin/io/io_buf.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/log/check.h>
+
+namespace {
+
+const void* FirstByte(const tin::IoBuf& buf) {
+  std::vector<tin::io::ConstBuffer> bufs;
+  buf.GetBuffers(&bufs);
+  return bufs.empty() ? nullptr : bufs[0].data;
+}
+
+}  // namespace
+
+TEST(IoBuf, AppendFillsTailBlock) {
+  tin::IoBuf buf;
+  CHECK(buf.empty());
+  buf.Append("hello ");
+  buf.Append("world");
+  CHECK_EQ(buf.size(), 11u);
+  CHECK_EQ(buf.slice_count(), 1u);
+  CHECK_EQ(buf.ToString(), "hello world");
+
+  std::string big(tin::IoBuf::kBlockSize * 2 + 10, 'x');
+  buf.Append(big);
+  CHECK_EQ(buf.size(), 11u + big.size());
+  CHECK_EQ(buf.ToString(), "hello world" + big);
+}
+
+TEST(IoBuf, CopyShares) {
+  tin::IoBuf a;
+  a.Append("payload");
+  tin::IoBuf b(a);
+  CHECK(FirstByte(a) == FirstByte(b));
+  // a's block is shared now, so appending to b may not write into it.
+  b.Append("!");
+  CHECK_EQ(a.ToString(), "payload");
+  CHECK_EQ(b.ToString(), "payload!");
+  CHECK_EQ(b.slice_count(), 2u);
+}
+
+TEST(IoBuf, CutAndSub) {
+  tin::IoBuf buf;
+  buf.Append("header|body-bytes");
+  const void* start = FirstByte(buf);
+  tin::IoBuf header = buf.Cut(7);
+  CHECK_EQ(header.ToString(), "header|");
+  CHECK_EQ(buf.ToString(), "body-bytes");
+  CHECK(FirstByte(header) == start);
+  CHECK(FirstByte(buf) == static_cast<const char*>(start) + 7);
+
+  tin::IoBuf sub = buf.Sub(5, 100);
+  CHECK_EQ(sub.ToString(), "bytes");
+  CHECK(buf.Sub(50, 1).empty());
+
+  // Putting the pieces back together merges them into one slice again.
+  header.Append(std::move(buf));
+  CHECK_EQ(header.ToString(), "header|body-bytes");
+  CHECK_EQ(header.slice_count(), 1u);
+  CHECK(buf.empty());
+}
+
+TEST(IoBuf, Prepend) {
+  tin::IoBuf body;
+  body.Append("body");
+  body.Prepend("len:");
+  CHECK_EQ(body.ToString(), "len:body");
+  body.Prepend("v1 ");
+  CHECK_EQ(body.ToString(), "v1 len:body");
+  // The second prepend used the room the first one left.
+  CHECK_EQ(body.slice_count(), 2u);
+
+  tin::IoBuf frame;
+  frame.Append("<");
+  body.Prepend(frame);
+  CHECK_EQ(body.ToString(), "<v1 len:body");
+}
+
+TEST(IoBuf, Trim) {
+  tin::IoBuf buf;
+  buf.Append("abc");
+  tin::IoBuf tail;
+  tail.Append("defgh");
+  buf.Append(tail);
+  buf.TrimFront(2);
+  buf.TrimBack(4);
+  CHECK_EQ(buf.ToString(), "cd");
+  CHECK_EQ(buf.slice_count(), 2u);
+  buf.TrimBack(10);
+  CHECK(buf.empty());
+  CHECK_EQ(buf.slice_count(), 0u);
+}
+
+TEST(IoBuf, ReaderWriter) {
+  ChunkReader src("streamed into the tail block", 5);
+  tin::IoBuf buf;
+  tin::Result<size_t> n = buf.ReadFrom(&src);
+  CHECK(n.ok());
+  CHECK_EQ(*n, 28u);
+  CHECK_EQ(buf.slice_count(), 1u);
+
+  char out[9];
+  CHECK_EQ(*buf.Read(out, 9), 9u);
+  CHECK_EQ(std::string(out, 9), "streamed ");
+
+  tin::IoBuf sink;
+  CHECK_EQ(*buf.WriteTo(&sink), 19u);
+  CHECK(buf.empty());
+  CHECK_EQ(sink.ToString(), "into the tail block");
+  CHECK_EQ(buf.Read(out, 1).code(), TIN_EOF);
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Unit tests for tin::IoRingBuffer. The wrap-around tests hold on either
+// backing: with the mirror no byte moves, without it the buffer compacts.
+
+#include "build/build_config.h"
+#include "test.h"
+#include "tin/io/io_ring_buffer.h"
+
+#include <string>
+#include <utility>
+
+#include <absl/log/check.h>
+
+namespace {
+
+std::string Pattern(size_t n, char first) {
+  std::string s(n, '\0');
+  for (size_t i = 0; i < n; ++i) {
+    s[i] = static_cast<char>(first + i % 26);
+  }
+  return s;
+}
+
+}  // namespace
+
+TEST(IoRingBuffer, Mirrored) {
+  tin::IoRingBuffer buf(4096);
+#if defined(OS_LINUX)
+  CHECK(buf.mirrored());
+#endif
+  CHECK_EQ(buf.buffer_size() & (buf.buffer_size() - 1), 0);
+  CHECK(buf.empty());
+  CHECK_EQ(buf.free(), buf.buffer_size());
+}
+
+TEST(IoRingBuffer, SpansStayContiguousAcrossWrap) {
+  tin::IoRingBuffer buf(4096);
+  int size = buf.buffer_size();
+  std::string head = Pattern(size * 3 / 4, 'a');
+  CHECK_EQ(buf.Write(head.data(), head.size()), static_cast<int>(head.size()));
+
+  // Leave a partial frame behind, then write past the end of the storage.
+  char sink[4096];
+  CHECK_EQ(buf.Read(sink, size / 2), size / 2);
+  char* read_ptr = nullptr;
+  int read_size = 0;
+  buf.GetReadablePtr(&read_ptr, &read_size);
+  const char* partial = read_ptr;
+
+  std::string tail = Pattern(size / 2, 'A');
+  char* write_ptr = nullptr;
+  int write_size = 0;
+  buf.GetWritablePtr(&write_ptr, &write_size);
+  CHECK_GE(write_size, static_cast<int>(tail.size()));
+  tail.copy(write_ptr, tail.size());
+  buf.AdvanceWritablePtr(static_cast<int>(tail.size()));
+
+  buf.GetReadablePtr(&read_ptr, &read_size);
+  if (buf.mirrored()) {
+    // The unread bytes did not move.
+    CHECK(read_ptr == partial);
+    CHECK_EQ(write_size, buf.free() + static_cast<int>(tail.size()));
+  }
+  CHECK_EQ(std::string(read_ptr, read_size), head.substr(size / 2) + tail);
+  CHECK(!buf.full());
+}
+
+TEST(IoRingBuffer, ManyLaps) {
+  tin::IoRingBuffer buf(4096);
+  int capacity = buf.buffer_size();
+  std::string frame = Pattern(capacity / 3 + 7, 'a');
+  std::string expect;
+  char out[4096];
+  // Keep a partial frame buffered across many laps around the ring.
+  for (int i = 0; i < 100; ++i) {
+    buf.Write(frame.data(), frame.size());
+    expect += frame;
+    int n = buf.Read(out, frame.size() - 5);
+    CHECK_EQ(std::string(out, n), expect.substr(0, n));
+    expect.erase(0, n);
+    CHECK_EQ(buf.str(), expect);
+  }
+  CHECK_EQ(buf.buffer_size(), capacity);
+}
+
+TEST(IoRingBuffer, GrowAndMove) {
+  tin::IoRingBuffer buf(4096);
+  int capacity = buf.buffer_size();
+  std::string data = Pattern(capacity + 100, 'a');
+  CHECK_EQ(buf.Write(data.data(), data.size()), static_cast<int>(data.size()));
+  CHECK_GE(buf.buffer_size(), 2 * capacity);
+  CHECK_EQ(buf.str(), data);
+
+  tin::IoRingBuffer moved(std::move(buf));
+  CHECK_EQ(moved.str(), data);
+  CHECK(!moved.ReserveMore(10));
+  moved.AdvanceReadablePtr(static_cast<int>(data.size()));
+  CHECK(moved.empty());
+}
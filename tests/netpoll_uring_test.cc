@@ -0,0 +1,160 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Loopback traffic through the netpoll backend the runner selected. Under
+// --uring this covers the io_uring backend end to end: it comes up with
+// the first descriptor, carries RECV/SEND completions, survives a CQ
+// overflow, and runtime_test_main checks that shutdown tore it down.
+
+#include "build/build_config.h"
+#include "test.h"
+#include "tin/communication/chan.h"
+#include "tin/config.h"
+#include "tin/error/error.h"
+#include "tin/io/io.h"
+#include "tin/net/dialer.h"
+#include "tin/net/tcp.h"
+#include "tin/runtime.h"
+#include "tin/tin.h"
+
+#if defined(OS_LINUX)
+#include "tin/runtime/net/netpoll_uring.h"
+#include "tin/runtime/net/poll_descriptor.h"
+#include "tin/runtime/net/pollops.h"
+#endif
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace {
+
+uint16_t ListenerPort(tin::net::TcpListener* listener) {
+  tin::Result<int> fd = listener->File();
+  CHECK(fd.ok());
+  sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  CHECK_EQ(getsockname(*fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  close(*fd);
+  return ntohs(addr.sin_port);
+}
+
+// Echoes until EOF.
+void Echo(tin::net::TcpListener listener) {
+  tin::Result<tin::net::TcpConn> conn = listener.Accept();
+  CHECK(conn.ok());
+  std::string buf(16 * 1024, '\0');
+  while (true) {
+    tin::Result<size_t> n = conn->Read(&buf[0], static_cast<int>(buf.size()));
+    if (!n.ok() || *n == 0) {
+      break;
+    }
+    CHECK(tin::io::Write(&*conn, buf.data(), static_cast<int>(*n)).ok());
+  }
+  conn->Close();
+}
+
+}  // namespace
+
+TEST(NetPollUring, EchoOverLoopback) {
+  tin::Result<tin::net::TcpListener> listener =
+      tin::net::ListenTcp("127.0.0.1", 0);
+  CHECK(listener.ok());
+  uint16_t port = ListenerPort(&*listener);
+  tin::Spawn(Echo, *listener);
+
+  tin::Result<tin::net::TcpConn> conn = tin::net::DialTcp("127.0.0.1", port);
+  CHECK(conn.ok());
+#if defined(OS_LINUX)
+  if (tin::GetWorkingConfig()->GetNetPoller() == tin::NetPoller::kIoUring &&
+      !tin::runtime::UringNetPollActive()) {
+    LOG(WARNING) << "io_uring unavailable, ran on epoll";
+  }
+#endif
+
+  // Far more than the socket buffers hold, so both sides block and the
+  // transfers complete through the poller.
+  std::string payload(4 << 20, '\0');
+  for (size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<char>(i * 131 % 251);
+  }
+  tin::Chan<int> written(1);
+  tin::net::TcpConn writer = *conn;
+  tin::Spawn([writer, &payload, written]() mutable {
+    CHECK(tin::io::Write(&writer, payload.data(),
+                         static_cast<int>(payload.size())).ok());
+    CHECK(writer.CloseWrite().ok());
+    written->Push(1);
+  });
+
+  std::string echoed;
+  // Coroutine stacks are small; keep the buffer on the heap.
+  std::string buf(64 * 1024, '\0');
+  while (true) {
+    tin::Result<size_t> n = conn->Read(&buf[0], static_cast<int>(buf.size()));
+    if (!n.ok()) {
+      CHECK_EQ(n.code(), TIN_EOF);
+      break;
+    }
+    echoed.append(buf, 0, *n);
+  }
+  int done = 0;
+  CHECK(written->Pop(&done));
+  CHECK(echoed == payload);
+  conn->Close();
+  listener->Close();
+}
+
+#if defined(OS_LINUX)
+TEST(NetPollUring, CqOverflow) {
+  if (!tin::runtime::UringNetPollActive()) {
+    return;
+  }
+  // Keep the other P busy so that only sysmon polls meanwhile.
+  auto stop = std::make_shared<std::atomic<bool>>(false);
+  tin::Chan<int> stopped(1);
+  tin::Spawn([stop, stopped]() mutable {
+    while (!stop->load()) {
+      tin::Sched();
+    }
+    stopped->Push(1);
+  });
+
+  // Reads of /dev/zero complete inside the submitting enter. Issued from
+  // one coroutine that does not park, far more of them than the 16384
+  // entry CQ holds: the kernel parks the rest on its overflow list and
+  // refuses further submissions with -EBUSY until the CQ is drained.
+  const int kOps = 40000;
+  int fd = open("/dev/zero", O_RDONLY | O_CLOEXEC);
+  CHECK_GE(fd, 0);
+  auto ops = std::make_unique<tin::runtime::UringOp[]>(kOps);
+  std::string bufs(kOps, 'x');
+  tin::runtime::PollDescriptor* pd = tin::runtime::NewPollDescriptor();
+  for (int i = 0; i < kOps; ++i) {
+    tin::runtime::UringSubmitRead(&ops[i], pd, fd, &bufs[i], 1, -1);
+  }
+  for (int i = 0; i < kOps; ++i) {
+    while (!tin::runtime::UringOpDone(&ops[i])) {
+      tin::runtime::pollops::WaitCanceled(pd, 'r');
+    }
+    CHECK_EQ(ops[i].res, 1);
+  }
+  CHECK(bufs == std::string(kOps, '\0'));
+  pd->Release();
+  close(fd);
+
+  stop->store(true);
+  int one = 0;
+  CHECK(stopped->Pop(&one));
+}
+#endif
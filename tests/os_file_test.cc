@@ -0,0 +1,152 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// tin::os::File on the backend the runner selected. Under --uring reads,
+// writes and fsync are io_uring requests; the busy-scheduler case checks
+// they still go out while every P has runnable coroutines and nothing
+// would otherwise poll.
+
+#include "build/build_config.h"
+#include "test.h"
+#include "tin/communication/chan.h"
+#include "tin/error/error.h"
+#include "tin/os/file.h"
+#include "tin/runtime.h"
+#include "tin/tin.h"
+
+#include <absl/log/check.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace {
+
+std::string TempPath(const char* name) {
+  return "/tmp/tin_os_file_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+std::string Pattern(size_t n) {
+  std::string s(n, '\0');
+  for (size_t i = 0; i < n; ++i) {
+    s[i] = static_cast<char>(i * 131 % 251);
+  }
+  return s;
+}
+
+}  // namespace
+
+TEST(OsFile, WriteFsyncReadBack) {
+  std::string path = TempPath("rw");
+  tin::Result<tin::os::File> file = tin::os::Create(path);
+  CHECK(file.ok());
+  std::string payload = Pattern(1 << 20);
+  tin::Result<size_t> n =
+      file->Write(payload.data(), static_cast<int>(payload.size()));
+  CHECK(n.ok());
+  CHECK_EQ(*n, payload.size());
+  CHECK(file->Fsync().ok());
+  tin::Result<int64_t> size = file->Size();
+  CHECK(size.ok());
+  CHECK_EQ(*size, static_cast<int64_t>(payload.size()));
+
+  // Coroutine stacks are small; keep the buffer on the heap.
+  std::string buf(4096, '\0');
+  n = file->ReadAt(&buf[0], static_cast<int>(buf.size()), 12345);
+  CHECK(n.ok());
+  CHECK_EQ(buf.substr(0, *n), payload.substr(12345, *n));
+  // The file offset sits at the end after the Write.
+  n = file->Read(&buf[0], static_cast<int>(buf.size()));
+  CHECK(!n.ok());
+  CHECK_EQ(n.code(), TIN_EOF);
+  CHECK(file->Close().ok());
+
+  file = tin::os::Open(path);
+  CHECK(file.ok());
+  std::string read;
+  while (true) {
+    n = file->Read(&buf[0], static_cast<int>(buf.size()));
+    if (!n.ok()) {
+      CHECK_EQ(n.code(), TIN_EOF);
+      break;
+    }
+    read.append(buf, 0, *n);
+  }
+  CHECK(read == payload);
+  CHECK(file->Close().ok());
+  unlink(path.c_str());
+}
+
+TEST(OsFile, ConcurrentReadAt) {
+  std::string path = TempPath("concurrent");
+  tin::Result<tin::os::File> file = tin::os::Create(path);
+  CHECK(file.ok());
+  const int kReaders = 16;
+  const int kChunk = 8192;
+  std::string payload = Pattern(kReaders * kChunk);
+  CHECK(file->Write(payload.data(), static_cast<int>(payload.size())).ok());
+
+  tin::Chan<int> done(kReaders);
+  tin::os::File shared = *file;
+  for (int i = 0; i < kReaders; ++i) {
+    tin::Spawn([shared, i, &payload, done]() mutable {
+      std::string buf(kChunk, '\0');
+      tin::Result<size_t> n = shared.ReadAt(&buf[0], kChunk,
+                                            static_cast<int64_t>(i) * kChunk);
+      CHECK(n.ok());
+      CHECK_EQ(*n, static_cast<size_t>(kChunk));
+      CHECK(buf == payload.substr(i * kChunk, kChunk));
+      done->Push(i);
+    });
+  }
+  for (int i = 0; i < kReaders; ++i) {
+    int id = 0;
+    CHECK(done->Pop(&id));
+  }
+  CHECK(file->Close().ok());
+  unlink(path.c_str());
+}
+
+TEST(OsFile, BusyScheduler) {
+  std::string path = TempPath("busy");
+  tin::Result<tin::os::File> file = tin::os::Create(path);
+  CHECK(file.ok());
+
+  // Keep every P's run queue non-empty so no scheduler goes looking in
+  // the poller between the file ops.
+  const int kSpinners = 4;
+  auto stop = std::make_shared<std::atomic<bool>>(false);
+  tin::Chan<int> stopped(kSpinners);
+  for (int i = 0; i < kSpinners; ++i) {
+    tin::Spawn([stop, stopped]() mutable {
+      while (!stop->load()) {
+        tin::Sched();
+      }
+      stopped->Push(1);
+    });
+  }
+
+  std::string block = Pattern(4096);
+  std::string buf(block.size(), '\0');
+  for (int i = 0; i < 64; ++i) {
+    int64_t offset = static_cast<int64_t>(i) * block.size();
+    CHECK(file->WriteAt(block.data(), static_cast<int>(block.size()),
+                        offset).ok());
+    tin::Result<size_t> n =
+        file->ReadAt(&buf[0], static_cast<int>(buf.size()), offset);
+    CHECK(n.ok());
+    CHECK(buf == block);
+  }
+  CHECK(file->Fsync().ok());
+
+  stop->store(true);
+  for (int i = 0; i < kSpinners; ++i) {
+    int one = 0;
+    CHECK(stopped->Pop(&one));
+  }
+  CHECK(file->Close().ok());
+  unlink(path.c_str());
+}
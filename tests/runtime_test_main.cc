@@ -0,0 +1,43 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Runner for tests that need the runtime: the registry runs inside the main
+// coroutine of one tin::Run. The netpoll backend is chosen once per
+// process, so ctest runs this binary twice, the second time with --uring
+// to select the io_uring backend through Config.
+
+#include <cstring>
+
+#include <absl/log/check.h>
+
+#include "build/build_config.h"
+#include "test.h"
+#include "tin/config.h"
+#include "tin/tin.h"
+
+#if defined(OS_LINUX)
+#include "tin/runtime/net/netpoll_uring.h"
+#endif
+
+namespace {
+
+int TestMain(int argc, char** argv) {
+  return RunAllTests();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tin::Config config = tin::DefaultConfig();
+  config.SetMaxProcs(2);
+  if (argc > 1 && strcmp(argv[1], "--uring") == 0) {
+    config.SetNetPoller(tin::NetPoller::kIoUring);
+  }
+  int code = tin::Run(TestMain, argc, argv, config);
+#if defined(OS_LINUX)
+  // Shutdown closes the ring.
+  CHECK(!tin::runtime::UringNetPollActive());
+#endif
+  return code;
+}
@@ -9,6 +9,8 @@
 #ifndef TIN_TESTS_TEST_H_
 #define TIN_TESTS_TEST_H_
 
+#include <cstdio>
+#include <exception>
 #include <functional>
 #include <string>
 #include <vector>
@@ -36,4 +38,33 @@ struct TestRegistrar {
       #suite "." #name, suite##_##name##_test);                    \
   static void suite##_##name##_test()
 
+// Runs every registered test in order and prints a summary. Returns 0 if
+// all of them passed.
+inline int RunAllTests() {
+  int passed = 0;
+  int failed = 0;
+
+  for (const auto& entry : TestRegistry()) {
+    printf("[ RUN      ] %s\n", entry.name.c_str());
+    try {
+      entry.fn();
+      printf("[       OK ] %s\n", entry.name.c_str());
+      ++passed;
+    } catch (const std::exception& e) {
+      printf("[  FAILED  ] %s: %s\n", entry.name.c_str(), e.what());
+      ++failed;
+    } catch (...) {
+      printf("[  FAILED  ] %s: unknown exception\n", entry.name.c_str());
+      ++failed;
+    }
+  }
+
+  printf("\n");
+  printf("Passed: %d\n", passed);
+  printf("Failed: %d\n", failed);
+  printf("Total:  %d\n", passed + failed);
+  printf("\n");
+  return failed == 0 ? 0 : 1;
+}
+
 #endif  // TIN_TESTS_TEST_H_
@@ -0,0 +1,43 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// In-memory tin::io helpers shared by the tests.
+
+#ifndef TIN_TESTS_TEST_IO_H_
+#define TIN_TESTS_TEST_IO_H_
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "tin/error/error.h"
+#include "tin/io/io.h"
+#include "tin/result.h"
+
+// Hands out data at most chunk bytes per Read, then TIN_EOF.
+class ChunkReader : public tin::io::Reader {
+ public:
+  ChunkReader(std::string data, size_t chunk)
+      : data_(std::move(data)), chunk_(chunk) {}
+
+  tin::Result<size_t> Read(void* buf, int nbytes) override {
+    if (pos_ == data_.size()) {
+      return tin::Result<size_t>::Err(TIN_EOF);
+    }
+    size_t n = std::min({static_cast<size_t>(nbytes), chunk_,
+                         data_.size() - pos_});
+    data_.copy(static_cast<char*>(buf), n, pos_);
+    pos_ += n;
+    return tin::Result<size_t>::Ok(n);
+  }
+
+  void set_chunk(size_t chunk) { chunk_ = chunk; }
+
+ private:
+  std::string data_;
+  size_t chunk_;
+  size_t pos_ = 0;
+};
+
+#endif  // TIN_TESTS_TEST_IO_H_
@@ -0,0 +1,68 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Lifetime tests for tin::Timer, Ticker and AfterFunc: a handle may go
+// away while its timer is still in a P's heap, and the heap must not be
+// left pointing at freed memory. Run under ASan to catch regressions.
+
+#include "test.h"
+#include "tin/communication/chan.h"
+#include "tin/time.h"
+#include "tin/time/timer.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <absl/log/check.h>
+
+TEST(Timer, DropPendingTimer) {
+  {
+    tin::Timer timer(5 * tin::kMillisecond);
+  }
+  {
+    // Reset re-queues a timer that already fired.
+    tin::Timer timer(tin::kMillisecond);
+    int64_t when = 0;
+    CHECK(timer.C()->Pop(&when));
+    CHECK(!timer.Reset(5 * tin::kMillisecond));
+  }
+  // Let both fire with their handles gone.
+  tin::Sleep(20);
+}
+
+TEST(Timer, DropTicker) {
+  {
+    tin::Ticker ticker(tin::kMillisecond);
+    int64_t when = 0;
+    CHECK(ticker.C()->Pop(&when));
+  }
+  {
+    auto ticker = std::make_unique<tin::Ticker>(2 * tin::kMillisecond);
+    tin::Ticker moved(std::move(*ticker));
+    ticker.reset();
+  }
+  tin::Sleep(20);
+}
+
+TEST(Timer, DiscardAfterFunc) {
+  auto fired = std::make_shared<std::atomic<int>>(0);
+  tin::AfterFunc(2 * tin::kMillisecond, [fired] { fired->fetch_add(1); });
+  {
+    tin::Timer stopped = tin::AfterFunc(2 * tin::kMillisecond,
+                                        [fired] { fired->fetch_add(10); });
+    CHECK(stopped.Stop());
+  }
+  {
+    // Dropped from inside its own callback, as ConnPool's reaper does.
+    auto self = std::make_shared<std::unique_ptr<tin::Timer>>();
+    *self = std::make_unique<tin::Timer>(
+        tin::AfterFunc(tin::kMillisecond, [self, fired] {
+          self->reset();
+          fired->fetch_add(100);
+        }));
+  }
+  tin::Sleep(20);
+  CHECK_EQ(fired->load(), 101);
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Unit tests for FileTcpConn/FileTcpListener: sockets other than TCP are
+// rejected before the runtime ever sees them.
+
+#include "test.h"
+#include "tin/error/error.h"
+#include "tin/net/unix_conn.h"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <absl/log/check.h>
+
+namespace {
+
+bool IsOpen(int fd) {
+  return fcntl(fd, F_GETFD) != -1;
+}
+
+}  // namespace
+
+TEST(FileTcp, RejectsUnixSocket) {
+  int fds[2];
+  CHECK_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  CHECK_EQ(tin::net::FileTcpConn(fds[0]).code(), TIN_EAFNOSUPPORT);
+  CHECK_EQ(tin::net::FileTcpListener(fds[1]).code(), TIN_EAFNOSUPPORT);
+  // Ownership passed even on failure.
+  CHECK(!IsOpen(fds[0]));
+  CHECK(!IsOpen(fds[1]));
+}
+
+TEST(FileTcp, RejectsUdpSocket) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  CHECK_GE(fd, 0);
+  CHECK_EQ(tin::net::FileTcpConn(fd).code(), TIN_EPROTOTYPE);
+  CHECK(!IsOpen(fd));
+}
@@ -3,33 +3,49 @@
 // found in the LICENSE file.
 
 #include <algorithm>
+#include <cstring>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
 #include "tin/error/error.h"
+#include "tin/io/buffer_pool.h"
+#include "tin/net/tcp_conn.h"
 #include "tin/runtime/runtime.h"
+#include "tin/sync/mutex.h"
+#include "tin/time.h"
+#include "tin/time/timer.h"
 #include "tin/bufio/bufio.h"
+#include "tin/bufio/scan.h"
 
 namespace {
 // const int kMinReadBufferSize = 16;
 const int kMaxConsecutiveEmptyReads = 100;
+// Adaptive Reader: grow after this many reads in a row filled the buffer,
+// shrink after this many read under a quarter of it.
+const int kAdaptiveGrowAfter = 2;
+const int kAdaptiveShrinkAfter = 4;
 }
 
 
 namespace tin::bufio {
 
 Reader::Reader(tin::io::Reader* rd, size_t size)
-  : storage_(new uint8_t[size])
+  : storage_(static_cast<uint8_t*>(tin::io::AllocBuffer(size)))
   , storage_size_(static_cast<int>(size))
   , read_idx_(0)
   , write_idx_(0)
   , err_(0)
   , rd_(rd)
-  , last_byte_(-1) {
+  , last_byte_(-1)
+  , tcp_(dynamic_cast<tin::net::TcpConn*>(rd))
+  , min_size_(static_cast<int>(size))
+  , max_size_(static_cast<int>(size))
+  , full_reads_(0)
+  , short_reads_(0) {
 }
 
 Reader::~Reader() {
-  delete [] storage_;
+  tin::io::FreeBuffer(storage_, storage_size_);
 }
 
 Result<size_t> Reader::Read(void* buf, int buf_size) {
@@ -88,9 +104,22 @@ Result<size_t> Reader::Read(void* buf, int buf_size) {
 
 void Reader::Reset(tin::io::Reader* rd) {
   rd_ = rd;
+  tcp_ = dynamic_cast<tin::net::TcpConn*>(rd);
   read_idx_ = 0;
   write_idx_ = 0;
   last_byte_ = -1;
+  if (storage_size_ != min_size_) {
+    Resize(min_size_);
+  }
+  full_reads_ = 0;
+  short_reads_ = 0;
+}
+
+void Reader::SetMaxBufferSize(size_t max_size) {
+  max_size_ = std::max(static_cast<int>(max_size), min_size_);
+  if (storage_size_ > max_size_ && buffered() < max_size_) {
+    Resize(max_size_);
+  }
 }
 
 void Reader::Fill() {
@@ -103,22 +132,82 @@ void Reader::Fill() {
     LOG(FATAL) << "bufio: tried to fill full buffer";
   }
 
+  if (max_size_ > min_size_) {
+    Adapt();
+  }
+
   // Read new data: try a limited number of times.
-  for (int i = kMaxConsecutiveEmptyReads; i > 0; i++) {
-    auto result = rd_->Read(end(), free());
-    size_t n = result.value_or(0);
-    write_idx_ += static_cast<int>(n);
+  for (int i = kMaxConsecutiveEmptyReads; i > 0; i--) {
+    int room = free();
+    auto result = rd_->Read(end(), room);
+    int n = static_cast<int>(result.value_or(0));
+    write_idx_ += n;
     if (!result.ok()) {
       err_ = result.code();
       return;
     }
     if (n > 0) {
+      if (n == room) {
+        full_reads_++;
+        short_reads_ = 0;
+      } else {
+        full_reads_ = 0;
+        short_reads_ = n < storage_size_ / 4 ? short_reads_ + 1 : 0;
+      }
       return;
     }
   }
   err_ = TIN_ENOPROGRESS;
 }
 
+// Picks the buffer size for the next read; Fill has already moved the
+// unread bytes to the front.
+void Reader::Adapt() {
+  bool grown = storage_size_ > min_size_;
+  // Short reads at the initial size, the common case for small messages,
+  // cost no extra syscall.
+  if (full_reads_ == 0 && !(grown && empty())) {
+    return;
+  }
+  int want = storage_size_;
+  Result<size_t> queued = tcp_ != nullptr
+      ? tcp_->Available() : Result<size_t>::Err(TIN_ENOSYS);
+  if (queued.ok()) {
+    if (*queued > static_cast<size_t>(free())) {
+      // Room for everything queued, so one read takes it.
+      size_t need = buffered() + *queued;
+      while (static_cast<size_t>(want) < need && want < max_size_) {
+        want *= 2;
+      }
+    } else if (*queued == 0 && empty()) {
+      // The read is going to wait: hold only the small buffer meanwhile.
+      want = min_size_;
+    }
+  } else if (full_reads_ >= kAdaptiveGrowAfter) {
+    want = storage_size_ * 2;
+  } else if (short_reads_ >= kAdaptiveShrinkAfter && empty()) {
+    want = storage_size_ / 2;
+  }
+  want = std::clamp(want, min_size_, max_size_);
+  if (want != storage_size_) {
+    Resize(want);
+  }
+}
+
+void Reader::Resize(int size) {
+  DCHECK_LE(buffered(), size);
+  uint8_t* storage = static_cast<uint8_t*>(tin::io::AllocBuffer(size));
+  int n = buffered();
+  std::memcpy(storage, begin(), n);
+  tin::io::FreeBuffer(storage_, storage_size_);
+  storage_ = storage;
+  storage_size_ = size;
+  read_idx_ = 0;
+  write_idx_ = n;
+  full_reads_ = 0;
+  short_reads_ = 0;
+}
+
 int Reader::ReadErr() {
   int err = err_;
   err_ = 0;
@@ -128,9 +217,31 @@ int Reader::ReadErr() {
 
 
 Status Reader::ReadSlice(uint8_t delim, absl::string_view* line) {
+  return ReadSliceWith(
+      [delim](const uint8_t* first, const uint8_t* last) {
+        return ScanByte(first, last, delim);
+      },
+      line);
+}
+
+Status Reader::ReadSliceAny(const absl::string_view& delims,
+                            absl::string_view* line) {
+  if (delims.empty()) {
+    return Status::FromErrno(TIN_EINVAL);
+  }
+  return ReadSliceWith(
+      [delims](const uint8_t* first, const uint8_t* last) {
+        return ScanAny(first, last, delims);
+      },
+      line);
+}
+
+template <typename Scan>
+Status Reader::ReadSliceWith(Scan scan, absl::string_view* line) {
   int err = 0;
+  int scanned = 0;  // do not rescan what earlier fills already searched
   while (true) {
-    const_iterator it =  std::find(begin(), end(), delim);
+    const_iterator it = scan(begin() + scanned, end());
     if (it != end()) {
       size_t n = it - begin() + 1;
       *line = ToStringPiece(begin(), n);
@@ -148,11 +259,12 @@ Status Reader::ReadSlice(uint8_t delim, absl::string_view* line) {
 
     // Buffer full?
     if (buffered() >= storage_size_) {
-      read_idx_ = write_idx_;
       *line = ToStringPiece(begin(), buffered());
+      read_idx_ = write_idx_;
       err = TIN_EBUFFERFULL;
       break;
     }
+    scanned = buffered();
     Fill();  // buffer is not full
   }
 
@@ -198,7 +310,7 @@ Status Reader::ReadLine(absl::string_view* line, bool* is_prefix) {
     if (line->length() > 1 && (*line)[line->length() - 2] == '\r') {
       drop = 2;
     }
-    line->remove_prefix(drop);
+    line->remove_suffix(drop);
   }
   *is_prefix = false;
   return Status::OK();
@@ -260,4 +372,191 @@ Result<uint8_t> Reader::ReadByte() {
   return Result<uint8_t>::Ok(c);
 }
 
+struct WriterShared {
+  tin::Mutex mu;
+  Writer* owner = nullptr;  // nullptr once the Writer is gone
+};
+
+Writer::Writer(tin::io::Writer* wr, size_t size)
+  : storage_(static_cast<uint8_t*>(tin::io::AllocBuffer(size)))
+  , storage_size_(static_cast<int>(size))
+  , n_(0)
+  , err_(0)
+  , wr_(wr)
+  , tcp_(dynamic_cast<tin::net::TcpConn*>(wr))
+  , idle_delay_(0)
+  , last_write_(0)
+  , idle_armed_(false)
+  , shared_(std::make_shared<WriterShared>()) {
+  shared_->owner = this;
+}
+
+Writer::~Writer() {
+  {
+    tin::MutexGuard guard(&shared_->mu);
+    shared_->owner = nullptr;
+    if (idle_timer_) {
+      idle_timer_->Stop();
+    }
+  }
+  tin::io::FreeBuffer(storage_, storage_size_);
+}
+
+void Writer::Reset(tin::io::Writer* wr) {
+  tin::MutexGuard guard(&shared_->mu);
+  n_ = 0;
+  err_ = 0;
+  wr_ = wr;
+  tcp_ = dynamic_cast<tin::net::TcpConn*>(wr);
+}
+
+Status Writer::Flush() {
+  tin::MutexGuard guard(&shared_->mu);
+  return FlushLocked();
+}
+
+Status Writer::FlushLocked() {
+  if (err_ != 0) {
+    return Status::FromErrno(err_);
+  }
+  if (n_ == 0) {
+    return Status::OK();
+  }
+  auto result = wr_->Write(storage_, n_);
+  int n = static_cast<int>(result.value_or(0));
+  if (result.ok() && n < n_) {
+    // short write
+    err_ = TIN_EIO;
+  } else if (!result.ok()) {
+    err_ = result.code();
+  }
+  if (err_ != 0) {
+    if (n > 0 && n < n_) {
+      memmove(storage_, storage_ + n, n_ - n);
+    }
+    n_ -= std::min(n, n_);
+    return Status::FromErrno(err_);
+  }
+  n_ = 0;
+  return Status::OK();
+}
+
+Result<size_t> Writer::Write(const void* buf, int nbytes) {
+  tin::MutexGuard guard(&shared_->mu);
+  const uint8_t* p = static_cast<const uint8_t*>(buf);
+  int written = 0;
+  while (nbytes > available() && err_ == 0) {
+    int n = 0;
+    if (n_ == 0) {
+      // Large write, empty buffer.
+      // Write directly from p to avoid copy.
+      auto result = wr_->Write(p, nbytes);
+      n = static_cast<int>(result.value_or(0));
+      if (!result.ok()) {
+        err_ = result.code();
+      }
+    } else if (tcp_ != nullptr) {
+      // Buffered bytes and p leave in one writev.
+      tin::io::ConstBuffer bufs[2] = {
+        {storage_, static_cast<size_t>(n_)},
+        {p, static_cast<size_t>(nbytes)}};
+      auto result = tcp_->Writev(bufs);
+      int total = static_cast<int>(result.value_or(0));
+      if (!result.ok()) {
+        err_ = result.code();
+      }
+      if (total < n_) {
+        memmove(storage_, storage_ + total, n_ - total);
+        n_ -= total;
+      } else {
+        n = total - n_;
+        n_ = 0;
+      }
+    } else {
+      n = available();
+      memcpy(storage_ + n_, p, n);
+      n_ += n;
+      FlushLocked();
+    }
+    written += n;
+    p += n;
+    nbytes -= n;
+  }
+  if (err_ != 0) {
+    return Result<size_t>::Err(err_);
+  }
+  memcpy(storage_ + n_, p, nbytes);
+  n_ += nbytes;
+  written += nbytes;
+  ArmIdleFlushLocked();
+  return Result<size_t>::Ok(static_cast<size_t>(written));
+}
+
+Result<size_t> Writer::WriteString(const absl::string_view& str) {
+  return Write(str.data(), static_cast<int>(str.size()));
+}
+
+Status Writer::WriteByte(uint8_t c) {
+  tin::MutexGuard guard(&shared_->mu);
+  if (err_ != 0) {
+    return Status::FromErrno(err_);
+  }
+  if (available() <= 0) {
+    Status status = FlushLocked();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  storage_[n_++] = c;
+  ArmIdleFlushLocked();
+  return Status::OK();
+}
+
+void Writer::SetFlushOnIdle(int64_t delay) {
+  tin::MutexGuard guard(&shared_->mu);
+  idle_delay_ = std::max<int64_t>(delay, 0);
+  if (idle_delay_ == 0 && idle_timer_) {
+    idle_timer_->Stop();
+    idle_armed_ = false;
+  }
+}
+
+void Writer::ArmIdleFlushLocked() {
+  if (idle_delay_ == 0 || n_ == 0) {
+    return;
+  }
+  last_write_ = MonoNow();
+  if (idle_armed_) {
+    // The pending firing re-arms itself for what is left of the delay.
+    return;
+  }
+  idle_armed_ = true;
+  if (idle_timer_) {
+    idle_timer_->Reset(idle_delay_);
+  } else {
+    std::shared_ptr<WriterShared> shared = shared_;
+    idle_timer_ = std::make_unique<tin::Timer>(
+        tin::AfterFunc(idle_delay_, [shared]() { OnIdle(shared); }));
+  }
+}
+
+void Writer::OnIdle(const std::shared_ptr<WriterShared>& shared) {
+  tin::MutexGuard guard(&shared->mu);
+  Writer* w = shared->owner;
+  if (w == nullptr || !w->idle_armed_) {
+    return;
+  }
+  w->idle_armed_ = false;
+  if (w->n_ == 0 || w->idle_delay_ == 0) {
+    return;
+  }
+  int64_t idle = MonoNow() - w->last_write_;
+  if (idle < w->idle_delay_) {
+    w->idle_armed_ = true;
+    w->idle_timer_->Reset(w->idle_delay_ - idle);
+    return;
+  }
+  w->FlushLocked();
+}
+
 } // namespace tin::bufio
@@ -0,0 +1,129 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "build/build_config.h"
+
+#include <cstring>
+
+#include "tin/bufio/scan.h"
+
+#if defined(ARCH_CPU_X86_64) && defined(COMPILER_GCC)
+#define TIN_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace tin::bufio {
+
+namespace {
+
+using ScanAnyFn = const uint8_t* (*)(const uint8_t*, const uint8_t*,
+                                     const uint8_t*, int);
+
+const uint8_t* ScanAnyTable(const uint8_t* p, const uint8_t* end,
+                            const uint8_t* set, int n) {
+  bool table[256] = {};
+  for (int i = 0; i < n; ++i) {
+    table[set[i]] = true;
+  }
+  for (; p < end; ++p) {
+    if (table[*p]) {
+      return p;
+    }
+  }
+  return end;
+}
+
+#if defined(TIN_SCAN_X86)
+// Both kernels compare against kMaxVectorSet bytes every time; a smaller
+// set repeats its last byte, which keeps the loop free of branches.
+
+const uint8_t* ScanAnySse2(const uint8_t* p, const uint8_t* end,
+                           const uint8_t* set, int n) {
+  __m128i d[kMaxVectorSet];
+  for (int i = 0; i < kMaxVectorSet; ++i) {
+    d[i] = _mm_set1_epi8(static_cast<char>(set[i < n ? i : n - 1]));
+  }
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, d[0]), _mm_cmpeq_epi8(v, d[1])),
+        _mm_or_si128(_mm_cmpeq_epi8(v, d[2]), _mm_cmpeq_epi8(v, d[3])));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+  return ScanAnyTable(p, end, set, n);
+}
+
+__attribute__((target("avx2")))
+const uint8_t* ScanAnyAvx2(const uint8_t* p, const uint8_t* end,
+                           const uint8_t* set, int n) {
+  __m256i d[kMaxVectorSet];
+  for (int i = 0; i < kMaxVectorSet; ++i) {
+    d[i] = _mm256_set1_epi8(static_cast<char>(set[i < n ? i : n - 1]));
+  }
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, d[0]),
+                        _mm256_cmpeq_epi8(v, d[1])),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, d[2]),
+                        _mm256_cmpeq_epi8(v, d[3])));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return ScanAnySse2(p, end, set, n);
+}
+
+ScanAnyFn ChooseScanAny() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return ScanAnyAvx2;
+  }
+  return ScanAnySse2;
+}
+#else
+ScanAnyFn ChooseScanAny() {
+  return ScanAnyTable;
+}
+#endif
+
+}  // namespace
+
+const uint8_t* ScanByte(const uint8_t* begin, const uint8_t* end,
+                        uint8_t c) {
+  if (begin >= end) {
+    return end;
+  }
+  const void* p = std::memchr(begin, c, end - begin);
+  return p != nullptr ? static_cast<const uint8_t*>(p) : end;
+}
+
+const uint8_t* ScanAny(const uint8_t* begin, const uint8_t* end,
+                       absl::string_view set) {
+  const uint8_t* s = reinterpret_cast<const uint8_t*>(set.data());
+  int n = static_cast<int>(set.size());
+  if (n == 1) {
+    return ScanByte(begin, end, s[0]);
+  }
+  if (n > kMaxVectorSet) {
+    return ScanAnyTable(begin, end, s, n);
+  }
+  static const ScanAnyFn scan = ChooseScanAny();
+  return scan(begin, end, s, n);
+}
+
+const uint8_t* ScanAnyScalar(const uint8_t* begin, const uint8_t* end,
+                             absl::string_view set) {
+  return ScanAnyTable(begin, end,
+                      reinterpret_cast<const uint8_t*>(set.data()),
+                      static_cast<int>(set.size()));
+}
+
+}  // namespace tin::bufio
@@ -0,0 +1,34 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Delimiter scanning for bufio::Reader. A single byte goes to memchr,
+// which libc already vectorizes; a set of up to kMaxVectorSet bytes is
+// matched 32 (AVX2) or 16 (SSE2) bytes at a time, picked at run time on
+// x86-64; bigger sets and other targets use a lookup table.
+
+#ifndef TIN_BUFIO_SCAN_H_
+#define TIN_BUFIO_SCAN_H_
+
+#include <cstdint>
+
+#include <absl/strings/string_view.h>
+
+namespace tin::bufio {
+
+const int kMaxVectorSet = 4;
+
+// Returns the first byte in [begin, end) equal to c, or end.
+const uint8_t* ScanByte(const uint8_t* begin, const uint8_t* end, uint8_t c);
+
+// Returns the first byte in [begin, end) that is in set, or end. set must
+// not be empty.
+const uint8_t* ScanAny(const uint8_t* begin, const uint8_t* end,
+                       absl::string_view set);
+
+// The byte-at-a-time loop ScanAny falls back to; for tests and benchmarks.
+const uint8_t* ScanAnyScalar(const uint8_t* begin, const uint8_t* end,
+                             absl::string_view set);
+
+}  // namespace tin::bufio
+#endif  // TIN_BUFIO_SCAN_H_
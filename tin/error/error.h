@@ -104,7 +104,9 @@ enum tin_errno_t {
 
 int TinTranslateSysError(int sys_errno);
 
-int TinGetaddrinfoTranslateError(int sys_err);
+// Maps a getaddrinfo() return code; sys_errno is the errno of the
+// thread that called it, used for EAI_SYSTEM.
+int TinGetaddrinfoTranslateError(int gai_err, int sys_errno = 0);
 
 // SysErrorTranslator: RAII helper that translates a system errno to a tin
 // error code on scope exit. Usage:
@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <errno.h>
+#include <netdb.h>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -17,10 +18,42 @@ int TinTranslateSysError(int sys_errno) {
   return -sys_errno;
 }
 
-int TinGetaddrinfoTranslateError(int sys_errno) {
-  if (sys_errno <= 0) {
-    return sys_errno;  /* If < 0 then it's already a libuv error. */
+// gai_err is a getaddrinfo() return code only: the EAI_* values are
+// negative on glibc and positive on BSD/macOS, so they overlap errnos
+// and TIN_ codes either way. Errnos go through TinTranslateSysError.
+int TinGetaddrinfoTranslateError(int gai_err, int sys_errno) {
+  switch (gai_err) {
+  case 0: return 0;
+#if defined(EAI_ADDRFAMILY)
+  case EAI_ADDRFAMILY: return TIN_EAI_ADDRFAMILY;
+#endif
+  case EAI_AGAIN: return TIN_EAI_AGAIN;
+  case EAI_BADFLAGS: return TIN_EAI_BADFLAGS;
+#if defined(EAI_BADHINTS)
+  case EAI_BADHINTS: return TIN_EAI_BADHINTS;
+#endif
+#if defined(EAI_CANCELED)
+  case EAI_CANCELED: return TIN_EAI_CANCELED;
+#endif
+  case EAI_FAIL: return TIN_EAI_FAIL;
+  case EAI_FAMILY: return TIN_EAI_FAMILY;
+  case EAI_MEMORY: return TIN_EAI_MEMORY;
+#if defined(EAI_NODATA) && EAI_NODATA != EAI_NONAME
+  case EAI_NODATA: return TIN_EAI_NODATA;
+#endif
+  case EAI_NONAME: return TIN_EAI_NONAME;
+#if defined(EAI_OVERFLOW)
+  case EAI_OVERFLOW: return TIN_EAI_OVERFLOW;
+#endif
+#if defined(EAI_PROTOCOL)
+  case EAI_PROTOCOL: return TIN_EAI_PROTOCOL;
+#endif
+  case EAI_SERVICE: return TIN_EAI_SERVICE;
+  case EAI_SOCKTYPE: return TIN_EAI_SOCKTYPE;
+#if defined(EAI_SYSTEM)
+  case EAI_SYSTEM: return TinTranslateSysError(sys_errno);
+#endif
   }
-  return -sys_errno;
+  return TIN_EAI_FAIL;
 }
 
@@ -121,8 +121,8 @@ int TinTranslateSysError(int sys_errno) {
   }
 }
 
-int TinGetaddrinfoTranslateError(int sys_err) {
-  switch (sys_err) {
+int TinGetaddrinfoTranslateError(int gai_err, int sys_errno) {
+  switch (gai_err) {
   case 0:                       return 0;
   case WSATRY_AGAIN:            return TIN_EAI_AGAIN;
   case WSAEINVAL:               return TIN_EAI_BADFLAGS;
@@ -132,6 +132,6 @@ int TinGetaddrinfoTranslateError(int sys_err) {
   case WSAHOST_NOT_FOUND:       return TIN_EAI_NONAME;
   case WSATYPE_NOT_FOUND:       return TIN_EAI_SERVICE;
   case WSAESOCKTNOSUPPORT:      return TIN_EAI_SOCKTYPE;
-  default:                      return TinTranslateSysError(sys_err);
+  default:                      return TinTranslateSysError(gai_err);
   }
 }
@@ -4,6 +4,8 @@
 
 #include <absl/log/check.h>
 
+#include <memory>
+
 #include "tin/error/error.h"
 #include "tin/runtime/runtime.h"
 #include "tin/io/io.h"
@@ -48,4 +50,47 @@ Result<size_t> WriteString(Writer* writer, const absl::string_view& str) {
   return writer->Write(str.data(), static_cast<int>(str.size()));
 }
 
+Result<size_t> Copy(Writer* dst, Reader* src) {
+  if (WriterTo* wt = dynamic_cast<WriterTo*>(src)) {
+    return wt->WriteTo(dst);
+  }
+  if (ReaderFrom* rf = dynamic_cast<ReaderFrom*>(dst)) {
+    return rf->ReadFrom(src);
+  }
+  const int kCopyBufferSize = 32 * 1024;
+  std::unique_ptr<char[]> buf(new char[kCopyBufferSize]);
+  return CopyBuffer(dst, src, buf.get(), kCopyBufferSize);
+}
+
+Result<size_t> CopyBuffer(Writer* dst, Reader* src, void* buf, int len) {
+  size_t total = 0;
+  while (true) {
+    auto result = src->Read(buf, len);
+    size_t n = result.value_or(0);
+    size_t nw = 0;
+    while (nw < n) {
+      auto wresult = dst->Write(static_cast<char*>(buf) + nw,
+                                static_cast<int>(n - nw));
+      if (!wresult.ok()) {
+        return Result<size_t>::Err(wresult.status());
+      }
+      if (wresult.value() == 0) {
+        return Result<size_t>::Err(TIN_ENOPROGRESS);
+      }
+      nw += wresult.value();
+    }
+    total += n;
+    if (!result.ok()) {
+      if (result.code() == TIN_EOF) {
+        break;
+      }
+      return Result<size_t>::Err(result.status());
+    }
+    if (n == 0) {
+      break;
+    }
+  }
+  return Result<size_t>::Ok(total);
+}
+
 } // namespace tin::io
@@ -0,0 +1,450 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/log/check.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "tin/error/error.h"
+#include "tin/io/buffer_pool.h"
+#include "tin/io/io_buf.h"
+#include "tin/net/tcp_conn.h"
+
+namespace tin {
+
+namespace {
+
+// Slices per writev; well under IOV_MAX.
+const size_t kMaxWritevSlices = 64;
+// Smallest block Prepend allocates; the bytes go at its end, so later
+// prepends find room in front of them.
+const size_t kPrependBlockSize = 512;
+
+}  // namespace
+
+// A block header followed by capacity bytes, in one pooled buffer.
+struct IoBlock {
+  std::atomic<int> refs;
+  size_t capacity;
+
+  char* data() { return reinterpret_cast<char*>(this + 1); }
+
+  // size: the whole allocation; capacity is what the pool rounds it up
+  // to, less the header.
+  static IoBlock* New(size_t size) {
+    size_t total = 0;
+    void* p = io::AllocBuffer(std::max(size, sizeof(IoBlock) + 1), &total);
+    IoBlock* block = new (p) IoBlock;
+    block->refs.store(1, std::memory_order_relaxed);
+    block->capacity = total - sizeof(IoBlock);
+    return block;
+  }
+
+  void Ref() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+  void Unref() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      size_t total = sizeof(IoBlock) + capacity;
+      this->~IoBlock();
+      io::FreeBuffer(this, total);
+    }
+  }
+
+  // Only then may bytes outside the owner's slices be written.
+  bool unique() const { return refs.load(std::memory_order_acquire) == 1; }
+};
+
+IoBuf::IoBuf() : size_(0) {
+}
+
+IoBuf::~IoBuf() {
+  Clear();
+}
+
+IoBuf::IoBuf(const IoBuf& other) : size_(0) {
+  Append(other);
+}
+
+IoBuf& IoBuf::operator=(const IoBuf& other) {
+  if (this != &other) {
+    Clear();
+    Append(other);
+  }
+  return *this;
+}
+
+IoBuf::IoBuf(IoBuf&& other) noexcept
+  : slices_(std::move(other.slices_))
+  , size_(other.size_) {
+  other.slices_.clear();
+  other.size_ = 0;
+}
+
+IoBuf& IoBuf::operator=(IoBuf&& other) noexcept {
+  if (this != &other) {
+    Clear();
+    slices_.swap(other.slices_);
+    size_ = other.size_;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+void IoBuf::Clear() {
+  for (const Slice& s : slices_) {
+    s.block->Unref();
+  }
+  slices_.clear();
+  size_ = 0;
+}
+
+// Takes over the reference s holds. A slice that continues the last one
+// in the same block is merged into it.
+void IoBuf::AppendSlice(const Slice& s) {
+  size_ += s.len;
+  if (!slices_.empty()) {
+    Slice& last = slices_.back();
+    if (last.block == s.block && last.off + last.len == s.off) {
+      last.len += s.len;
+      s.block->Unref();
+      return;
+    }
+  }
+  slices_.push_back(s);
+}
+
+void IoBuf::PrependSlice(const Slice& s) {
+  size_ += s.len;
+  if (!slices_.empty()) {
+    Slice& first = slices_.front();
+    if (first.block == s.block && s.off + s.len == first.off) {
+      first.off = s.off;
+      first.len += s.len;
+      s.block->Unref();
+      return;
+    }
+  }
+  slices_.push_front(s);
+}
+
+void IoBuf::Append(const void* data, size_t n) {
+  const char* p = static_cast<const char*>(data);
+  while (n > 0) {
+    io::MutableBuffer space = PrepareAppend(std::min(n, kBlockSize));
+    size_t chunk = std::min(n, space.size);
+    std::memcpy(space.data, p, chunk);
+    CommitAppend(chunk);
+    p += chunk;
+    n -= chunk;
+  }
+}
+
+void IoBuf::Append(const IoBuf& other) {
+  if (&other == this) {
+    IoBuf copy(other);
+    Append(std::move(copy));
+    return;
+  }
+  for (const Slice& s : other.slices_) {
+    s.block->Ref();
+    AppendSlice(s);
+  }
+}
+
+void IoBuf::Append(IoBuf&& other) {
+  if (&other == this) {
+    Append(static_cast<const IoBuf&>(other));
+    return;
+  }
+  for (const Slice& s : other.slices_) {
+    AppendSlice(s);
+  }
+  other.slices_.clear();
+  other.size_ = 0;
+}
+
+void IoBuf::Prepend(const void* data, size_t n) {
+  if (n == 0) {
+    return;
+  }
+  if (!slices_.empty()) {
+    Slice& first = slices_.front();
+    if (first.off >= n && first.block->unique()) {
+      first.off -= n;
+      first.len += n;
+      std::memcpy(first.block->data() + first.off, data, n);
+      size_ += n;
+      return;
+    }
+  }
+  IoBlock* block = IoBlock::New(std::max(sizeof(IoBlock) + n,
+                                         kPrependBlockSize));
+  size_t off = block->capacity - n;
+  std::memcpy(block->data() + off, data, n);
+  PrependSlice({block, off, n});
+}
+
+void IoBuf::Prepend(const IoBuf& other) {
+  if (&other == this) {
+    IoBuf copy(other);
+    Prepend(std::move(copy));
+    return;
+  }
+  for (auto it = other.slices_.rbegin(); it != other.slices_.rend(); ++it) {
+    it->block->Ref();
+    PrependSlice(*it);
+  }
+}
+
+void IoBuf::Prepend(IoBuf&& other) {
+  if (&other == this) {
+    Prepend(static_cast<const IoBuf&>(other));
+    return;
+  }
+  for (auto it = other.slices_.rbegin(); it != other.slices_.rend(); ++it) {
+    PrependSlice(*it);
+  }
+  other.slices_.clear();
+  other.size_ = 0;
+}
+
+IoBuf IoBuf::Cut(size_t n) {
+  IoBuf front;
+  n = std::min(n, size_);
+  while (n > 0) {
+    Slice& first = slices_.front();
+    if (first.len <= n) {
+      n -= first.len;
+      size_ -= first.len;
+      front.AppendSlice(first);
+      slices_.pop_front();
+    } else {
+      first.block->Ref();
+      front.AppendSlice({first.block, first.off, n});
+      first.off += n;
+      first.len -= n;
+      size_ -= n;
+      n = 0;
+    }
+  }
+  return front;
+}
+
+void IoBuf::TrimFront(size_t n) {
+  n = std::min(n, size_);
+  size_ -= n;
+  while (n > 0) {
+    Slice& first = slices_.front();
+    if (first.len <= n) {
+      n -= first.len;
+      first.block->Unref();
+      slices_.pop_front();
+    } else {
+      first.off += n;
+      first.len -= n;
+      n = 0;
+    }
+  }
+}
+
+void IoBuf::TrimBack(size_t n) {
+  n = std::min(n, size_);
+  size_ -= n;
+  while (n > 0) {
+    Slice& last = slices_.back();
+    if (last.len <= n) {
+      n -= last.len;
+      last.block->Unref();
+      slices_.pop_back();
+    } else {
+      last.len -= n;
+      n = 0;
+    }
+  }
+}
+
+IoBuf IoBuf::Sub(size_t pos, size_t n) const {
+  IoBuf sub;
+  if (pos >= size_) {
+    return sub;
+  }
+  n = std::min(n, size_ - pos);
+  for (const Slice& s : slices_) {
+    if (n == 0) {
+      break;
+    }
+    if (pos >= s.len) {
+      pos -= s.len;
+      continue;
+    }
+    size_t len = std::min(n, s.len - pos);
+    s.block->Ref();
+    sub.AppendSlice({s.block, s.off + pos, len});
+    n -= len;
+    pos = 0;
+  }
+  return sub;
+}
+
+size_t IoBuf::CopyTo(void* dst, size_t n, size_t pos) const {
+  char* out = static_cast<char*>(dst);
+  size_t copied = 0;
+  for (const Slice& s : slices_) {
+    if (copied == n) {
+      break;
+    }
+    if (pos >= s.len) {
+      pos -= s.len;
+      continue;
+    }
+    size_t len = std::min(n - copied, s.len - pos);
+    std::memcpy(out + copied, s.block->data() + s.off + pos, len);
+    copied += len;
+    pos = 0;
+  }
+  return copied;
+}
+
+std::string IoBuf::ToString() const {
+  std::string str(size_, '\0');
+  CopyTo(&str[0], size_);
+  return str;
+}
+
+void IoBuf::GetBuffers(std::vector<io::ConstBuffer>* out) const {
+  out->reserve(out->size() + slices_.size());
+  for (const Slice& s : slices_) {
+    out->emplace_back(s.block->data() + s.off, s.len);
+  }
+}
+
+io::MutableBuffer IoBuf::PrepareAppend(size_t min) {
+  min = std::max<size_t>(min, 1);
+  if (!slices_.empty()) {
+    const Slice& last = slices_.back();
+    size_t end = last.off + last.len;
+    if (last.block->capacity - end >= min && last.block->unique()) {
+      return io::MutableBuffer(last.block->data() + end,
+                               last.block->capacity - end);
+    }
+    if (last.len == 0) {
+      // Left by an earlier PrepareAppend that was never committed.
+      last.block->Unref();
+      slices_.pop_back();
+    }
+  }
+  IoBlock* block = IoBlock::New(std::max(sizeof(IoBlock) + min,
+                                         kBlockSize));
+  // Held as an empty slice until CommitAppend fills it.
+  slices_.push_back({block, 0, 0});
+  return io::MutableBuffer(block->data(), block->capacity);
+}
+
+void IoBuf::CommitAppend(size_t n) {
+  DCHECK(!slices_.empty());
+  Slice& last = slices_.back();
+  DCHECK_LE(last.off + last.len + n, last.block->capacity);
+  last.len += n;
+  size_ += n;
+}
+
+Result<size_t> IoBuf::ReadOnce(io::Reader* r) {
+  io::MutableBuffer space = PrepareAppend();
+  int len = static_cast<int>(std::min<size_t>(space.size, INT_MAX));
+  auto result = r->Read(space.data, len);
+  if (result.ok()) {
+    CommitAppend(*result);
+  }
+  if (slices_.back().len == 0) {
+    slices_.back().block->Unref();
+    slices_.pop_back();
+  }
+  return result;
+}
+
+Result<size_t> IoBuf::Read(void* buf, int nbytes) {
+  if (nbytes <= 0) {
+    return Result<size_t>::Ok(0);
+  }
+  if (empty()) {
+    return Result<size_t>::Err(TIN_EOF);
+  }
+  size_t n = CopyTo(buf, static_cast<size_t>(nbytes));
+  TrimFront(n);
+  return Result<size_t>::Ok(n);
+}
+
+Result<size_t> IoBuf::Write(const void* buf, int nbytes) {
+  if (nbytes <= 0) {
+    return Result<size_t>::Ok(0);
+  }
+  Append(buf, static_cast<size_t>(nbytes));
+  return Result<size_t>::Ok(static_cast<size_t>(nbytes));
+}
+
+Result<size_t> IoBuf::ReadFrom(io::Reader* r) {
+  size_t total = 0;
+  while (true) {
+    auto result = ReadOnce(r);
+    if (!result.ok()) {
+      if (result.code() == TIN_EOF) {
+        break;
+      }
+      return Result<size_t>::Err(result.status());
+    }
+    if (*result == 0) {
+      break;
+    }
+    total += *result;
+  }
+  return Result<size_t>::Ok(total);
+}
+
+Result<size_t> IoBuf::WriteTo(io::Writer* w) {
+  size_t total = 0;
+  net::TcpConn* conn = dynamic_cast<net::TcpConn*>(w);
+  std::vector<io::ConstBuffer> bufs;
+  while (!slices_.empty()) {
+    size_t count = std::min(slices_.size(), kMaxWritevSlices);
+    size_t bytes = 0;
+    if (conn != nullptr && count > 1) {
+      bufs.clear();
+      for (size_t i = 0; i < count; ++i) {
+        const Slice& s = slices_[i];
+        bufs.emplace_back(s.block->data() + s.off, s.len);
+        bytes += s.len;
+      }
+      auto result = conn->Writev(bufs);
+      if (!result.ok()) {
+        return Result<size_t>::Err(result.status());
+      }
+    } else {
+      const Slice& s = slices_.front();
+      bytes = s.len;
+      size_t written = 0;
+      while (written < bytes) {
+        auto result = w->Write(s.block->data() + s.off + written,
+                               static_cast<int>(std::min<size_t>(
+                                   bytes - written, INT_MAX)));
+        if (!result.ok()) {
+          return Result<size_t>::Err(result.status());
+        }
+        if (*result == 0) {
+          return Result<size_t>::Err(TIN_ENOPROGRESS);
+        }
+        written += *result;
+      }
+    }
+    TrimFront(bytes);
+    total += bytes;
+  }
+  return Result<size_t>::Ok(total);
+}
+
+}  // namespace tin
@@ -2,8 +2,11 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <cstring>
+
 #include <absl/log/log.h>
 #include <absl/log/check.h>
+#include "tin/io/buffer_pool.h"
 #include "tin/io/io_buffer.h"
 
 // Some of the following member functions are marked inlined, even though they
@@ -21,11 +24,21 @@ namespace tin {
 
 static const int kInitialIoBufferSize = 32;
 
+// Storage comes from the I/O buffer pool; *size is raised to the
+// capacity the pool hands out.
+static char* NewStorage(int* size) {
+  size_t capacity = 0;
+  char* storage = static_cast<char*>(
+      io::AllocBuffer(static_cast<size_t>(*size), &capacity));
+  *size = static_cast<int>(capacity);
+  return storage;
+}
+
 IoBuffer::IoBuffer()
-  : storage_(new char[kInitialIoBufferSize]),
-    write_idx_(0),
+  : write_idx_(0),
     read_idx_(0),
     storage_size_(kInitialIoBufferSize) {
+  storage_ = NewStorage(&storage_size_);
 }
 
 IoBuffer::IoBuffer(size_t size)
@@ -35,11 +48,11 @@ IoBuffer::IoBuffer(size_t size)
   // Callers may try to allocate overly large blocks, but negative sizes are
   // obviously wrong.
   CHECK_GE(size, 0u);
-  storage_ = new char[size];
+  storage_ = NewStorage(&storage_size_);
 }
 
 IoBuffer::~IoBuffer() {
-  delete[] storage_;
+  io::FreeBuffer(storage_, storage_size_);
 }
 
 std::string IoBuffer::str() const {
@@ -97,8 +110,8 @@ int IoBuffer::Read(char* bytes, size_t sz) {
 
 
 void IoBuffer::Reset(int size = kInitialIoBufferSize) {
-  delete[] storage_;
-  storage_ = new char[size],
+  io::FreeBuffer(storage_, storage_size_);
+  storage_ = NewStorage(&size);
   write_idx_ = 0;
   read_idx_ = 0;
   storage_size_ = size;
@@ -132,14 +145,14 @@ bool IoBuffer::ReserveMore(int size) {
       }
 
       // have to extend the thing
-      char* new_storage = new char[new_storage_size];
+      char* new_storage = NewStorage(&new_storage_size);
 
       // copy still useful info to the new buffer.
       memcpy(new_storage, read_ptr, read_size);
       // reset pointers.
       read_idx_ = 0;
       write_idx_ = read_size;
-      delete[] storage_;
+      io::FreeBuffer(storage_, storage_size_);
       storage_ = new_storage;
       storage_size_ = new_storage_size;
     }
@@ -0,0 +1,241 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "build/build_config.h"
+
+#if defined(OS_LINUX)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "base/memory/page_size.h"
+#include "tin/io/buffer_pool.h"
+#include "tin/io/io_ring_buffer.h"
+
+namespace tin {
+
+namespace {
+
+const size_t kInitialIoRingBufferSize = 64 * 1024;
+
+size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t size = 1;
+  while (size < n) {
+    size <<= 1;
+  }
+  return size;
+}
+
+#if defined(OS_LINUX) && defined(SYS_memfd_create)
+// Maps size bytes of one memfd twice, back to back. Returns nullptr if
+// any step fails; the caller falls back to plain storage.
+char* MapMirror(size_t size) {
+  int fd = static_cast<int>(syscall(SYS_memfd_create, "tin-ring",
+                                         1u /* MFD_CLOEXEC */));
+  if (fd < 0) {
+    return nullptr;
+  }
+  char* base = nullptr;
+  if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+    // Reserve both halves first so nothing else lands in the second.
+    void* vp = mmap(nullptr, 2 * size, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (vp != MAP_FAILED) {
+      base = static_cast<char*>(vp);
+      for (int i = 0; i < 2 && base != nullptr; ++i) {
+        void* half = mmap(base + i * size, size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_FIXED, fd, 0);
+        if (half == MAP_FAILED) {
+          munmap(base, 2 * size);
+          base = nullptr;
+        }
+      }
+    }
+  }
+  // The mappings keep the memory alive.
+  close(fd);
+  return base;
+}
+
+void UnmapMirror(char* base, size_t size) {
+  munmap(base, 2 * size);
+}
+#else
+char* MapMirror(size_t) {
+  return nullptr;
+}
+
+void UnmapMirror(char*, size_t) {
+}
+#endif
+
+}  // namespace
+
+IoRingBuffer::IoRingBuffer()
+  : IoRingBuffer(kInitialIoRingBufferSize) {
+}
+
+IoRingBuffer::IoRingBuffer(size_t size)
+  : storage_(nullptr),
+    storage_size_(0),
+    read_idx_(0),
+    write_idx_(0),
+    mirrored_(false) {
+  Allocate(size);
+}
+
+IoRingBuffer::~IoRingBuffer() {
+  Release();
+}
+
+IoRingBuffer::IoRingBuffer(IoRingBuffer&& rvalue) noexcept
+  : storage_(nullptr),
+    storage_size_(0),
+    read_idx_(0),
+    write_idx_(0),
+    mirrored_(false) {
+  Swap(&rvalue);
+}
+
+IoRingBuffer& IoRingBuffer::operator=(IoRingBuffer&& rvalue) noexcept {
+  if (this != &rvalue) {
+    Release();
+    Swap(&rvalue);
+  }
+  return *this;
+}
+
+void IoRingBuffer::Allocate(size_t size) {
+  size = RoundUpToPowerOfTwo(std::max<size_t>(size, 1));
+  size_t mirror_size = std::max(size, base::GetPageSize());
+  storage_ = MapMirror(mirror_size);
+  if (storage_ != nullptr) {
+    storage_size_ = mirror_size;
+    mirrored_ = true;
+  } else {
+    storage_ = static_cast<char*>(io::AllocBuffer(size, &storage_size_));
+    mirrored_ = false;
+  }
+  read_idx_ = 0;
+  write_idx_ = 0;
+}
+
+void IoRingBuffer::Release() {
+  if (storage_ == nullptr) {
+    return;
+  }
+  if (mirrored_) {
+    UnmapMirror(storage_, storage_size_);
+  } else {
+    io::FreeBuffer(storage_, storage_size_);
+  }
+  storage_ = nullptr;
+  storage_size_ = 0;
+  read_idx_ = 0;
+  write_idx_ = 0;
+}
+
+std::string IoRingBuffer::str() const {
+  char* readable_ptr;
+  int readable_size;
+  GetReadablePtr(&readable_ptr, &readable_size);
+  return std::string(readable_ptr, readable_size);
+}
+
+int IoRingBuffer::Write(const void* ptr, size_t sz) {
+  int size = static_cast<int>(sz);
+  (void)ReserveMore(size);
+  const char* bytes = static_cast<const char*>(ptr);
+  int left = size;
+  // One pass with the mirror; the fallback may need a second after
+  // compacting.
+  while (left > 0) {
+    char* write_ptr = nullptr;
+    int write_size = 0;
+    GetWritablePtr(&write_ptr, &write_size);
+    write_size = std::min(write_size, left);
+    memcpy(write_ptr, bytes, write_size);
+    AdvanceWritablePtr(write_size);
+    bytes += write_size;
+    left -= write_size;
+  }
+  return size;
+}
+
+void IoRingBuffer::GetWritablePtr(char** ptr, int* size) {
+  if (!mirrored_ && read_idx_ > storage_size_ - write_idx_) {
+    // No mirror to run into: reclaim the read bytes by shifting, but only
+    // once they outgrow the tail, so the tail is at least half of free().
+    memmove(storage_, storage_ + read_idx_, buffered());
+    write_idx_ -= read_idx_;
+    read_idx_ = 0;
+  }
+  *ptr = storage_ + write_idx_;
+  *size = mirrored_ ? free() : static_cast<int>(storage_size_ - write_idx_);
+}
+
+void IoRingBuffer::GetReadablePtr(char** ptr, int* size) const {
+  *ptr = storage_ + read_idx_;
+  *size = buffered();
+}
+
+int IoRingBuffer::Read(char* bytes, size_t sz) {
+  int size = static_cast<int>(sz);
+  char* read_ptr = nullptr;
+  int read_size = 0;
+  GetReadablePtr(&read_ptr, &read_size);
+  if (read_size > size) {
+    read_size = size;
+  }
+  memcpy(bytes, read_ptr, read_size);
+  AdvanceReadablePtr(read_size);
+  return read_size;
+}
+
+bool IoRingBuffer::ReserveMore(int size) {
+  if (size <= 0 || free() >= size) {
+    return false;
+  }
+  char* read_ptr = nullptr;
+  int read_size = 0;
+  GetReadablePtr(&read_ptr, &read_size);
+
+  IoRingBuffer larger(std::max(2 * storage_size_,
+                               static_cast<size_t>(read_size + size)));
+  memcpy(larger.storage_, read_ptr, read_size);
+  larger.write_idx_ = read_size;
+  Swap(&larger);
+  return true;
+}
+
+void IoRingBuffer::AdvanceReadablePtr(int amount_to_advance) {
+  read_idx_ = std::min(read_idx_ + amount_to_advance, write_idx_);
+  if (read_idx_ == write_idx_) {
+    read_idx_ = write_idx_ = 0;
+  } else if (read_idx_ >= storage_size_) {
+    // Only with the mirror: move back into the first mapping.
+    read_idx_ -= storage_size_;
+    write_idx_ -= storage_size_;
+  }
+}
+
+void IoRingBuffer::AdvanceWritablePtr(int amount_to_advance) {
+  size_t limit = mirrored_ ? read_idx_ + storage_size_ : storage_size_;
+  write_idx_ = std::min(write_idx_ + amount_to_advance, limit);
+}
+
+void IoRingBuffer::Swap(IoRingBuffer* other) {
+  std::swap(storage_, other->storage_);
+  std::swap(storage_size_, other->storage_size_);
+  std::swap(read_idx_, other->read_idx_);
+  std::swap(write_idx_, other->write_idx_);
+  std::swap(mirrored_, other->mirrored_);
+}
+
+}  // namespace tin
@@ -16,7 +16,8 @@ enum AddressFamily {
   ADDRESS_FAMILY_UNSPECIFIED,   // AF_UNSPEC
   ADDRESS_FAMILY_IPV4,          // AF_INET
   ADDRESS_FAMILY_IPV6,          // AF_INET6
-  ADDRESS_FAMILY_LAST = ADDRESS_FAMILY_IPV6
+  ADDRESS_FAMILY_UNIX,          // AF_UNIX, sockets only
+  ADDRESS_FAMILY_LAST = ADDRESS_FAMILY_UNIX
 };
 
 // HostResolverFlags is a bitflag enum used by host resolver procedures to
@@ -36,7 +37,7 @@ using HostResolverFlags = int;
 // Returns AddressFamily for |address|.
 AddressFamily GetAddressFamily(const IpAddress& address);
 
-// Maps the given AddressFamily to either AF_INET, AF_INET6 or AF_UNSPEC.
+// Maps the given AddressFamily to AF_INET, AF_INET6, AF_UNIX or AF_UNSPEC.
 int ConvertAddressFamily(AddressFamily address_family);
 
 }  // namespace tin::net
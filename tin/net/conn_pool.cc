@@ -0,0 +1,497 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_cat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tin/communication/chan.h"
+#include "tin/error/error.h"
+#include "tin/net/conn_pool.h"
+#include "tin/net/dialer.h"
+#include "tin/net/tcp_conn_impl.h"  // internal: ProbeIdleTcpConn
+#include "tin/runtime/env.h"
+#include "tin/runtime/p.h"
+#include "tin/runtime/util.h"
+#include "tin/sync/mutex.h"
+#include "tin/sync/rwmutex.h"
+#include "tin/time.h"
+#include "tin/time/timer.h"
+
+namespace tin::net {
+
+namespace {
+
+struct IdleConn {
+  TcpConn conn;
+  int64_t since;  // MonoNow() when it went idle
+};
+
+// One P's idle connections to an endpoint; used LIFO so the warmest
+// connection goes out first.
+struct IdleList {
+  Mutex mu;
+  std::vector<IdleConn> conns;
+};
+
+// A Get blocked on max_active. Whoever frees a connection or a slot
+// hands it over under the entry lock and pushes to wake; the timeout
+// timer, if it finds the waiter still queued, dequeues it and pushes.
+struct PoolWaiter {
+  PoolWaiter() : wake(1), granted(false) {}
+  Chan<int> wake;
+  bool granted;  // guarded by ConnPoolEntry::mu
+  TcpConn conn;  // the handed-over connection; invalid for a dial slot
+};
+
+}  // namespace
+
+struct ConnPoolEntry {
+  ConnPoolEntry(std::string h, uint16_t p, const IpEndpoint& ep, int n)
+    : host(std::move(h))
+    , port(p)
+    , endpoint(ep)
+    , nlists(n)
+    , idle(new IdleList[n])
+    , nidle(0)
+    , nwaiters(0)
+    , open(0) {
+  }
+
+  const std::string host;  // resolved per dial when non-empty
+  const uint16_t port;
+  const IpEndpoint endpoint;
+  const int nlists;
+  std::unique_ptr<IdleList[]> idle;
+  std::atomic<int> nidle;
+  std::atomic<int> nwaiters;
+
+  Mutex mu;
+  int open;  // idle + checked out + dialing
+  std::deque<std::shared_ptr<PoolWaiter>> waiters;
+};
+
+class ConnPoolImpl : public std::enable_shared_from_this<ConnPoolImpl> {
+ public:
+  explicit ConnPoolImpl(const ConnPoolOptions& options)
+    : options_(options)
+    , closed_(false)
+    , reaper_armed_(false) {
+  }
+
+  Result<PooledConn> Get(const std::string& key, const std::string& host,
+                         uint16_t port, const IpEndpoint& endpoint,
+                         int64_t timeout);
+  void Put(ConnPoolEntry* e, TcpConn conn);
+  void Drop(ConnPoolEntry* e, TcpConn conn);
+  // Frees e's max_active slot, or hands it to a waiter.
+  void ReleaseSlot(ConnPoolEntry* e);
+  void CloseIdle();
+  void Shutdown();
+
+ private:
+  ConnPoolEntry* Lookup(const std::string& key, const std::string& host,
+                        uint16_t port, const IpEndpoint& endpoint);
+  bool TakeIdle(ConnPoolEntry* e, TcpConn* conn);
+  // Caller holds e->mu and e->waiters is not empty.
+  void GrantLocked(ConnPoolEntry* e, TcpConn conn);
+  // Hands idle connections (or, for dead ones, their slots) to queued
+  // waiters.
+  void Kick(ConnPoolEntry* e);
+  Result<PooledConn> Dial(ConnPoolEntry* e, int64_t timeout);
+  void ArmReaper();
+  void Reap();
+
+  const ConnPoolOptions options_;
+  std::atomic<bool> closed_;
+
+  RWMutex entries_mu_;
+  std::unordered_map<std::string, std::unique_ptr<ConnPoolEntry>> entries_;
+
+  Mutex reaper_mu_;
+  bool reaper_armed_;
+  std::unique_ptr<Timer> reaper_;
+};
+
+ConnPoolEntry* ConnPoolImpl::Lookup(const std::string& key,
+                                    const std::string& host, uint16_t port,
+                                    const IpEndpoint& endpoint) {
+  {
+    MutexReaderGuard guard(&entries_mu_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      return it->second.get();
+    }
+  }
+  MutexWriterGuard guard(&entries_mu_);
+  std::unique_ptr<ConnPoolEntry>& e = entries_[key];
+  if (e == nullptr) {
+    int nlists = std::max(1, runtime::rtm_conf->MaxProcs());
+    e.reset(new ConnPoolEntry(host, port, endpoint, nlists));
+  }
+  return e.get();
+}
+
+bool ConnPoolImpl::TakeIdle(ConnPoolEntry* e, TcpConn* conn) {
+  if (e->nidle.load() == 0) {
+    return false;
+  }
+  runtime::P* p = runtime::GetP();
+  int first = (p != nullptr ? p->Id() : 0) % e->nlists;
+  for (int i = 0; i < e->nlists; i++) {
+    IdleList& list = e->idle[(first + i) % e->nlists];
+    MutexGuard guard(&list.mu);
+    if (!list.conns.empty()) {
+      *conn = std::move(list.conns.back().conn);
+      list.conns.pop_back();
+      e->nidle--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ConnPoolImpl::GrantLocked(ConnPoolEntry* e, TcpConn conn) {
+  std::shared_ptr<PoolWaiter> w = std::move(e->waiters.front());
+  e->waiters.pop_front();
+  e->nwaiters--;
+  w->granted = true;
+  w->conn = std::move(conn);
+  w->wake->TryPush(1);
+}
+
+void ConnPoolImpl::ReleaseSlot(ConnPoolEntry* e) {
+  MutexGuard guard(&e->mu);
+  if (!e->waiters.empty()) {
+    GrantLocked(e, TcpConn());
+  } else {
+    e->open--;
+  }
+}
+
+void ConnPoolImpl::Kick(ConnPoolEntry* e) {
+  MutexGuard guard(&e->mu);
+  TcpConn conn;
+  while (!e->waiters.empty() && TakeIdle(e, &conn)) {
+    // Probed like the idle connections Get takes itself. A dead one's
+    // slot goes to the waiter to dial with (ReleaseSlot, under e->mu).
+    if (!ProbeIdleTcpConn(conn)) {
+      conn.Close();
+      conn = TcpConn();
+    }
+    GrantLocked(e, std::move(conn));
+  }
+}
+
+void ConnPoolImpl::Drop(ConnPoolEntry* e, TcpConn conn) {
+  conn.Close();
+  ReleaseSlot(e);
+}
+
+void ConnPoolImpl::Put(ConnPoolEntry* e, TcpConn conn) {
+  if (closed_.load()) {
+    Drop(e, std::move(conn));
+    return;
+  }
+  if (e->nwaiters.load() > 0) {
+    MutexGuard guard(&e->mu);
+    if (!e->waiters.empty()) {
+      GrantLocked(e, std::move(conn));
+      return;
+    }
+  }
+  if (e->nidle.fetch_add(1) >= options_.max_idle) {
+    e->nidle--;
+    Drop(e, std::move(conn));
+    return;
+  }
+  runtime::P* p = runtime::GetP();
+  IdleList& list = e->idle[(p != nullptr ? p->Id() : 0) % e->nlists];
+  {
+    MutexGuard guard(&list.mu);
+    list.conns.push_back(IdleConn{std::move(conn), MonoNow()});
+  }
+  // A Get may have queued itself after the nwaiters check above and
+  // before the push; it then relies on us to hand the connection over.
+  if (e->nwaiters.load() > 0) {
+    Kick(e);
+  }
+  ArmReaper();
+}
+
+Result<PooledConn> ConnPoolImpl::Dial(ConnPoolEntry* e, int64_t timeout) {
+  // Hostnames go through the DNS cache and Happy Eyeballs in DialTcp.
+  Result<TcpConn> conn =
+      !e->host.empty()
+          ? (timeout > 0 ? DialTcpTimeout(e->host, e->port, timeout)
+                         : DialTcp(e->host, e->port))
+          : (timeout > 0
+                 ? DialTcpTimeout(e->endpoint.address(), e->port, timeout)
+                 : DialTcp(e->endpoint.address(), e->port));
+  if (!conn.ok()) {
+    ReleaseSlot(e);
+    return Result<PooledConn>::Err(conn.status());
+  }
+  return Result<PooledConn>::Ok(
+      PooledConn(shared_from_this(), e, std::move(*conn)));
+}
+
+Result<PooledConn> ConnPoolImpl::Get(const std::string& key,
+                                     const std::string& host, uint16_t port,
+                                     const IpEndpoint& endpoint,
+                                     int64_t timeout) {
+  int64_t deadline = timeout > 0 ? MonoNow() + timeout : 0;
+  ConnPoolEntry* e = Lookup(key, host, port, endpoint);
+  TcpConn conn;
+  while (TakeIdle(e, &conn)) {
+    if (ProbeIdleTcpConn(conn)) {
+      return Result<PooledConn>::Ok(
+          PooledConn(shared_from_this(), e, std::move(conn)));
+    }
+    Drop(e, std::move(conn));
+  }
+
+  std::shared_ptr<PoolWaiter> w;
+  {
+    MutexGuard guard(&e->mu);
+    if (options_.max_active <= 0 || e->open < options_.max_active) {
+      e->open++;
+      w = nullptr;
+    } else {
+      w = std::make_shared<PoolWaiter>();
+      e->waiters.push_back(w);
+      e->nwaiters++;
+    }
+  }
+  if (w == nullptr) {
+    return Dial(e, timeout);
+  }
+
+  // Pick up anything Put left idle before it could see us queued.
+  Kick(e);
+  std::unique_ptr<Timer> timer;
+  if (timeout > 0) {
+    std::shared_ptr<ConnPoolImpl> self = shared_from_this();
+    timer.reset(new Timer(AfterFunc(timeout, [self, e, w]() {
+      MutexGuard guard(&e->mu);
+      auto it = std::find(e->waiters.begin(), e->waiters.end(), w);
+      if (it != e->waiters.end()) {
+        e->waiters.erase(it);
+        e->nwaiters--;
+        w->wake->TryPush(0);
+      }
+    })));
+  }
+  int v = 0;
+  w->wake->Pop(&v);
+  if (timer != nullptr) {
+    timer->Stop();
+  }
+  bool granted;
+  {
+    MutexGuard guard(&e->mu);
+    granted = w->granted;
+    conn = std::move(w->conn);
+  }
+  if (!granted) {
+    return Result<PooledConn>::Err(TIN_ETIMEDOUT);
+  }
+  if (!conn.IsValid()) {
+    // The wait used up part of the timeout; dial with what is left.
+    if (deadline == 0) {
+      return Dial(e, 0);
+    }
+    int64_t remaining = deadline - MonoNow();
+    if (remaining <= 0) {
+      ReleaseSlot(e);
+      return Result<PooledConn>::Err(TIN_ETIMEDOUT);
+    }
+    return Dial(e, remaining);
+  }
+  return Result<PooledConn>::Ok(
+      PooledConn(shared_from_this(), e, std::move(conn)));
+}
+
+void ConnPoolImpl::ArmReaper() {
+  MutexGuard guard(&reaper_mu_);
+  if (reaper_armed_ || closed_.load() || options_.idle_timeout <= 0) {
+    return;
+  }
+  reaper_armed_ = true;
+  std::weak_ptr<ConnPoolImpl> weak = weak_from_this();
+  reaper_.reset(new Timer(AfterFunc(options_.idle_timeout / 2, [weak]() {
+    if (std::shared_ptr<ConnPoolImpl> self = weak.lock()) {
+      self->Reap();
+    }
+  })));
+}
+
+void ConnPoolImpl::Reap() {
+  {
+    MutexGuard guard(&reaper_mu_);
+    reaper_armed_ = false;
+  }
+  int64_t expiry = MonoNow() - options_.idle_timeout;
+  bool any_idle = false;
+  MutexReaderGuard guard(&entries_mu_);
+  for (auto& kv : entries_) {
+    ConnPoolEntry* e = kv.second.get();
+    for (int i = 0; i < e->nlists; i++) {
+      std::vector<IdleConn> expired;
+      {
+        IdleList& list = e->idle[i];
+        MutexGuard list_guard(&list.mu);
+        // Connections are pushed in the order they went idle.
+        auto keep = std::find_if(list.conns.begin(), list.conns.end(),
+                                 [expiry](const IdleConn& c) {
+                                   return c.since > expiry;
+                                 });
+        std::move(list.conns.begin(), keep, std::back_inserter(expired));
+        list.conns.erase(list.conns.begin(), keep);
+      }
+      for (IdleConn& c : expired) {
+        e->nidle--;
+        Drop(e, std::move(c.conn));
+      }
+    }
+    any_idle = any_idle || e->nidle.load() > 0;
+  }
+  if (any_idle) {
+    ArmReaper();
+  }
+}
+
+void ConnPoolImpl::CloseIdle() {
+  MutexReaderGuard guard(&entries_mu_);
+  for (auto& kv : entries_) {
+    ConnPoolEntry* e = kv.second.get();
+    for (int i = 0; i < e->nlists; i++) {
+      std::vector<IdleConn> conns;
+      {
+        IdleList& list = e->idle[i];
+        MutexGuard list_guard(&list.mu);
+        conns.swap(list.conns);
+      }
+      for (IdleConn& c : conns) {
+        e->nidle--;
+        Drop(e, std::move(c.conn));
+      }
+    }
+  }
+}
+
+void ConnPoolImpl::Shutdown() {
+  closed_.store(true);
+  {
+    MutexGuard guard(&reaper_mu_);
+    if (reaper_ != nullptr) {
+      reaper_->Stop();
+    }
+  }
+  CloseIdle();
+}
+
+// ---------------------------------------------------------------------------
+// PooledConn
+// ---------------------------------------------------------------------------
+
+PooledConn::PooledConn(std::shared_ptr<ConnPoolImpl> pool,
+                       ConnPoolEntry* entry, TcpConn conn)
+  : pool_(std::move(pool))
+  , entry_(entry)
+  , conn_(std::move(conn)) {
+}
+
+PooledConn::~PooledConn() {
+  Release();
+}
+
+PooledConn::PooledConn(PooledConn&& other) noexcept
+  : pool_(std::move(other.pool_))
+  , entry_(other.entry_)
+  , conn_(std::move(other.conn_)) {
+  other.entry_ = nullptr;
+}
+
+PooledConn& PooledConn::operator=(PooledConn&& other) noexcept {
+  if (this != &other) {
+    Release();
+    pool_ = std::move(other.pool_);
+    entry_ = other.entry_;
+    conn_ = std::move(other.conn_);
+    other.entry_ = nullptr;
+  }
+  return *this;
+}
+
+// The caller may have taken the connection out of conn(); the slot it
+// held still has to be given back.
+void PooledConn::Release() {
+  if (pool_ != nullptr) {
+    if (conn_.IsValid()) {
+      pool_->Put(entry_, std::move(conn_));
+    } else {
+      pool_->ReleaseSlot(entry_);
+    }
+  }
+  conn_ = TcpConn();
+  pool_.reset();
+  entry_ = nullptr;
+}
+
+void PooledConn::Discard() {
+  if (pool_ != nullptr) {
+    if (conn_.IsValid()) {
+      pool_->Drop(entry_, std::move(conn_));
+    } else {
+      pool_->ReleaseSlot(entry_);
+    }
+  }
+  conn_ = TcpConn();
+  pool_.reset();
+  entry_ = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// ConnPool
+// ---------------------------------------------------------------------------
+
+ConnPool::ConnPool(const ConnPoolOptions& options)
+  : impl_(std::make_shared<ConnPoolImpl>(options)) {
+}
+
+ConnPool::~ConnPool() {
+  impl_->Shutdown();
+}
+
+Result<PooledConn> ConnPool::Get(const IpEndpoint& endpoint,
+                                 int64_t timeout) {
+  return impl_->Get(endpoint.ToString(), std::string(), endpoint.port(),
+                    endpoint, timeout);
+}
+
+Result<PooledConn> ConnPool::Get(const absl::string_view& host,
+                                 uint16_t port, int64_t timeout) {
+  IpAddress literal;
+  if (literal.AssignFromIPLiteral(host)) {
+    return Get(IpEndpoint(literal, port), timeout);
+  }
+  std::string key = absl::StrCat(host, ":", port);
+  return impl_->Get(key, std::string(host.data(), host.size()), port,
+                    IpEndpoint(), timeout);
+}
+
+void ConnPool::CloseIdle() {
+  impl_->CloseIdle();
+}
+
+}  // namespace tin::net
@@ -2,8 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "build/build_config.h"
+
+#include <absl/base/macros.h>
 #include <absl/log/log.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
+#if defined(OS_LINUX)
+#include <linux/filter.h>
+#endif
 #include "tin/error/error.h"
 #include "tin/time/time.h"
 #include "tin/net/ip_endpoint.h"
@@ -12,10 +20,283 @@
 #include "tin/net/tcp_conn_impl.h"  // internal: MakeTcpConn
 #include "tin/net/listener.h"       // public: TcpListener (PIMPL)
 #include "tin/net/listener_impl.h"  // internal: TcpListenerImpl
+#include "tin/net/dns_cache.h"
+#include "tin/net/resolve.h"
+#include "tin/communication/chan.h"
+#include "tin/runtime/coroutine.h"
 #include "tin/runtime/runtime.h"
+#include "tin/runtime/env.h"
+#include "tin/sync/mutex.h"
+#include "tin/time.h"
+#include "tin/time/timer.h"
 
 namespace tin::net {
 
+namespace {
+
+// Creates, binds and listens one TCP socket. reuse_port puts it in the
+// SO_REUSEPORT group of all sockets bound to the same address that way.
+int ListenFD(const IpAddress& address, uint16_t port, int backlog,
+             bool reuse_port, NetFD** out) {
+  int err = 0;
+  AddressFamily family =
+    address.IsIPv4() ? ADDRESS_FAMILY_IPV4 : ADDRESS_FAMILY_IPV6;
+  NetFD* netfd = NewFD(family, SOCK_STREAM, &err);
+  if (netfd != nullptr) {
+    err = netfd->Init();
+    if (err == 0) {
+#if defined(OS_POSIX)
+      int on = 1;
+      err = netfd->SetSockOpt(SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#endif
+    }
+    if (err == 0 && reuse_port) {
+#if defined(SO_REUSEPORT)
+      int on = 1;
+      err = netfd->SetSockOpt(SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#else
+      err = ENOTSUP;
+#endif
+    }
+    if (err == 0) {
+      IpEndpoint endpoint(address, port);
+      err = netfd->Bind(endpoint);
+      if (err != 0) {
+        LOG(INFO) << "Bind failed: " << TinErrorName(TinTranslateSysError(err));
+      }
+    }
+  }
+  if (err == 0) {
+    err = netfd->Listen(backlog);
+  }
+  if (err != 0) {
+    delete netfd;
+    return err;
+  }
+  *out = netfd;
+  return 0;
+}
+
+#if defined(OS_LINUX)
+// Selects the reuseport group member by the CPU that took the incoming
+// SYN. Group indexes follow bind order, i.e. shard order.
+int AttachCpuSteering(NetFD* netfd, int n) {
+  sock_filter code[] = {
+    // A = current CPU
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+     static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+    // A = A % n
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(n)},
+    // return A
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  sock_fprog prog;
+  prog.len = ABSL_ARRAYSIZE(code);
+  prog.filter = code;
+  return netfd->SetSockOpt(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                           sizeof(prog));
+}
+#endif
+
+// Shared by DialTcpParallel and its attempt coroutines, which may outlive
+// the dial.
+struct DialRace {
+  enum EventKind { kResult, kFallback, kTimeout };
+  struct Event {
+    EventKind kind;
+    int index;     // kResult: the attempt; kFallback: timer generation
+    NetFD* netfd;  // kResult: the connection, owned by the event
+    int err;       // kResult
+  };
+
+  explicit DialRace(int n)
+    : events(2 * n + 2)
+    , inflight(n, nullptr)
+    , finished(false) {
+  }
+
+  Chan<Event> events;
+  Mutex mu;
+  std::vector<NetFD*> inflight;  // sockets still connecting, guarded by mu
+  bool finished;                 // guarded by mu
+};
+
+// RFC 8305 section 4: alternate the families, starting with the first.
+std::vector<IpAddress> InterleaveFamilies(
+    const std::vector<IpAddress>& addresses) {
+  std::vector<IpAddress> first;
+  std::vector<IpAddress> second;
+  bool first_v6 = addresses.front().IsIPv6();
+  for (const IpAddress& address : addresses) {
+    (address.IsIPv6() == first_v6 ? first : second).push_back(address);
+  }
+  std::vector<IpAddress> result;
+  for (size_t i = 0; i < first.size() || i < second.size(); i++) {
+    if (i < first.size()) {
+      result.push_back(first[i]);
+    }
+    if (i < second.size()) {
+      result.push_back(second[i]);
+    }
+  }
+  return result;
+}
+
+void StartDialAttempt(std::shared_ptr<DialRace> race, int index,
+                      const IpAddress& address, uint16_t port,
+                      int64_t timeout) {
+  runtime::SpawnInternal([race, index, address, port, timeout]() {
+    int err = 0;
+    AddressFamily family =
+      address.IsIPv4() ? ADDRESS_FAMILY_IPV4 : ADDRESS_FAMILY_IPV6;
+    NetFD* netfd = NewFD(family, SOCK_STREAM, &err);
+    if (netfd != nullptr) {
+      {
+        MutexGuard guard(&race->mu);
+        if (race->finished) {
+          delete netfd;
+          return;
+        }
+        // FinishDialRace may Close the socket mid-connect. The reference
+        // keeps that from destroying it under Dial; this coroutine frees
+        // it.
+        netfd->Incref();
+        race->inflight[index] = netfd;
+      }
+      IpEndpoint endpoint(address, port);
+      err = netfd->Dial(nullptr, &endpoint, timeout);
+      netfd->Decref();
+    }
+    MutexGuard guard(&race->mu);
+    race->inflight[index] = nullptr;
+    if (err != 0 && netfd != nullptr) {
+      delete netfd;
+      netfd = nullptr;
+    }
+    if (race->finished) {
+      delete netfd;
+      return;
+    }
+    race->events->TryPush(DialRace::Event{DialRace::kResult, index, netfd,
+                                          err});
+  }, "dial_attempt");
+}
+
+// Cancels the attempts still connecting: Close marks each socket closed
+// and evicts its waiter, and the attempt, which holds a reference across
+// Dial, frees it. Connections that arrived after the winner are freed
+// here.
+void FinishDialRace(DialRace* race) {
+  {
+    MutexGuard guard(&race->mu);
+    race->finished = true;
+    for (NetFD* netfd : race->inflight) {
+      if (netfd != nullptr) {
+        netfd->Close();
+      }
+    }
+  }
+  DialRace::Event ev;
+  while (race->events->TryPop(&ev)) {
+    if (ev.kind == DialRace::kResult) {
+      delete ev.netfd;
+    }
+  }
+}
+
+}  // namespace
+
+Result<TcpConn> DialTcpParallel(const std::vector<IpAddress>& addresses,
+                                uint16_t port, int64_t timeout,
+                                int64_t fallback_delay) {
+  if (addresses.empty()) {
+    return Result<TcpConn>::Err(TIN_EINVAL);
+  }
+  if (addresses.size() == 1) {
+    return DialTcpTimeout(addresses.front(), port, timeout);
+  }
+  std::vector<IpAddress> ordered = InterleaveFamilies(addresses);
+  int n = static_cast<int>(ordered.size());
+  auto race = std::make_shared<DialRace>(n);
+  int64_t deadline = timeout > 0 ? MonoNow() + timeout : 0;
+
+  std::unique_ptr<Timer> timeout_timer;
+  if (timeout > 0) {
+    timeout_timer.reset(new Timer(AfterFunc(timeout, [race]() {
+      race->events->TryPush(DialRace::Event{DialRace::kTimeout, 0, nullptr,
+                                            0});
+    })));
+  }
+  std::unique_ptr<Timer> fallback_timer;
+  int generation = 0;
+  int next = 0;
+  int running = 0;
+  // Starts the next attempt and arms the timer for the one after it.
+  auto start_next = [&]() {
+    int64_t remaining = 0;
+    if (deadline != 0) {
+      remaining = std::max<int64_t>(deadline - MonoNow(), 1);
+    }
+    StartDialAttempt(race, next, ordered[next], port, remaining);
+    next++;
+    running++;
+    if (fallback_timer != nullptr) {
+      fallback_timer->Stop();
+    }
+    generation++;
+    if (next < n) {
+      int gen = generation;
+      fallback_timer.reset(new Timer(AfterFunc(fallback_delay,
+                                               [race, gen]() {
+        race->events->TryPush(DialRace::Event{DialRace::kFallback, gen,
+                                              nullptr, 0});
+      })));
+    }
+  };
+
+  start_next();
+  int first_err = 0;
+  NetFD* winner = nullptr;
+  while (winner == nullptr) {
+    DialRace::Event ev;
+    race->events->Pop(&ev);
+    if (ev.kind == DialRace::kTimeout) {
+      first_err = ETIMEDOUT;
+      break;
+    }
+    if (ev.kind == DialRace::kFallback) {
+      if (ev.index == generation && next < n) {
+        start_next();
+      }
+      continue;
+    }
+    running--;
+    if (ev.err == 0) {
+      winner = ev.netfd;
+      break;
+    }
+    if (first_err == 0) {
+      first_err = ev.err;
+    }
+    if (next < n) {
+      start_next();
+    } else if (running == 0) {
+      break;
+    }
+  }
+  if (fallback_timer != nullptr) {
+    fallback_timer->Stop();
+  }
+  if (timeout_timer != nullptr) {
+    timeout_timer->Stop();
+  }
+  FinishDialRace(race.get());
+  if (winner == nullptr) {
+    return Result<TcpConn>::Err(TinTranslateSysError(first_err));
+  }
+  return Result<TcpConn>::Ok(MakeTcpConn(std::unique_ptr<NetFD>(winner)));
+}
+
 Result<TcpConn> DialTcpInternal(const IpAddress& address, uint16_t port,
                                 int64_t deadline) {
   int err = 0;
@@ -24,9 +305,9 @@ Result<TcpConn> DialTcpInternal(const IpAddress& address, uint16_t port,
   NetFD* netfd = NewFD(family, SOCK_STREAM, &err);
   if (netfd != nullptr) {
     IpEndpoint endpoint(address, port);
-    if (deadline == -1)
-      deadline = UINT64_MAX;
-    err = netfd->Dial(nullptr, &endpoint, UINT64_MAX);
+    if (deadline < 0)
+      deadline = 0;
+    err = netfd->Dial(nullptr, &endpoint, deadline);
     if (err != 0) {
       delete netfd;
       netfd = nullptr;
@@ -41,10 +322,16 @@ Result<TcpConn> DialTcpInternal(const IpAddress& address, uint16_t port,
 Result<TcpConn> DialTcpInternal(const absl::string_view& address, uint16_t port,
                                 int64_t deadline) {
   IpAddress ip_address;
-  if (!ip_address.AssignFromIPLiteral(address)) {
-    return Result<TcpConn>::Err(TIN_EINVAL);
+  if (ip_address.AssignFromIPLiteral(address)) {
+    return DialTcpInternal(ip_address, port, deadline);
+  }
+  std::vector<IpAddress> addresses;
+  Status s = ResolveHostnameCached(address, ADDRESS_FAMILY_UNSPECIFIED,
+                                   &addresses);
+  if (!s.ok()) {
+    return Result<TcpConn>::Err(s);
   }
-  return DialTcpInternal(ip_address, port, deadline);
+  return DialTcpParallel(addresses, port, deadline < 0 ? 0 : deadline);
 }
 
 Result<TcpConn> DialTcp(const IpAddress& address, uint16_t port) {
@@ -67,34 +354,9 @@ Result<TcpConn> DialTcpTimeout(const absl::string_view& address, uint16_t port,
 
 Result<TcpListener> ListenTcp(const IpAddress& address, uint16_t port,
                               int backlog) {
-  int err = 0;
-  AddressFamily family =
-    address.IsIPv4() ? ADDRESS_FAMILY_IPV4 : ADDRESS_FAMILY_IPV6;
-  NetFD* netfd = NewFD(family, SOCK_STREAM, &err);
-  if (netfd != nullptr) {
-    err = netfd->Init();
-    if (err == 0) {
-#if defined(OS_POSIX)
-      int on = 1;
-      err = netfd->SetSockOpt(SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
-#endif
-    }
-    if (err == 0) {
-      IpEndpoint endpoint(address, port);
-      err = netfd->Bind(endpoint);
-      if (err != 0) {
-        LOG(INFO) << "Bind failed: " << TinErrorName(TinTranslateSysError(err));
-      }
-    }
-  }
-  if (err == 0) {
-    err = netfd->Listen(backlog);
-  }
-  if (err != 0 && netfd != nullptr) {
-    delete netfd;
-    netfd = nullptr;
-  }
-  if (netfd == nullptr) {
+  NetFD* netfd = nullptr;
+  int err = ListenFD(address, port, backlog, false, &netfd);
+  if (err != 0) {
     return Result<TcpListener>::Err(TinTranslateSysError(err));
   }
   // P2-1 PIMPL: use make_shared for single allocation.
@@ -111,4 +373,62 @@ Result<TcpListener> ListenTcp(const absl::string_view& address, uint16_t port,
   return ListenTcp(ip_address, port, backlog);
 }
 
+Result<ShardedTcpListener> ListenTcpSharded(const IpAddress& address,
+                                            uint16_t port, int n,
+                                            bool steer_by_cpu, int backlog) {
+  if (n <= 0) {
+    n = runtime::rtm_conf->MaxProcs();
+  }
+  std::vector<std::unique_ptr<NetFD>> fds;
+  for (int i = 0; i < n; i++) {
+    NetFD* netfd = nullptr;
+    // Port 0: the first bind picks the port, the rest join its group.
+    int err = ListenFD(address, port, backlog, true, &netfd);
+    if (err == 0 && i == 0 && port == 0) {
+      IpEndpoint local;
+      SockaddrStorage storage;
+      err = getsockname(netfd->IntFd(), storage.addr, &storage.addr_len) == 0
+            ? 0 : errno;
+      if (err == 0) {
+        if (local.FromSockAddr(storage.addr, storage.addr_len)) {
+          port = local.port();
+        } else {
+          err = EINVAL;
+        }
+      }
+    }
+    if (err != 0) {
+      delete netfd;
+      return Result<ShardedTcpListener>::Err(TinTranslateSysError(err));
+    }
+    fds.emplace_back(netfd);
+  }
+  if (steer_by_cpu) {
+#if defined(OS_LINUX)
+    int err = AttachCpuSteering(fds[0].get(), n);
+#else
+    int err = ENOTSUP;
+#endif
+    if (err != 0) {
+      return Result<ShardedTcpListener>::Err(TinTranslateSysError(err));
+    }
+  }
+  std::vector<TcpListener> shards;
+  for (auto& fd : fds) {
+    shards.push_back(
+        TcpListener(std::make_shared<TcpListenerImpl>(std::move(fd), backlog)));
+  }
+  return Result<ShardedTcpListener>::Ok(ShardedTcpListener(std::move(shards)));
+}
+
+Result<ShardedTcpListener> ListenTcpSharded(const absl::string_view& address,
+                                            uint16_t port, int n,
+                                            bool steer_by_cpu, int backlog) {
+  IpAddress ip_address;
+  if (!ip_address.AssignFromIPLiteral(address)) {
+    return Result<ShardedTcpListener>::Err(TIN_EINVAL);
+  }
+  return ListenTcpSharded(ip_address, port, n, steer_by_cpu, backlog);
+}
+
 }  // namespace tin::net
@@ -0,0 +1,222 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_cat.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tin/error/error.h"
+#include "tin/net/dns_cache.h"
+#include "tin/net/dns_cache_impl.h"
+#include "tin/net/resolve.h"
+#include "tin/runtime/coroutine.h"
+#include "tin/sync/mutex.h"
+#include "tin/sync/wait_group.h"
+#include "tin/time.h"
+
+namespace tin::net {
+
+namespace {
+
+const int kShards = 16;
+
+// One getaddrinfo call; lookups that miss while it runs wait on done.
+struct DnsFlight {
+  WaitGroup done;
+  std::vector<IpAddress> addresses;
+  int code = 0;
+};
+
+struct DnsEntry {
+  std::vector<IpAddress> addresses;
+  int code = 0;         // 0 or the cached negative answer
+  int64_t expires = 0;  // MonoNow() deadline; 0 until first resolved
+  std::shared_ptr<DnsFlight> flight;  // resolution or refresh in progress
+};
+
+struct DnsShard {
+  Mutex mu;
+  std::unordered_map<std::string, std::shared_ptr<DnsEntry>> entries;
+};
+
+DnsShard g_shards[kShards];
+
+std::atomic<int64_t> g_ttl(DnsCacheOptions().ttl);
+std::atomic<int64_t> g_negative_ttl(DnsCacheOptions().negative_ttl);
+std::atomic<int64_t> g_stale_ttl(DnsCacheOptions().stale_ttl);
+std::atomic<int> g_max_entries(DnsCacheOptions().max_entries);
+
+std::atomic<DnsLookupFn> g_lookup(
+    static_cast<DnsLookupFn>(&ResolveHostname));
+
+std::atomic<int64_t> g_hits(0);
+std::atomic<int64_t> g_stale_hits(0);
+std::atomic<int64_t> g_misses(0);
+std::atomic<int64_t> g_coalesced(0);
+std::atomic<int64_t> g_refreshes(0);
+
+DnsShard* ShardFor(const std::string& key) {
+  return &g_shards[std::hash<std::string>()(key) % kShards];
+}
+
+bool IsNegativeAnswer(int code) {
+  return code == TIN_EAI_NONAME || code == TIN_EAI_NODATA;
+}
+
+// Makes room for one more entry: drops the expired ones, and everything
+// idle if that is not enough. Caller holds shard->mu.
+void EvictLocked(DnsShard* shard, int64_t now) {
+  size_t cap = static_cast<size_t>(g_max_entries.load() / kShards) + 1;
+  if (shard->entries.size() < cap) {
+    return;
+  }
+  int64_t stale_ttl = g_stale_ttl.load();
+  for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+    const DnsEntry& e = *it->second;
+    if (e.flight == nullptr && e.expires + stale_ttl <= now) {
+      it = shard->entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (shard->entries.size() >= cap) {
+    for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+      if (it->second->flight == nullptr) {
+        it = shard->entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+// Runs the getaddrinfo call of flight and publishes the answer.
+void Resolve(DnsShard* shard, std::shared_ptr<DnsEntry> entry,
+             std::shared_ptr<DnsFlight> flight, const std::string& hostname,
+             AddressFamily af) {
+  std::vector<IpAddress> addresses;
+  Status s = g_lookup.load()(hostname, af, &addresses);
+  int code = s.code();
+  {
+    MutexGuard guard(&shard->mu);
+    entry->flight = nullptr;
+    if (code == 0) {
+      entry->addresses = addresses;
+      entry->code = 0;
+      entry->expires = MonoNow() + g_ttl.load();
+    } else if (IsNegativeAnswer(code)) {
+      entry->addresses.clear();
+      entry->code = code;
+      entry->expires = MonoNow() + g_negative_ttl.load();
+    }
+    // Other failures are transient: a stale answer stays as it was.
+  }
+  flight->addresses = std::move(addresses);
+  flight->code = code;
+  flight->done.Done();
+}
+
+}  // namespace
+
+Status ResolveHostnameCached(const absl::string_view& hostname,
+                             AddressFamily af,
+                             std::vector<IpAddress>* addresses) {
+  if (addresses == nullptr) {
+    return Status::FromErrno(TIN_EINVAL);
+  }
+  std::string key = absl::StrCat(static_cast<int>(af), "/", hostname);
+  DnsShard* shard = ShardFor(key);
+  int64_t now = MonoNow();
+  std::shared_ptr<DnsEntry> entry;
+  std::shared_ptr<DnsFlight> flight;
+  bool leader = false;
+  bool stale = false;
+  {
+    MutexGuard guard(&shard->mu);
+    auto it = shard->entries.find(key);
+    if (it == shard->entries.end()) {
+      EvictLocked(shard, now);
+      it = shard->entries.emplace(key, std::make_shared<DnsEntry>()).first;
+    }
+    entry = it->second;
+    if (entry->expires != 0 && now < entry->expires) {
+      g_hits++;
+      *addresses = entry->addresses;
+      return Status::FromErrno(entry->code);
+    }
+    if (entry->expires != 0 && entry->code == 0 &&
+        now < entry->expires + g_stale_ttl.load()) {
+      g_stale_hits++;
+      stale = true;
+      *addresses = entry->addresses;
+      if (entry->flight == nullptr) {
+        g_refreshes++;
+        flight = std::make_shared<DnsFlight>();
+        flight->done.Add(1);
+        entry->flight = flight;
+      }
+    } else if (entry->flight != nullptr) {
+      g_coalesced++;
+      flight = entry->flight;
+    } else {
+      g_misses++;
+      flight = std::make_shared<DnsFlight>();
+      flight->done.Add(1);
+      entry->flight = flight;
+      leader = true;
+    }
+  }
+
+  std::string name(hostname.data(), hostname.size());
+  if (stale) {
+    if (flight != nullptr) {
+      runtime::SpawnInternal([shard, entry, flight, name, af]() {
+        Resolve(shard, entry, flight, name, af);
+      }, "dns_refresh");
+    }
+    return Status::OK();
+  }
+  if (leader) {
+    Resolve(shard, entry, flight, name, af);
+  } else {
+    flight->done.Wait();
+  }
+  *addresses = flight->addresses;
+  return Status::FromErrno(flight->code);
+}
+
+DnsLookupFn SetDnsCacheLookup(DnsLookupFn lookup) {
+  return g_lookup.exchange(lookup);
+}
+
+void SetDnsCacheOptions(const DnsCacheOptions& options) {
+  g_ttl.store(options.ttl);
+  g_negative_ttl.store(options.negative_ttl);
+  g_stale_ttl.store(options.stale_ttl);
+  g_max_entries.store(options.max_entries);
+}
+
+DnsCacheStats GetDnsCacheStats() {
+  DnsCacheStats stats;
+  stats.hits = g_hits.load();
+  stats.stale_hits = g_stale_hits.load();
+  stats.misses = g_misses.load();
+  stats.coalesced = g_coalesced.load();
+  stats.refreshes = g_refreshes.load();
+  return stats;
+}
+
+void ClearDnsCache() {
+  for (DnsShard& shard : g_shards) {
+    MutexGuard guard(&shard.mu);
+    shard.entries.clear();
+  }
+}
+
+}  // namespace tin::net
@@ -0,0 +1,31 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Internal header for the DNS cache (include/tin/net/dns_cache.h).
+// This file is NOT part of the public API.
+
+#ifndef TIN_NET_DNS_CACHE_IMPL_H_
+#define TIN_NET_DNS_CACHE_IMPL_H_
+
+#include <absl/strings/string_view.h>
+
+#include <vector>
+
+#include "tin/net/address_family.h"
+#include "tin/net/ip_address.h"
+#include "tin/result.h"
+
+namespace tin::net {
+
+using DnsLookupFn = Status (*)(const absl::string_view& hostname,
+                               AddressFamily af,
+                               std::vector<IpAddress>* addresses);
+
+// Replaces the lookup the cache runs on a miss or a refresh
+// (ResolveHostname by default), e.g. with a fake in tests. Returns the
+// previous one.
+DnsLookupFn SetDnsCacheLookup(DnsLookupFn lookup);
+
+}  // namespace tin::net
+#endif  // TIN_NET_DNS_CACHE_IMPL_H_
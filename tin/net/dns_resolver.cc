@@ -0,0 +1,530 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tin/error/error.h"
+#include "tin/io/io.h"
+#include "tin/net/dialer.h"
+#include "tin/net/dns_resolver.h"
+#include "tin/net/udp_conn.h"
+#include "tin/runtime/coroutine.h"
+#include "tin/sync/mutex.h"
+#include "tin/sync/wait_group.h"
+
+namespace tin::net {
+
+namespace {
+
+const uint16_t kTypeA = 1;
+const uint16_t kTypeAAAA = 28;
+const uint16_t kTypeOpt = 41;
+const uint16_t kClassIn = 1;
+
+const int kRcodeNoError = 0;
+const int kRcodeNameError = 3;
+
+const size_t kHeaderLen = 12;
+// EDNS(0) payload size advertised in queries, the DNS flag day value.
+const size_t kMaxUdpReply = 1232;
+
+uint16_t NewQueryId() {
+  thread_local std::mt19937 gen{std::random_device{}()};
+  return static_cast<uint16_t>(gen());
+}
+
+void PutUint16(std::string* out, uint16_t v) {
+  out->push_back(static_cast<char>(v >> 8));
+  out->push_back(static_cast<char>(v & 0xff));
+}
+
+uint16_t GetUint16(const uint8_t* p) {
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+// Encodes a recursive query for name, which has no trailing dot, with an
+// EDNS(0) OPT record. False if name is not a valid domain name.
+bool BuildQuery(uint16_t id, const std::string& name, uint16_t qtype,
+                std::string* out) {
+  out->clear();
+  PutUint16(out, id);
+  PutUint16(out, 0x0100);  // RD
+  PutUint16(out, 1);       // QDCOUNT
+  PutUint16(out, 0);       // ANCOUNT
+  PutUint16(out, 0);       // NSCOUNT
+  PutUint16(out, 1);       // ARCOUNT
+  size_t name_len = 1;
+  for (absl::string_view label : absl::StrSplit(name, '.')) {
+    if (label.empty() || label.size() > 63) {
+      return false;
+    }
+    name_len += label.size() + 1;
+    out->push_back(static_cast<char>(label.size()));
+    out->append(label.data(), label.size());
+  }
+  if (name_len > 255) {
+    return false;
+  }
+  out->push_back(0);
+  PutUint16(out, qtype);
+  PutUint16(out, kClassIn);
+  out->push_back(0);  // root owner name
+  PutUint16(out, kTypeOpt);
+  PutUint16(out, kMaxUdpReply);
+  PutUint16(out, 0);  // extended RCODE and version
+  PutUint16(out, 0);  // flags
+  PutUint16(out, 0);  // RDLENGTH
+  return true;
+}
+
+// Advances *off past the (possibly compressed) name at msg + *off.
+bool SkipName(const uint8_t* msg, size_t len, size_t* off) {
+  size_t p = *off;
+  while (p < len) {
+    uint8_t n = msg[p];
+    if (n == 0) {
+      *off = p + 1;
+      return true;
+    }
+    if ((n & 0xc0) == 0xc0) {
+      if (p + 2 > len) {
+        return false;
+      }
+      *off = p + 2;
+      return true;
+    }
+    if ((n & 0xc0) != 0) {
+      return false;
+    }
+    p += 1 + n;
+  }
+  return false;
+}
+
+struct DnsReply {
+  int rcode = 0;
+  bool truncated = false;
+  std::vector<IpAddress> addresses;
+};
+
+// Parses a reply to query. False if msg is malformed or answers some
+// other query; stray datagrams are dropped that way.
+bool ParseReply(const uint8_t* msg, size_t len, const std::string& query,
+                uint16_t qtype, DnsReply* reply) {
+  if (len < kHeaderLen ||
+      GetUint16(msg) != GetUint16(
+          reinterpret_cast<const uint8_t*>(query.data()))) {
+    return false;
+  }
+  uint16_t flags = GetUint16(msg + 2);
+  if ((flags & 0x8000) == 0 || GetUint16(msg + 4) != 1) {
+    return false;
+  }
+  // The question must echo ours; it runs up to the OPT record.
+  size_t qlen = query.size() - kHeaderLen - 11;
+  if (len < kHeaderLen + qlen ||
+      !absl::EqualsIgnoreCase(
+          absl::string_view(reinterpret_cast<const char*>(msg) + kHeaderLen,
+                            qlen),
+          absl::string_view(query.data() + kHeaderLen, qlen))) {
+    return false;
+  }
+  reply->rcode = flags & 0x000f;
+  reply->truncated = (flags & 0x0200) != 0;
+  reply->addresses.clear();
+  size_t off = kHeaderLen + qlen;
+  int ancount = GetUint16(msg + 6);
+  for (int i = 0; i < ancount; ++i) {
+    if (!SkipName(msg, len, &off) || off + 10 > len) {
+      // A truncated reply may end in the middle of a record.
+      return reply->truncated;
+    }
+    uint16_t type = GetUint16(msg + off);
+    uint16_t klass = GetUint16(msg + off + 2);
+    uint16_t rdlength = GetUint16(msg + off + 8);
+    off += 10;
+    if (off + rdlength > len) {
+      return reply->truncated;
+    }
+    // CNAMEs need no chasing: a recursive server appends the records of
+    // the target, which carry the type asked for.
+    size_t want = qtype == kTypeA ? 4 : 16;
+    if (type == qtype && klass == kClassIn && rdlength == want) {
+      reply->addresses.emplace_back(msg + off, want);
+    }
+    off += rdlength;
+  }
+  return true;
+}
+
+int ExchangeUdp(const IpEndpoint& server, const std::string& query,
+                uint16_t qtype, int64_t timeout, DnsReply* reply) {
+  Result<UdpConn> conn = DialUdp(server.address(), server.port());
+  if (!conn.ok()) {
+    return conn.code();
+  }
+  conn->SetDeadline(timeout);
+  int err = 0;
+  Result<size_t> n =
+      conn->Write(query.data(), static_cast<int>(query.size()));
+  if (!n.ok()) {
+    err = n.code();
+  }
+  uint8_t buf[kMaxUdpReply];
+  while (err == 0) {
+    n = conn->Read(buf, sizeof(buf));
+    if (!n.ok()) {
+      err = n.code();
+    } else if (ParseReply(buf, *n, query, qtype, reply)) {
+      break;
+    }
+  }
+  conn->Close();
+  return err;
+}
+
+// RFC 7766: the same query over TCP, each message prefixed by its length.
+int ExchangeTcp(const IpEndpoint& server, const std::string& query,
+                uint16_t qtype, int64_t timeout, DnsReply* reply) {
+  Result<TcpConn> conn =
+      DialTcpTimeout(server.address(), server.port(), timeout);
+  if (!conn.ok()) {
+    return conn.code();
+  }
+  conn->SetDeadline(timeout);
+  std::string msg;
+  PutUint16(&msg, static_cast<uint16_t>(query.size()));
+  msg.append(query);
+  int err = 0;
+  Result<size_t> n =
+      io::Write(&*conn, msg.data(), static_cast<int>(msg.size()));
+  uint8_t len[2];
+  if (n.ok()) {
+    n = io::ReadFull(&*conn, len, sizeof(len));
+  }
+  std::vector<uint8_t> buf;
+  if (n.ok()) {
+    buf.resize(GetUint16(len));
+    n = buf.empty() ? Result<size_t>::Ok(0)
+                    : io::ReadFull(&*conn, buf.data(),
+                                   static_cast<int>(buf.size()));
+  }
+  if (!n.ok()) {
+    err = n.code();
+  } else if (!ParseReply(buf.data(), buf.size(), query, qtype, reply) ||
+             reply->truncated) {
+    err = TIN_EPROTO;
+  }
+  conn->Close();
+  return err;
+}
+
+void ParseHosts(
+    const absl::string_view& content,
+    std::unordered_map<std::string, std::vector<IpAddress>>* hosts) {
+  hosts->clear();
+  for (absl::string_view line : absl::StrSplit(content, '\n')) {
+    line = line.substr(0, line.find('#'));
+    std::vector<absl::string_view> fields =
+        absl::StrSplit(line, absl::ByAnyChar(" \t\r"), absl::SkipEmpty());
+    IpAddress address;
+    if (fields.size() < 2 || !address.AssignFromIPLiteral(fields[0])) {
+      continue;
+    }
+    for (size_t i = 1; i < fields.size(); ++i) {
+      absl::ConsumeSuffix(&fields[i], ".");
+      (*hosts)[absl::AsciiStrToLower(fields[i])].push_back(address);
+    }
+  }
+}
+
+bool MatchesFamily(const IpAddress& address, AddressFamily af) {
+  return af == ADDRESS_FAMILY_UNSPECIFIED ||
+         (af == ADDRESS_FAMILY_IPV4 && address.IsIPv4()) ||
+         (af == ADDRESS_FAMILY_IPV6 && address.IsIPv6());
+}
+
+bool ReadFile(const char* path, std::string* content) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+  *content = ss.str();
+  return true;
+}
+
+}  // namespace
+
+void ParseResolvConf(const absl::string_view& content, DnsConfig* config) {
+  for (absl::string_view line : absl::StrSplit(content, '\n')) {
+    line = line.substr(0, line.find_first_of("#;"));
+    std::vector<absl::string_view> fields =
+        absl::StrSplit(line, absl::ByAnyChar(" \t\r"), absl::SkipEmpty());
+    if (fields.size() < 2) {
+      continue;
+    }
+    if (fields[0] == "nameserver") {
+      IpAddress address;
+      if (address.AssignFromIPLiteral(fields[1])) {
+        config->servers.emplace_back(address, 53);
+      }
+    } else if (fields[0] == "domain") {
+      config->search.assign(1, std::string(fields[1]));
+    } else if (fields[0] == "search") {
+      config->search.clear();
+      for (size_t i = 1; i < fields.size(); ++i) {
+        config->search.emplace_back(fields[i]);
+      }
+    } else if (fields[0] == "options") {
+      for (size_t i = 1; i < fields.size(); ++i) {
+        absl::string_view opt = fields[i];
+        int v = 0;
+        if (absl::ConsumePrefix(&opt, "ndots:") && absl::SimpleAtoi(opt, &v)) {
+          config->ndots = std::clamp(v, 0, 15);
+        } else if (absl::ConsumePrefix(&opt, "timeout:") &&
+                   absl::SimpleAtoi(opt, &v)) {
+          config->timeout = std::clamp(v, 1, 30) * kSecond;
+        } else if (absl::ConsumePrefix(&opt, "attempts:") &&
+                   absl::SimpleAtoi(opt, &v)) {
+          config->attempts = std::clamp(v, 1, 5);
+        } else if (opt == "rotate") {
+          config->rotate = true;
+        }
+      }
+    }
+  }
+}
+
+class DnsResolverImpl {
+ public:
+  explicit DnsResolverImpl(const DnsConfig& config)
+    : config_(config)
+    , next_server_(0) {
+    if (config_.servers.empty()) {
+      config_.servers.emplace_back(IpAddress::IPv4Localhost(), 53);
+    }
+    if (config_.attempts < 1) {
+      config_.attempts = 1;
+    }
+  }
+
+  void SetHosts(const absl::string_view& content) {
+    std::unordered_map<std::string, std::vector<IpAddress>> hosts;
+    ParseHosts(content, &hosts);
+    MutexGuard guard(&mu_);
+    hosts_.swap(hosts);
+  }
+
+  Status Resolve(const absl::string_view& hostname, AddressFamily af,
+                 std::vector<IpAddress>* addresses);
+
+ private:
+  bool LookupHosts(const std::string& name, AddressFamily af,
+                   std::vector<IpAddress>* addresses);
+  int Lookup(const std::string& name, AddressFamily af,
+             std::vector<IpAddress>* addresses);
+  int Query(const std::string& name, uint16_t qtype,
+            std::vector<IpAddress>* addresses);
+
+  DnsConfig config_;
+  std::atomic<uint32_t> next_server_;
+  Mutex mu_;
+  std::unordered_map<std::string, std::vector<IpAddress>> hosts_;
+};
+
+bool DnsResolverImpl::LookupHosts(const std::string& name, AddressFamily af,
+                                  std::vector<IpAddress>* addresses) {
+  MutexGuard guard(&mu_);
+  auto it = hosts_.find(name);
+  if (it == hosts_.end()) {
+    return false;
+  }
+  for (const IpAddress& address : it->second) {
+    if (MatchesFamily(address, af)) {
+      addresses->push_back(address);
+    }
+  }
+  return !addresses->empty();
+}
+
+// Returns 0 with the answer, possibly empty (no records of that type),
+// TIN_EAI_NONAME if the name does not exist, or TIN_EAI_AGAIN if no
+// server gave a usable answer.
+int DnsResolverImpl::Query(const std::string& name, uint16_t qtype,
+                           std::vector<IpAddress>* addresses) {
+  std::string query;
+  if (!BuildQuery(NewQueryId(), name, qtype, &query)) {
+    return TIN_EAI_NONAME;
+  }
+  size_t n = config_.servers.size();
+  size_t start = config_.rotate ? next_server_++ % n : 0;
+  for (int attempt = 0; attempt < config_.attempts; ++attempt) {
+    for (size_t i = 0; i < n; ++i) {
+      const IpEndpoint& server = config_.servers[(start + i) % n];
+      DnsReply reply;
+      int err = ExchangeUdp(server, query, qtype, config_.timeout, &reply);
+      if (err == 0 && reply.truncated) {
+        err = ExchangeTcp(server, query, qtype, config_.timeout, &reply);
+      }
+      if (err != 0) {
+        continue;
+      }
+      if (reply.rcode == kRcodeNoError) {
+        *addresses = std::move(reply.addresses);
+        return 0;
+      }
+      if (reply.rcode == kRcodeNameError) {
+        return TIN_EAI_NONAME;
+      }
+      // SERVFAIL, REFUSED and the like: ask the next server.
+    }
+  }
+  return TIN_EAI_AGAIN;
+}
+
+int DnsResolverImpl::Lookup(const std::string& name, AddressFamily af,
+                            std::vector<IpAddress>* addresses) {
+  if (af == ADDRESS_FAMILY_IPV4) {
+    return Query(name, kTypeA, addresses);
+  }
+  if (af == ADDRESS_FAMILY_IPV6) {
+    return Query(name, kTypeAAAA, addresses);
+  }
+  std::vector<IpAddress> v6;
+  int err6 = 0;
+  WaitGroup wg;
+  wg.Add(1);
+  runtime::SpawnInternal([&]() {
+    err6 = Query(name, kTypeAAAA, &v6);
+    wg.Done();
+  }, "dns_query");
+  int err4 = Query(name, kTypeA, addresses);
+  wg.Wait();
+  addresses->insert(addresses->end(), v6.begin(), v6.end());
+  if (!addresses->empty() || (err4 == 0 && err6 == 0)) {
+    return 0;
+  }
+  if (err4 == TIN_EAI_AGAIN || err6 == TIN_EAI_AGAIN) {
+    return TIN_EAI_AGAIN;
+  }
+  return err4 != 0 ? err4 : err6;
+}
+
+Status DnsResolverImpl::Resolve(const absl::string_view& hostname,
+                                AddressFamily af,
+                                std::vector<IpAddress>* addresses) {
+  addresses->clear();
+  IpAddress literal;
+  if (literal.AssignFromIPLiteral(hostname)) {
+    if (!MatchesFamily(literal, af)) {
+      return Status::FromErrno(TIN_EAI_ADDRFAMILY);
+    }
+    addresses->push_back(literal);
+    return Status::OK();
+  }
+  std::string name = absl::AsciiStrToLower(hostname);
+  bool absolute = absl::EndsWith(name, ".");
+  if (absolute) {
+    name.pop_back();
+  }
+  if (name.empty()) {
+    return Status::FromErrno(TIN_EAI_NONAME);
+  }
+  if (LookupHosts(name, af, addresses)) {
+    return Status::OK();
+  }
+
+  // resolv.conf(5): names with ndots dots or more are tried as is first,
+  // the others after the search list.
+  std::vector<std::string> candidates;
+  bool as_is_first = absolute ||
+      std::count(name.begin(), name.end(), '.') >= config_.ndots;
+  if (as_is_first) {
+    candidates.push_back(name);
+  }
+  if (!absolute) {
+    for (const std::string& suffix : config_.search) {
+      absl::string_view s = suffix;
+      absl::ConsumeSuffix(&s, ".");
+      if (!s.empty()) {
+        candidates.push_back(absl::StrCat(name, ".", s));
+      }
+    }
+    if (!as_is_first) {
+      candidates.push_back(name);
+    }
+  }
+
+  int last = TIN_EAI_NONAME;
+  for (const std::string& candidate : candidates) {
+    int err = Lookup(candidate, af, addresses);
+    if (err == 0 && !addresses->empty()) {
+      return Status::OK();
+    }
+    if (err == TIN_EAI_AGAIN) {
+      last = err;
+    } else if (err == 0 && last != TIN_EAI_AGAIN) {
+      last = TIN_EAI_NODATA;
+    }
+  }
+  addresses->clear();
+  return Status::FromErrno(last);
+}
+
+DnsResolver::DnsResolver(const DnsConfig& config)
+  : impl_(std::make_unique<DnsResolverImpl>(config)) {
+}
+
+DnsResolver::~DnsResolver() = default;
+
+void DnsResolver::SetHosts(const absl::string_view& content) {
+  impl_->SetHosts(content);
+}
+
+Status DnsResolver::Resolve(const absl::string_view& hostname,
+                            AddressFamily af,
+                            std::vector<IpAddress>* addresses) {
+  if (addresses == nullptr) {
+    return Status::FromErrno(TIN_EINVAL);
+  }
+  return impl_->Resolve(hostname, af, addresses);
+}
+
+Status ResolveHostnameNative(const absl::string_view& hostname,
+                             AddressFamily af,
+                             std::vector<IpAddress>* addresses) {
+  // Read once, with blocking file I/O; both files are small.
+  static DnsResolver* resolver = []() {
+    DnsConfig config;
+    std::string content;
+    if (ReadFile("/etc/resolv.conf", &content)) {
+      ParseResolvConf(content, &config);
+    }
+    DnsResolver* r = new DnsResolver(config);
+    if (ReadFile("/etc/hosts", &content)) {
+      r->SetHosts(content);
+    }
+    return r;
+  }();
+  return resolver->Resolve(hostname, af, addresses);
+}
+
+}  // namespace tin::net
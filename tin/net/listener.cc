@@ -4,10 +4,16 @@
 
 #include "build/build_config.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "tin/net/sys_socket.h"
 #include "tin/error/error.h"
 #include "tin/time/time.h"
 #include "tin/runtime/runtime.h"
+#include "tin/runtime/env.h"
+#include "tin/runtime/coroutine.h"
+#include "tin/sync/wait_group.h"
 #include "tin/net/netfd.h"
 #include "tin/net/listener_impl.h"  // internal: TcpListenerImpl
 #include "tin/net/listener.h"       // public: TcpListener (PIMPL)
@@ -35,6 +41,15 @@ Status TcpListenerImpl::Close() {
   return Status::FromErrno(TinTranslateSysError(err));
 }
 
+Result<int> TcpListenerImpl::File() {
+  int fd = -1;
+  int err = netfd_->Dup(&fd);
+  if (err != 0) {
+    return Result<int>::Err(TinTranslateSysError(err));
+  }
+  return Result<int>::Ok(fd);
+}
+
 Result<TcpConn> TcpListenerImpl::Accept() {
   NetFD* newfd = nullptr;
   int err = netfd_->Accept(&newfd);
@@ -45,6 +60,70 @@ Result<TcpConn> TcpListenerImpl::Accept() {
   return Result<TcpConn>::Ok(MakeTcpConn(std::unique_ptr<NetFD>(newfd)));
 }
 
+Result<std::vector<TcpConn>> TcpListenerImpl::AcceptBatch(int max) {
+  std::vector<NetFD*> newfds;
+  int err = netfd_->AcceptBatch(max, &newfds);
+  if (err != 0) {
+    return Result<std::vector<TcpConn>>::Err(TinTranslateSysError(err));
+  }
+  std::vector<TcpConn> conns;
+  conns.reserve(newfds.size());
+  for (NetFD* newfd : newfds) {
+    conns.push_back(MakeTcpConn(std::unique_ptr<NetFD>(newfd)));
+  }
+  return Result<std::vector<TcpConn>>::Ok(std::move(conns));
+}
+
+// ---------------------------------------------------------------------------
+// Accept loops (TcpListener::Serve, ShardedTcpListener::Serve).
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Errors after which an accept loop backs off and keeps going: the
+// process or system ran out of fds or memory (Go net/http backs off the
+// same way on temporary accept errors).
+bool IsTemporaryAcceptError(int code) {
+  return code == TIN_EMFILE || code == TIN_ENFILE || code == TIN_ENOBUFS ||
+         code == TIN_ENOMEM;
+}
+
+bool IsClosedError(int code) {
+  return code == TIN_ECLOSE_INTR || code == TIN_EBADF;
+}
+
+// Returns the error code that stopped the loop.
+int AcceptLoop(TcpListener ln, const std::function<void(TcpConn)>& handler,
+               int max_batch) {
+  int64_t delay = 0;
+  while (true) {
+    Result<std::vector<TcpConn>> r = ln.AcceptBatch(max_batch);
+    if (!r.ok()) {
+      if (r.code() == TIN_ECONNABORTED) {
+        // A peer reset a connection still in the accept queue; the next
+        // one may be waiting right behind it (Go retries at once too).
+        continue;
+      }
+      if (!IsTemporaryAcceptError(r.code())) {
+        return r.code();
+      }
+      delay = delay == 0 ? 5 : std::min<int64_t>(delay * 2, 1000);
+      Sleep(delay);
+      continue;
+    }
+    delay = 0;
+    std::vector<std::function<void()>> closures;
+    closures.reserve(r.value().size());
+    for (TcpConn& conn : r.value()) {
+      closures.push_back(std::bind(handler, std::move(conn)));
+    }
+    // Spawned from this loop, the handlers land on the current P.
+    runtime::SpawnBatchInternal(std::move(closures), "tcp_handler");
+  }
+}
+
+}  // namespace
+
 // ---------------------------------------------------------------------------
 // TcpListener ? PIMPL forwarding methods (public API).
 // ---------------------------------------------------------------------------
@@ -58,8 +137,60 @@ Result<TcpConn> TcpListener::Accept() {
                : Result<TcpConn>::Err(TIN_EBADF);
 }
 
+Result<std::vector<TcpConn>> TcpListener::AcceptBatch(int max) {
+  return impl_ ? impl_->AcceptBatch(max)
+               : Result<std::vector<TcpConn>>::Err(TIN_EBADF);
+}
+
+Status TcpListener::Serve(std::function<void(TcpConn)> handler,
+                          int max_batch) {
+  int code = AcceptLoop(*this, handler, max_batch);
+  return IsClosedError(code) ? Status::OK() : Status::FromErrno(code);
+}
+
 Status TcpListener::Close() {
   return impl_ ? impl_->Close() : Status::FromErrno(TIN_EBADF);
 }
 
+Result<int> TcpListener::File() {
+  return impl_ ? impl_->File() : Result<int>::Err(TIN_EBADF);
+}
+
+// ---------------------------------------------------------------------------
+// ShardedTcpListener
+// ---------------------------------------------------------------------------
+
+Status ShardedTcpListener::Serve(std::function<void(TcpConn)> handler) {
+  std::vector<int> codes(shards_.size(), 0);
+  WaitGroup wg(static_cast<int>(shards_.size()));
+  int nprocs = runtime::rtm_conf->MaxProcs();
+  for (size_t i = 0; i < shards_.size(); i++) {
+    // Loop i lives on P i: with Config::SetNoStealProcs that P keeps the
+    // loop and every connection it accepts (thread-per-core).
+    runtime::SpawnOnP(static_cast<int>(i % nprocs),
+                      [this, i, &handler, &codes, &wg]() {
+      codes[i] = AcceptLoop(shards_[i], handler, 64);
+      wg.Done();
+    }, "accept_loop");
+  }
+  wg.Wait();
+  for (int code : codes) {
+    if (!IsClosedError(code)) {
+      return Status::FromErrno(code);
+    }
+  }
+  return Status::OK();
+}
+
+Status ShardedTcpListener::Close() {
+  Status first = Status::OK();
+  for (auto& ln : shards_) {
+    Status s = ln.Close();
+    if (first.ok() && !s.ok()) {
+      first = s;
+    }
+  }
+  return first;
+}
+
 }  // namespace tin::net
@@ -9,6 +9,7 @@
 #ifndef TIN_NET_LISTENER_IMPL_H_
 #define TIN_NET_LISTENER_IMPL_H_
 #include <memory>
+#include <vector>
 
 #include "tin/time/time.h"
 #include "tin/result.h"
@@ -29,7 +30,9 @@ class TcpListenerImpl
 
   Status SetDeadline(int64_t t);
   Result<TcpConn> Accept();
+  Result<std::vector<TcpConn>> AcceptBatch(int max);
   Status Close();
+  Result<int> File();
 
  private:
   std::unique_ptr<NetFD> netfd_;
@@ -3,6 +3,10 @@
 // found in the LICENSE file.
 
 #include <fcntl.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <memory>
 
 #include <absl/log/log.h>
@@ -12,6 +16,14 @@
 #include "tin/runtime/env.h"
 #include "tin/runtime/posix_util.h"
 #include "tin/runtime/net/pollops.h"
+#if defined(OS_LINUX)
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+
+#include "tin/runtime/net/netpoll_uring.h"
+#endif
 #include "tin/net/net.h"
 #include "tin/net/sockaddr_storage.h"
 #include "tin/net/ip_address.h"
@@ -19,13 +31,152 @@
 
 #include "tin/net/netfd_posix.h"
 
+#if defined(OS_LINUX)
+// Linux 4.14 values, for older userspace headers.
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#endif
+
 namespace tin::net {
 
+namespace {
+
+#if defined(OS_LINUX)
+bool UseCompletionIo() {
+  return runtime::UringNetPollActive();
+}
+
+// The io_uring counterpart of ExecIO in netfd_windows.cc: the transfer
+// itself is handed to the kernel and we park until it completes, so the
+// wakeup carries the result rather than a readiness hint to retry
+// read/write on. The op is queued and goes to the kernel when we park,
+// together with whatever other coroutines queued meanwhile.
+int ExecIo(NetFD* fd, int mode, const void* buf, int len, int* n) {
+  runtime::UringOp op;
+  if (mode == 'r') {
+    runtime::UringSubmitRecv(&op, fd->Pd()->Desc(), fd->SysFd(),
+                             const_cast<void*>(buf), len);
+  } else {
+    runtime::UringSubmitSend(&op, fd->Pd()->Desc(), fd->SysFd(), buf, len);
+  }
+  // Readiness from the descriptor's poll request wakes us as well; only
+  // the op completion ends the wait.
+  int err = 0;
+  while (!runtime::UringOpDone(&op)) {
+    err = fd->Pd()->Wait(mode);
+    if (err != 0) {
+      break;
+    }
+  }
+  if (err != 0) {
+    // IO is interrupted by "close" or "timeout". The kernel still owns
+    // buf, so cancel the request and wait for it to complete.
+    runtime::UringCancel(&op);
+    while (!runtime::UringOpDone(&op)) {
+      fd->Pd()->WaitCanceled(mode);
+    }
+  }
+  if (op.res >= 0) {
+    // Possibly completed before the cancellation ran; the bytes were
+    // actually sent/received, so report them.
+    *n = op.res;
+    return 0;
+  }
+  *n = 0;
+  if (err != 0 && op.res == -ECANCELED) {
+    return err;
+  }
+  return -op.res;
+}
+#else
+bool UseCompletionIo() {
+  return false;
+}
+
+int ExecIo(NetFD* fd, int mode, const void* buf, int len, int* n) {
+  LOG(FATAL) << "completion-based io is not supported";
+  return 0;
+}
+#endif
+
+// iovecs handed to one writev/readv; longer vectors are written in
+// several calls (IOV_MAX is 1024 on Linux and macOS).
+const int kMaxIovecs = 64;
+
+// Largest sendfile/splice request, and the pipe size Splice asks for
+// (Go uses the same 1 MiB).
+const int64_t kMaxTransfer = 1 << 20;
+
+#if defined(OS_LINUX)
+// Splice helpers, after Go's internal/poll/splice_linux.go. The caller
+// holds src's read lock and dst's write lock.
+
+// Moves up to kMaxTransfer bytes from the socket into the (empty) pipe.
+// Returns the byte count (0 on EOF) or -error.
+int64_t SpliceDrain(NetFD* src, int pipe_wr) {
+  while (true) {
+    ssize_t n = splice(src->IntFd(), nullptr, pipe_wr, nullptr, kMaxTransfer,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n >= 0) {
+      return n;
+    }
+    int err = errno;
+    if (err == EINTR) {
+      continue;
+    }
+    if (err == EAGAIN) {
+      err = src->Pd()->WaitRead();
+      if (err == 0) {
+        continue;
+      }
+    }
+    return -err;
+  }
+}
+
+// Moves inpipe bytes from the pipe to the socket. Returns 0 or an error.
+int SplicePump(NetFD* dst, int pipe_rd, int64_t inpipe, int64_t* moved) {
+  while (inpipe > 0) {
+    ssize_t n = splice(pipe_rd, nullptr, dst->IntFd(), nullptr, inpipe,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n > 0) {
+      inpipe -= n;
+      *moved += n;
+      continue;
+    }
+    int err = n == 0 ? TIN_UNEXPECTED_EOF : errno;
+    if (err == EINTR) {
+      continue;
+    }
+    if (err == EAGAIN) {
+      err = dst->Pd()->WaitWrite();
+      if (err == 0) {
+        continue;
+      }
+    }
+    return err;
+  }
+  return 0;
+}
+#endif
+
+}  // namespace
+
 NetFD::NetFD(uintptr_t sysfd,
              AddressFamily family,
              int sotype,
              const std::string& net)
-  : NetFDCommon(sysfd, family, sotype, net) {
+  : NetFDCommon(sysfd, family, sotype, net)
+  , zc_state_(0)
+  , zc_next_id_(0)
+  , zc_completed_(0) {
 }
 
 NetFD::~NetFD() {
@@ -49,16 +200,24 @@ int NetFD::Read(void* buf, int len, int* nread) {
     return err;
   }
   while (true) {
-    // non-blocking read should never set EINTR,
-    // however, it's harmless to deal with it.
-    int n = HANDLE_EINTR(read(IntFd(), buf, len));
-    err = (n == -1) ? errno : 0;
-    if (err != 0) {
-      n = 0;
-      if (err == EAGAIN) {
-        err = pd_.WaitRead();
-        if (err == 0) {
-          continue;
+    int n = 0;
+    if (UseCompletionIo()) {
+      // No read(2) first: data already queued completes during the
+      // submitting io_uring_enter, so a speculative read is a syscall
+      // more on every call that would block.
+      err = ExecIo(this, 'r', buf, len, &n);
+    } else {
+      // non-blocking read should never set EINTR,
+      // however, it's harmless to deal with it.
+      n = HANDLE_EINTR(read(IntFd(), buf, len));
+      err = (n == -1) ? errno : 0;
+      if (err != 0) {
+        n = 0;
+        if (err == EAGAIN) {
+          err = pd_.WaitRead();
+          if (err == 0) {
+            continue;
+          }
         }
       }
     }
@@ -79,15 +238,22 @@ int NetFD::Write(const void* buf, int len, int* nwritten) {
   }
   err = pd_.PrepareWrite();
   if (err != 0) {
-    WriteLock();
+    WriteUnlock();
     *nwritten = 0;
     return err;
   }
   const char* ptr = static_cast<const char*>(buf);
   int nn = 0;
+  // As in Read, the ring sends without a speculative write(2) first.
+  bool completion = UseCompletionIo();
   while (true) {
-    int n = HANDLE_EINTR(write(IntFd(), ptr + nn, len - nn));
-    err = (n == -1) ? errno : 0;
+    int n = 0;
+    if (completion) {
+      err = ExecIo(this, 'w', ptr + nn, len - nn, &n);
+    } else {
+      n = HANDLE_EINTR(write(IntFd(), ptr + nn, len - nn));
+      err = (n == -1) ? errno : 0;
+    }
     if (n > 0) {
       nn += n;
     }
@@ -95,7 +261,7 @@ int NetFD::Write(const void* buf, int len, int* nwritten) {
       break;
     }
 
-    if (err == EAGAIN) {
+    if (err == EAGAIN && !completion) {
       err = pd_.WaitWrite();
       // waked up, io ready or error occurred(timeout intr, close intr, etc).
       if (err == 0) {
@@ -114,12 +280,518 @@ int NetFD::Write(const void* buf, int len, int* nwritten) {
   return err;
 }
 
+int NetFD::Writev(const io::ConstBuffer* bufs, int count, size_t* nwritten) {
+  *nwritten = 0;
+  int err = WriteLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareWrite();
+  if (err != 0) {
+    WriteUnlock();
+    return err;
+  }
+  iovec iov[kMaxIovecs];
+  int first = 0;      // first buffer not completely written
+  size_t offset = 0;  // bytes of bufs[first] already written
+  size_t nn = 0;
+  while (true) {
+    while (first < count && offset == bufs[first].size) {
+      first++;
+      offset = 0;
+    }
+    if (first == count) {
+      break;
+    }
+    int niov = 0;
+    for (int i = first; i < count && niov < kMaxIovecs; i++) {
+      size_t skip = i == first ? offset : 0;
+      if (bufs[i].size == skip) {
+        continue;
+      }
+      iov[niov].iov_base =
+          const_cast<char*>(static_cast<const char*>(bufs[i].data)) + skip;
+      iov[niov].iov_len = bufs[i].size - skip;
+      niov++;
+    }
+    ssize_t n = HANDLE_EINTR(writev(IntFd(), iov, niov));
+    err = (n == -1) ? errno : 0;
+    if (n > 0) {
+      nn += n;
+      // Partial write: resume inside the buffer where the kernel stopped.
+      size_t left = static_cast<size_t>(n);
+      while (left > 0) {
+        size_t avail = bufs[first].size - offset;
+        if (left < avail) {
+          offset += left;
+          left = 0;
+        } else {
+          left -= avail;
+          first++;
+          offset = 0;
+        }
+      }
+      continue;
+    }
+    if (err == EAGAIN) {
+      err = pd_.WaitWrite();
+      // waked up, io ready or error occurred(timeout intr, close intr, etc).
+      if (err == 0) {
+        continue;
+      }
+    }
+    if (err != 0)
+      break;
+    err = TIN_UNEXPECTED_EOF;
+    break;
+  }
+  WriteUnlock();
+  *nwritten = nn;
+  return err;
+}
+
+int NetFD::SendFile(int file_fd, int64_t offset, int64_t count,
+                    int64_t* nsent) {
+  *nsent = 0;
+#if defined(OS_LINUX)
+  int err = WriteLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareWrite();
+  if (err != 0) {
+    WriteUnlock();
+    return err;
+  }
+  off_t off = offset;
+  int64_t nn = 0;
+  while (count < 0 || nn < count) {
+    int64_t want = count < 0 ? kMaxTransfer
+                             : std::min(count - nn, kMaxTransfer);
+    ssize_t n = HANDLE_EINTR(sendfile(IntFd(), file_fd, &off, want));
+    err = (n == -1) ? errno : 0;
+    if (n > 0) {
+      nn += n;
+      continue;
+    }
+    if (err == EAGAIN) {
+      err = pd_.WaitWrite();
+      if (err == 0) {
+        continue;
+      }
+    }
+    // n == 0: the file is shorter than requested.
+    break;
+  }
+  WriteUnlock();
+  *nsent = nn;
+  return err;
+#else
+  // No sendfile(2) with these semantics here: pread into a buffer and
+  // Write it out.
+  std::unique_ptr<char[]> buf(new char[kMaxTransfer]);
+  int64_t nn = 0;
+  int err = 0;
+  while (count < 0 || nn < count) {
+    int64_t want = count < 0 ? kMaxTransfer
+                             : std::min(count - nn, kMaxTransfer);
+    ssize_t n = HANDLE_EINTR(pread(file_fd, buf.get(), want, offset + nn));
+    if (n <= 0) {
+      err = n == 0 ? 0 : errno;
+      break;
+    }
+    int nw = 0;
+    err = Write(buf.get(), static_cast<int>(n), &nw);
+    nn += nw;
+    if (err != 0) {
+      break;
+    }
+  }
+  *nsent = nn;
+  return err;
+#endif
+}
+
+int NetFD::SpliceFrom(NetFD* src, int64_t* moved) {
+  *moved = 0;
+#if defined(OS_LINUX)
+  int p[2];
+  if (pipe2(p, O_CLOEXEC | O_NONBLOCK) == -1) {
+    return errno;
+  }
+  // Best effort; the default 64 KiB pipe only means more round trips.
+  fcntl(p[1], F_SETPIPE_SZ, static_cast<int>(kMaxTransfer));
+  int err = src->ReadLock();
+  if (err != 0) {
+    close(p[0]);
+    close(p[1]);
+    return err;
+  }
+  err = src->pd_.PrepareRead();
+  if (err == 0) {
+    err = WriteLock();
+    if (err == 0) {
+      err = pd_.PrepareWrite();
+      while (err == 0) {
+        int64_t n = SpliceDrain(src, p[1]);
+        if (n <= 0) {
+          err = static_cast<int>(-n);
+          break;
+        }
+        err = SplicePump(this, p[0], n, moved);
+      }
+      WriteUnlock();
+    }
+  }
+  src->ReadUnlock();
+  close(p[0]);
+  close(p[1]);
+  return err;
+#else
+  return TIN_ENOSYS;
+#endif
+}
+
+int NetFD::WriteZeroCopy(const void* buf, int len, std::function<void()> done,
+                         int* nwritten) {
+  *nwritten = 0;
+#if defined(OS_LINUX)
+  int err = WriteLock();
+  if (err != 0) {
+    return err;
+  }
+  if (zc_state_ == 0) {
+    int one = 1;
+    zc_state_ = setsockopt(IntFd(), SOL_SOCKET, SO_ZEROCOPY, &one,
+                           sizeof(one)) == 0 ? 1 : -1;
+  }
+  if (zc_state_ < 0) {
+    WriteUnlock();
+    err = Write(buf, len, nwritten);
+    done();
+    return err;
+  }
+  err = pd_.PrepareWrite();
+  if (err != 0) {
+    WriteUnlock();
+    done();
+    return err;
+  }
+  std::vector<std::function<void()>> released;
+  const char* ptr = static_cast<const char*>(buf);
+  int nn = 0;
+  bool sent = false;
+  while (nn < len) {
+    ssize_t n = HANDLE_EINTR(send(IntFd(), ptr + nn, len - nn,
+                                  MSG_ZEROCOPY | MSG_NOSIGNAL));
+    err = (n == -1) ? errno : 0;
+    if (n > 0) {
+      // Every successful zerocopy send is numbered by the kernel.
+      nn += static_cast<int>(n);
+      zc_next_id_++;
+      sent = true;
+      continue;
+    }
+    // ENOBUFS: too many notifications are outstanding (optmem limit).
+    if (err == EAGAIN || err == ENOBUFS) {
+      ReapZeroCopy(&released);
+      err = pd_.WaitWrite();
+      if (err == 0) {
+        continue;
+      }
+    }
+    if (err == 0) {
+      err = TIN_UNEXPECTED_EOF;
+    }
+    break;
+  }
+  if (sent) {
+    zc_pending_.push_back({zc_next_id_ - 1, std::move(done)});
+  } else {
+    released.push_back(std::move(done));
+  }
+  ReapZeroCopy(&released);
+  WriteUnlock();
+  for (auto& fn : released) {
+    fn();
+  }
+  *nwritten = nn;
+  return err;
+#else
+  int err = Write(buf, len, nwritten);
+  done();
+  return err;
+#endif
+}
+
+int NetFD::WaitZeroCopy() {
+#if defined(OS_LINUX)
+  int err = WriteLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareWrite();
+  std::vector<std::function<void()>> released;
+  while (err == 0) {
+    ReapZeroCopy(&released);
+    if (zc_pending_.empty()) {
+      break;
+    }
+    // A notification raises EPOLLERR, which wakes writers as well.
+    err = pd_.WaitWrite();
+  }
+  WriteUnlock();
+  for (auto& fn : released) {
+    fn();
+  }
+  return err;
+#else
+  return 0;
+#endif
+}
+
+void NetFD::ReapZeroCopy(std::vector<std::function<void()>>* done) {
+#if defined(OS_LINUX)
+  if (zc_state_ <= 0) {
+    return;
+  }
+  // Drained even with nothing pending: the sends of a write in progress
+  // are not queued yet, and their notifications still hold optmem.
+  while (true) {
+    char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (HANDLE_EINTR(recvmsg(IntFd(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT)) ==
+        -1) {
+      break;
+    }
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+         cm = CMSG_NXTHDR(&msg, cm)) {
+      bool recverr =
+          (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+          (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+      if (!recverr) {
+        continue;
+      }
+      const sock_extended_err* serr =
+          reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+      if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      // [ee_info, ee_data] is the range of send ids released. TCP reports
+      // them in order, so everything up to ee_data is done.
+      uint32_t completed = serr->ee_data + 1;
+      if (static_cast<int32_t>(completed - zc_completed_) > 0) {
+        zc_completed_ = completed;
+      }
+    }
+  }
+  while (!zc_pending_.empty() &&
+         static_cast<int32_t>(zc_pending_.front().last_id -
+                              zc_completed_) < 0) {
+    done->push_back(std::move(zc_pending_.front().done));
+    zc_pending_.pop_front();
+  }
+#endif
+}
+
+int NetFD::Dup(int* fd) {
+  *fd = fcntl(IntFd(), F_DUPFD_CLOEXEC, 0);
+  return *fd == -1 ? errno : 0;
+}
+
+int NetFD::ReadMsg(msghdr* msg, int* n, int flags) {
+  *n = 0;
+  int err = ReadLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareRead();
+  while (err == 0) {
+    ssize_t nn = HANDLE_EINTR(recvmsg(IntFd(), msg, flags));
+    err = (nn == -1) ? errno : 0;
+    if (err == EAGAIN) {
+      err = pd_.WaitRead();
+      if (err == 0) {
+        continue;
+      }
+    }
+    if (err == 0) {
+      *n = static_cast<int>(nn);
+      err = EofError(*n, 0);
+    }
+    break;
+  }
+  ReadUnlock();
+  return err;
+}
+
+int NetFD::WriteMsg(const msghdr* msg, int* n) {
+  *n = 0;
+  int err = WriteLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareWrite();
+  while (err == 0) {
+    ssize_t nn = HANDLE_EINTR(sendmsg(IntFd(), msg, 0));
+    err = (nn == -1) ? errno : 0;
+    if (err == EAGAIN) {
+      err = pd_.WaitWrite();
+      if (err == 0) {
+        continue;
+      }
+    }
+    if (err == 0) {
+      *n = static_cast<int>(nn);
+    }
+    break;
+  }
+  WriteUnlock();
+  return err;
+}
+
+int NetFD::ReadMsgs(MultiMsg* msgs, int count, int* nmsgs) {
+  *nmsgs = 0;
+  int err = ReadLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareRead();
+  while (err == 0) {
+#if defined(OS_LINUX)
+    int n = HANDLE_EINTR(recvmmsg(IntFd(), msgs, count, 0, nullptr));
+    err = (n == -1) ? errno : 0;
+#else
+    int n = 0;
+    while (n < count) {
+      ssize_t nn = HANDLE_EINTR(recvmsg(IntFd(), &msgs[n].msg_hdr, 0));
+      if (nn == -1) {
+        err = errno;
+        break;
+      }
+      msgs[n].msg_len = static_cast<unsigned int>(nn);
+      n++;
+    }
+    if (n > 0) {
+      err = 0;
+    }
+#endif
+    if (err == EAGAIN) {
+      err = pd_.WaitRead();
+      if (err == 0) {
+        continue;
+      }
+    }
+    if (err == 0) {
+      *nmsgs = n;
+    }
+    break;
+  }
+  ReadUnlock();
+  return err;
+}
+
+int NetFD::WriteMsgs(MultiMsg* msgs, int count, int* nmsgs) {
+  *nmsgs = 0;
+  int err = WriteLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareWrite();
+  int done = 0;
+  while (err == 0 && done < count) {
+#if defined(OS_LINUX)
+    int n = HANDLE_EINTR(sendmmsg(IntFd(), msgs + done, count - done, 0));
+    err = (n == -1) ? errno : 0;
+#else
+    int n = 0;
+    while (done + n < count) {
+      MultiMsg* m = &msgs[done + n];
+      ssize_t nn = HANDLE_EINTR(sendmsg(IntFd(), &m->msg_hdr, 0));
+      if (nn == -1) {
+        err = errno;
+        break;
+      }
+      m->msg_len = static_cast<unsigned int>(nn);
+      n++;
+    }
+    if (n > 0) {
+      err = 0;
+    }
+#endif
+    if (n > 0) {
+      done += n;
+      continue;
+    }
+    if (err == EAGAIN) {
+      err = pd_.WaitWrite();
+    }
+  }
+  WriteUnlock();
+  *nmsgs = done;
+  return err;
+}
+
+int NetFD::Readv(const io::MutableBuffer* bufs, int count, size_t* nread) {
+  *nread = 0;
+  int err = ReadLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareRead();
+  if (err != 0) {
+    ReadUnlock();
+    return err;
+  }
+  iovec iov[kMaxIovecs];
+  int niov = 0;
+  for (int i = 0; i < count && niov < kMaxIovecs; i++) {
+    iov[niov].iov_base = bufs[i].data;
+    iov[niov].iov_len = bufs[i].size;
+    niov++;
+  }
+  while (true) {
+    ssize_t n = HANDLE_EINTR(readv(IntFd(), iov, niov));
+    err = (n == -1) ? errno : 0;
+    if (err != 0) {
+      n = 0;
+      if (err == EAGAIN) {
+        err = pd_.WaitRead();
+        if (err == 0) {
+          continue;
+        }
+      }
+    }
+    err = EofError(static_cast<int>(n), err);
+    if (!err)
+      *nread = n;
+    break;
+  }
+  ReadUnlock();
+  return err;
+}
+
 void NetFD::Destroy() {
   if (sysfd_ == kInvalidSocket)
     return;
+  // Notifications that already arrived release their buffers first. No
+  // more can come once the socket is gone, and the kernel holds its own
+  // page references, so the rest are handed back after the close.
+  std::vector<std::function<void()>> released;
+  ReapZeroCopy(&released);
   pd_.Close();
   close(IntFd());
   sysfd_ = kInvalidSocket;
+  for (auto& send : zc_pending_) {
+    released.push_back(std::move(send.done));
+  }
+  zc_pending_.clear();
+  for (auto& fn : released) {
+    fn();
+  }
 }
 
 int NetFD::Shutdown(int how) {
@@ -178,6 +850,18 @@ int NetFD::Dial(IpEndpoint* local, IpEndpoint* remote, int64_t deadline) {
   return 0;
 }
 
+int NetFD::DialAddr(SockaddrStorage* raddr, int64_t deadline) {
+  int err = Connect(nullptr, raddr, deadline);
+  if (err == 0) {
+    is_connected_ = true;
+  }
+  return err;
+}
+
+int NetFD::BindAddr(const SockaddrStorage& addr) {
+  return bind(sysfd_, addr.addr, addr.addr_len) == -1 ? errno : 0;
+}
+
 int NetFD::Bind(const IpEndpoint& address) {
   int err = 0;
   SockaddrStorage storage;
@@ -225,6 +909,62 @@ int NetFD::Accept(NetFD** newfd) {
 }
 
 
+int NetFD::AcceptBatch(int max, std::vector<NetFD*>* newfds) {
+  if (max <= 0) {
+    max = 1;
+  }
+  int err = ReadLock();
+  if (err != 0) {
+    return err;
+  }
+  err = pd_.PrepareRead();
+  if (err != 0) {
+    ReadUnlock();
+    return err;
+  }
+  std::vector<int> fds;
+  while (true) {
+    while (static_cast<int>(fds.size()) < max) {
+      int fd = tin::Accept(IntFd(), nullptr, nullptr);
+      err = fd == -1 ? errno : 0;
+      if (err == ECONNABORTED) {
+        continue;
+      }
+      if (err != 0) {
+        break;
+      }
+      fds.push_back(fd);
+    }
+    if (!fds.empty()) {
+      // Whatever stopped the drain shows up again on the next call.
+      err = 0;
+      break;
+    }
+    if (err == EAGAIN) {
+      err = pd_.WaitRead();
+      if (err == 0) {
+        continue;
+      }
+    }
+    break;
+  }
+  ReadUnlock();
+
+  // Registration happens outside the listener's read lock. With the
+  // io_uring poller the registrations are queued and reach the kernel
+  // together with the next poll.
+  for (int fd : fds) {
+    std::unique_ptr<NetFD> netfd(new NetFD(fd, family_, sotype_, net_));
+    int init_err = netfd->Init();
+    if (init_err != 0) {
+      err = init_err;
+      continue;
+    }
+    newfds->push_back(netfd.release());
+  }
+  return newfds->empty() ? err : 0;
+}
+
 int NetFD::AcceptImpl(NetFD** newfd) {
   int err = ReadLock();
   if (err != 0) {
@@ -300,6 +1040,13 @@ int NetFD::Connect(SockaddrStorage* laddr, SockaddrStorage* raddr,
   if (err != 0) {
     return err;
   }
+  // A concurrent Close that ran before Init had no poll descriptor to
+  // evict; without this check WaitWrite would sit out the whole connect.
+  err = Incref();
+  if (err != 0) {
+    return err;
+  }
+  Decref();
   if (deadline != 0)
     SetWriteDeadline(deadline);
 
@@ -369,4 +1116,50 @@ NetFD* NewFD(AddressFamily family, int sotype, int* error_code) {
   return new NetFD(sysfd, family, sotype, "unused");
 }
 
+NetFD* NewFDFromFile(int fd, int* error_code) {
+  int sotype = 0;
+  socklen_t len = sizeof(sotype);
+  int err = getsockopt(fd, SOL_SOCKET, SO_TYPE, &sotype, &len) == -1 ? errno
+                                                                     : 0;
+  SockaddrStorage storage;
+  if (err == 0) {
+    err = getsockname(fd, storage.addr, &storage.addr_len) == -1 ? errno : 0;
+  }
+  AddressFamily family = ADDRESS_FAMILY_UNSPECIFIED;
+  if (err == 0) {
+    switch (storage.addr->sa_family) {
+    case AF_INET:
+      family = ADDRESS_FAMILY_IPV4;
+      break;
+    case AF_INET6:
+      family = ADDRESS_FAMILY_IPV6;
+      break;
+    case AF_UNIX:
+      family = ADDRESS_FAMILY_UNIX;
+      break;
+    default:
+      err = EAFNOSUPPORT;
+    }
+  }
+  if (err == 0) {
+    err = (Cloexec(fd, true) == -1) ? errno : 0;
+  }
+  if (err == 0) {
+    err = (Nonblock(fd, true) == -1) ? errno : 0;
+  }
+  std::unique_ptr<NetFD> netfd;
+  if (err == 0) {
+    netfd.reset(new NetFD(fd, family, sotype, "file"));
+    err = netfd->Init();
+  } else {
+    close(fd);
+  }
+  if (err != 0) {
+    if (error_code != nullptr)
+      *error_code = err;
+    return nullptr;
+  }
+  return netfd.release();
+}
+
 }  // namespace tin::net
@@ -4,7 +4,14 @@
 
 #ifndef TIN_NET_NETFD_POSIX_H_
 #define TIN_NET_NETFD_POSIX_H_
+#include <sys/socket.h>
+
+#include <deque>
+#include <functional>
 #include <string>
+#include <vector>
+#include "build/build_config.h"
+#include "tin/io/io.h"
 #include "tin/net/fd_mutex.h"
 #include "tin/net/poll_desc.h"
 #include "tin/net/address_list.h"
@@ -14,6 +21,16 @@
 
 namespace tin::net {
 
+// One message of a ReadMsgs/WriteMsgs batch.
+#if defined(OS_LINUX)
+using MultiMsg = mmsghdr;
+#else
+struct MultiMsg {
+  msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
 class NetFD : public NetFDCommon {
  public:
   NetFD(uintptr_t sysfd,
@@ -29,6 +46,50 @@ class NetFD : public NetFDCommon {
 
   int Write(const void* buf, int len, int* nwritten);
 
+  // Vectored Write/Read over count buffers (writev/readv). Writev writes
+  // everything unless an error or the deadline stops it.
+  int Writev(const io::ConstBuffer* bufs, int count, size_t* nwritten);
+
+  int Readv(const io::MutableBuffer* bufs, int count, size_t* nread);
+
+  // Sends count bytes (count < 0: up to EOF) of file_fd starting at
+  // offset, without touching the file's own offset. Stops early, with no
+  // error, if the file ends first.
+  int SendFile(int file_fd, int64_t offset, int64_t count, int64_t* nsent);
+
+  // Moves everything src reads, until EOF, to this socket. Returns
+  // TIN_ENOSYS where there is no kernel fast path; the caller then copies.
+  int SpliceFrom(NetFD* src, int64_t* moved);
+
+  // Write with MSG_ZEROCOPY: the kernel sends straight from buf and done
+  // runs once it has let go of it (see ReapZeroCopy). Falls back to Write
+  // followed by done() where SO_ZEROCOPY is unavailable.
+  int WriteZeroCopy(const void* buf, int len, std::function<void()> done,
+                    int* nwritten);
+
+  // Waits, under the write deadline, until every WriteZeroCopy buffer has
+  // been released and its done has run.
+  int WaitZeroCopy();
+
+  // Duplicates the socket (close-on-exec) into *fd, which the caller owns,
+  // e.g. to pass it to another process with UnixConn::SendFds.
+  int Dup(int* fd);
+
+  // recvmsg/sendmsg, e.g. for datagrams or ancillary data. *n is the
+  // payload size moved; flags go to recvmsg (e.g. MSG_CMSG_CLOEXEC).
+  int ReadMsg(msghdr* msg, int* n, int flags = 0);
+
+  int WriteMsg(const msghdr* msg, int* n);
+
+  // Batched datagram I/O with recvmmsg/sendmmsg (a recvmsg/sendmsg loop
+  // where those do not exist); msg_len of each message is set. ReadMsgs
+  // waits for at least one message and returns what is queued, up to
+  // count; WriteMsgs sends all count messages unless an error stops it.
+  // *nmsgs is the number of messages moved.
+  int ReadMsgs(MultiMsg* msgs, int count, int* nmsgs);
+
+  int WriteMsgs(MultiMsg* msgs, int count, int* nmsgs);
+
   virtual void Destroy();
 
   int Shutdown(int how);
@@ -41,10 +102,20 @@ class NetFD : public NetFDCommon {
 
   int Bind(const IpEndpoint& address);
 
+  // Dial/Bind for addresses IpEndpoint cannot hold, e.g. AF_UNIX paths.
+  int DialAddr(SockaddrStorage* raddr, int64_t deadline);
+
+  int BindAddr(const SockaddrStorage& addr);
+
   int Listen(int backlog = 511);
 
   int Accept(NetFD** newfd);
 
+  // Accepts up to max connections in one go: waits until at least one is
+  // pending, then drains the backlog until EAGAIN or max, and registers
+  // the new fds with the poller afterwards.
+  int AcceptBatch(int max, std::vector<NetFD*>* newfds);
+
   int EofError(int n, int err);
 
   int GetSockOpt(int level, int name, void* optval,
@@ -58,9 +129,31 @@ class NetFD : public NetFDCommon {
  private:
   int Connect(SockaddrStorage* laddr, SockaddrStorage* raddr, int64_t deadline);
   int AcceptImpl(NetFD** newfd);
+
+  // Drains the zerocopy notifications from the socket error queue into
+  // zc_completed_ and moves the done callbacks of released buffers to
+  // *done. Caller holds the write lock and runs *done after unlocking.
+  void ReapZeroCopy(std::vector<std::function<void()>>* done);
+
+  struct ZeroCopySend {
+    uint32_t last_id;  // id of the last MSG_ZEROCOPY send of the write
+    std::function<void()> done;
+  };
+  // Guarded by the write lock.
+  int zc_state_;  // 0: not tried, 1: SO_ZEROCOPY on, -1: unsupported
+  uint32_t zc_next_id_;
+  // One past the highest send id the kernel has released. Notifications
+  // may arrive before their write is queued in zc_pending_.
+  uint32_t zc_completed_;
+  std::deque<ZeroCopySend> zc_pending_;
 };
 
 NetFD* NewFD(AddressFamily family, int sotype, int* error_code = nullptr);
 
+// Wraps an existing socket, e.g. one received with SCM_RIGHTS, taking
+// ownership of fd (it is closed on failure too). The family and type are
+// read from the socket; it is made non-blocking and close-on-exec.
+NetFD* NewFDFromFile(int fd, int* error_code = nullptr);
+
 }  // namespace tin::net
 #endif  // TIN_NET_NETFD_POSIX_H_
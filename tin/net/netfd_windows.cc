@@ -5,6 +5,10 @@
 #include <winsock2.h>
 #include <Mswsock.h>
 #include <mstcpip.h>
+#include <io.h>
+
+#include <algorithm>
+#include <memory>
 
 #include <absl/log/log.h>
 #include <absl/log/check.h>
@@ -73,13 +77,13 @@ int WinSubmitIO(Operation* op) {
   op->flags = 0;
   switch (op->io_type) {
   case kWSARecv: {
-    err = WSARecv(op->fd->SysFd(), &op->buf, 1, &op->qty, &op->flags,
+    err = WSARecv(op->fd->SysFd(), op->bufs, op->nbufs, &op->qty, &op->flags,
                   &op->overlapped, nullptr);
     break;
   }
   case kWSASend: {
-    err = WSASend(op->fd->SysFd(), &op->buf, 1, &op->qty, 0, &op->overlapped,
-                  nullptr);
+    err = WSASend(op->fd->SysFd(), op->bufs, op->nbufs, &op->qty, 0,
+                  &op->overlapped, nullptr);
     break;
   }
   case kWSARecvFrom: {
@@ -571,6 +575,15 @@ int NetFD::Accept(NetFD** new_fd) {
   return err;
 }
 
+int NetFD::AcceptBatch(int max, std::vector<NetFD*>* newfds) {
+  NetFD* net_fd = nullptr;
+  int err = Accept(&net_fd);
+  if (err == 0) {
+    newfds->push_back(net_fd);
+  }
+  return err;
+}
+
 int NetFD::Read(void* buf, int len, int* nread) {
   int err = ReadLock();
   if (err != 0)
@@ -606,4 +619,141 @@ int NetFD::Write(const void* buf, int len, int* nwritten) {
   return err;
 }
 
+int NetFD::Writev(const io::ConstBuffer* bufs, int count, size_t* nwritten) {
+  *nwritten = 0;
+  int err = WriteLock();
+  if (err != 0)
+    return err;
+
+  std::vector<WSABUF> wsabufs;
+  wsabufs.reserve(count);
+  for (int i = 0; i < count; i++) {
+    if (bufs[i].size == 0)
+      continue;
+    WSABUF b;
+    b.buf = const_cast<char*>(static_cast<const char*>(bufs[i].data));
+    b.len = static_cast<ULONG>(bufs[i].size);
+    wsabufs.push_back(b);
+  }
+  Operation* op = &wop_;
+  op->io_type = kWSASend;
+  size_t nn = 0;
+  size_t first = 0;
+  while (first < wsabufs.size()) {
+    op->InitBufs(&wsabufs[first], static_cast<DWORD>(wsabufs.size() - first));
+    int n = 0;
+    err = rsrv->ExecIO(op, &n);
+    if (err != 0)
+      break;
+    if (n == 0) {
+      err = TIN_UNEXPECTED_EOF;
+      break;
+    }
+    nn += n;
+    // Skip what a partial send consumed.
+    while (n > 0) {
+      WSABUF& b = wsabufs[first];
+      if (static_cast<ULONG>(n) < b.len) {
+        b.buf += n;
+        b.len -= n;
+        n = 0;
+      } else {
+        n -= b.len;
+        first++;
+      }
+    }
+  }
+  op->InitBuf(nullptr, 0);
+  *nwritten = nn;
+
+  WriteUnlock();
+  return err;
+}
+
+// TransmitFile would need its own IOCP operation type; until then the file
+// is read at explicit offsets into a buffer and written out.
+int NetFD::SendFile(int file_fd, int64_t offset, int64_t count,
+                    int64_t* nsent) {
+  *nsent = 0;
+  HANDLE h = reinterpret_cast<HANDLE>(_get_osfhandle(file_fd));
+  if (h == INVALID_HANDLE_VALUE)
+    return TIN_EBADF;
+
+  const int64_t kChunk = 1 << 20;
+  std::unique_ptr<char[]> buf(new char[kChunk]);
+  int64_t nn = 0;
+  int err = 0;
+  while (count < 0 || nn < count) {
+    int64_t want = count < 0 ? kChunk : std::min(count - nn, kChunk);
+    uint64_t pos = static_cast<uint64_t>(offset + nn);
+    OVERLAPPED ov;
+    ZeroMemory(&ov, sizeof(ov));
+    ov.Offset = static_cast<DWORD>(pos);
+    ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+    DWORD got = 0;
+    if (!ReadFile(h, buf.get(), static_cast<DWORD>(want), &got, &ov)) {
+      DWORD e = GetLastError();
+      if (e != ERROR_HANDLE_EOF)
+        err = static_cast<int>(e);
+      break;
+    }
+    if (got == 0)
+      break;
+    int nw = 0;
+    err = Write(buf.get(), static_cast<int>(got), &nw);
+    nn += nw;
+    if (err != 0)
+      break;
+  }
+  *nsent = nn;
+  return err;
+}
+
+int NetFD::SpliceFrom(NetFD* src, int64_t* moved) {
+  *moved = 0;
+  return TIN_ENOSYS;
+}
+
+int NetFD::WriteZeroCopy(const void* buf, int len, std::function<void()> done,
+                         int* nwritten) {
+  *nwritten = 0;
+  int err = Write(buf, len, nwritten);
+  done();
+  return err;
+}
+
+int NetFD::WaitZeroCopy() {
+  return 0;
+}
+
+int NetFD::Dup(int* fd) {
+  *fd = -1;
+  return TIN_ENOSYS;
+}
+
+int NetFD::Readv(const io::MutableBuffer* bufs, int count, size_t* nread) {
+  *nread = 0;
+  int err = ReadLock();
+  if (err != 0)
+    return err;
+
+  std::vector<WSABUF> wsabufs(count);
+  for (int i = 0; i < count; i++) {
+    wsabufs[i].buf = static_cast<char*>(bufs[i].data);
+    wsabufs[i].len = static_cast<ULONG>(bufs[i].size);
+  }
+  Operation* op = &rop_;
+  op->InitBufs(wsabufs.data(), static_cast<DWORD>(count));
+  op->io_type = kWSARecv;
+  int n = 0;
+  err = rsrv->ExecIO(op, &n);
+  op->InitBuf(nullptr, 0);
+  err = EofError(n, err);
+  if (err == 0)
+    *nread = n;
+
+  ReadUnlock();
+  return err;
+}
+
 }  // namespace tin::net
@@ -6,10 +6,13 @@
 #define TIN_NET_NETFD_WINDOWS_H_
 #include <windows.h>
 #include <winsock2.h>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include <absl/strings/string_view.h>
 #include "tin/platform/platform_win.h"
+#include "tin/io/io.h"
 #include "tin/net/fd_mutex.h"
 #include "tin/net/poll_desc.h"
 #include "tin/net/address_list.h"
@@ -34,6 +37,8 @@ struct Operation {
     , flags(0)
     , fd(nullptr)
     , mode(0)
+    , bufs(&buf)
+    , nbufs(1)
     , err_chan(tin::MakeChan<int>(1)) {
   }
 
@@ -43,6 +48,14 @@ struct Operation {
   void InitBuf(void* ptr, int len) {
     buf.buf = static_cast<char*>(ptr);
     buf.len = len;
+    bufs = &buf;
+    nbufs = 1;
+  }
+
+  // Scatter/gather: v must outlive the operation.
+  void InitBufs(WSABUF* v, DWORD n) {
+    bufs = v;
+    nbufs = n;
   }
 
   int io_type;
@@ -54,6 +67,8 @@ struct Operation {
 
   NetFD* fd;
   WSABUF buf;
+  WSABUF* bufs;   // buffers passed to WSARecv/WSASend
+  DWORD nbufs;
   SockaddrStorage* sa;
   DWORD flags;
   uintptr_t handle;  // listen socket handle.
@@ -77,6 +92,30 @@ class NetFD : public NetFDCommon {
 
   int Write(const void* buf, int len, int* nwritten);
 
+  // Vectored Write/Read over count buffers (writev/readv). Writev writes
+  // everything unless an error or the deadline stops it.
+  int Writev(const io::ConstBuffer* bufs, int count, size_t* nwritten);
+
+  int Readv(const io::MutableBuffer* bufs, int count, size_t* nread);
+
+  // Sends count bytes (count < 0: up to EOF) of file_fd starting at
+  // offset, without touching the file's own offset. Stops early, with no
+  // error, if the file ends first.
+  int SendFile(int file_fd, int64_t offset, int64_t count, int64_t* nsent);
+
+  // Moves everything src reads, until EOF, to this socket. Returns
+  // TIN_ENOSYS where there is no kernel fast path; the caller then copies.
+  int SpliceFrom(NetFD* src, int64_t* moved);
+
+  // No MSG_ZEROCOPY counterpart: Write followed by done().
+  int WriteZeroCopy(const void* buf, int len, std::function<void()> done,
+                    int* nwritten);
+
+  int WaitZeroCopy();
+
+  // No SCM_RIGHTS handoff on Windows: TIN_ENOSYS.
+  int Dup(int* fd);
+
   virtual void Destroy();
 
   int Shutdown(int how);
@@ -93,6 +132,9 @@ class NetFD : public NetFDCommon {
 
   int Accept(NetFD** newfd);
 
+  // AcceptEx completes one connection at a time; returns a batch of one.
+  int AcceptBatch(int max, std::vector<NetFD*>* newfds);
+
   int EofError(int n, int err);
 
   int GetSockOpt(int level, int name, void* optval, socklen_t* optlen);
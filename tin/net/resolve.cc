@@ -12,6 +12,7 @@
 #include <netdb.h>
 #endif
 
+#include <cerrno>
 #include <memory>
 #include <vector>
 
@@ -19,10 +20,14 @@
 #include <absl/log/check.h>
 
 #include "tin/error/error.h"
+#include "tin/runtime/env.h"
 #include "tin/runtime/util.h"
 #include "tin/runtime/runtime.h"
 #include "tin/runtime/threadpoll.h"
 #include "tin/net/ip_endpoint.h"
+#if defined(OS_POSIX)
+#include "tin/net/dns_resolver.h"
+#endif
 
 #include "tin/net/resolve.h"
 
@@ -73,6 +78,7 @@ class ResolveHostnameWork : public CoroWork {
                       AddressFamily& family,  // NOLINT
                       std::vector<IpAddress>*& addresses)  // NOLINT
     : result_(0)
+    , sys_errno_(0)
     , hostname_(hostname)
     , family_(family)
     , addresses_(addresses) {
@@ -82,6 +88,8 @@ class ResolveHostnameWork : public CoroWork {
 
   virtual void Run() {
     result_ = SyncResolveHostname(hostname_, family_, addresses_);
+    // EAI_SYSTEM leaves the cause in this pool thread's errno.
+    sys_errno_ = errno;
     Finalize();
   }
 
@@ -89,8 +97,13 @@ class ResolveHostnameWork : public CoroWork {
     return result_;
   }
 
+  int SysErrno() {
+    return sys_errno_;
+  }
+
  private:
   int  result_;
+  int  sys_errno_;
   const absl::string_view& hostname_;
   AddressFamily& family_;
   std::vector<IpAddress>*& addresses_;
@@ -102,12 +115,18 @@ Status ResolveHostname(const absl::string_view& hostname,
   if (addresses == nullptr) {
     return Status::FromErrno(TIN_EINVAL);
   }
+#if defined(OS_POSIX)
+  if (rtm_conf->IsNativeResolverEnabled()) {
+    return ResolveHostnameNative(hostname, family, addresses);
+  }
+#endif
   std::unique_ptr<ResolveHostnameWork> work(
     new ResolveHostnameWork(hostname, family, addresses));
   SubmitGetAddrInfoCoroWork(work.get());
   int ret = work->Result();
   if (ret != 0) {
-    return Status::FromErrno(TinGetaddrinfoTranslateError(ret));
+    return Status::FromErrno(
+        TinGetaddrinfoTranslateError(ret, work->SysErrno()));
   }
   return Status::OK();
 }
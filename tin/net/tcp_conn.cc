@@ -3,6 +3,9 @@
 // found in the LICENSE file.
 
 #include "build/build_config.h"
+#if defined(OS_POSIX)
+#include <sys/ioctl.h>
+#endif
 #include <absl/log/log.h>
 #include <absl/log/check.h>
 #include  <absl/strings/string_view.h>
@@ -57,6 +60,93 @@ Result<size_t> TcpConnImpl::Write(const void* buf, int nbytes) {
   return Result<size_t>::Ok(0);
 }
 
+Result<size_t> TcpConnImpl::Writev(std::span<const io::ConstBuffer> bufs) {
+  size_t nwritten = 0;
+  int err = netfd_->Writev(bufs.data(), static_cast<int>(bufs.size()),
+                           &nwritten);
+  if (nwritten > 0) {
+    return Result<size_t>::Ok(nwritten);
+  }
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(0);
+}
+
+Result<size_t> TcpConnImpl::Readv(std::span<const io::MutableBuffer> bufs) {
+  size_t nread = 0;
+  int err = netfd_->Readv(bufs.data(), static_cast<int>(bufs.size()), &nread);
+  if (nread > 0) {
+    total_read_bytes_ += nread;
+    return Result<size_t>::Ok(nread);
+  }
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(0);
+}
+
+Result<size_t> TcpConnImpl::Available() const {
+#if defined(OS_POSIX)
+  int n = 0;
+  if (ioctl(netfd_->IntFd(), FIONREAD, &n) != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(errno));
+  }
+#else
+  u_long n = 0;
+  if (ioctlsocket(static_cast<SOCKET>(netfd_->SysFd()), FIONREAD, &n) != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(WSAGetLastError()));
+  }
+#endif
+  return Result<size_t>::Ok(static_cast<size_t>(n));
+}
+
+Result<size_t> TcpConnImpl::SendFile(int fd, int64_t offset, int64_t count) {
+  int64_t nsent = 0;
+  int err = netfd_->SendFile(fd, offset, count, &nsent);
+  if (nsent > 0) {
+    return Result<size_t>::Ok(static_cast<size_t>(nsent));
+  }
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(0);
+}
+
+Result<size_t> TcpConnImpl::SpliceFrom(TcpConnImpl* src) {
+  int64_t moved = 0;
+  int err = netfd_->SpliceFrom(src->netfd_.get(), &moved);
+  if (err == TIN_ENOSYS) {
+    const int kCopyBufferSize = 32 * 1024;
+    std::unique_ptr<char[]> buf(new char[kCopyBufferSize]);
+    return io::CopyBuffer(this, src, buf.get(), kCopyBufferSize);
+  }
+  src->total_read_bytes_ += moved;
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(moved));
+}
+
+Result<size_t> TcpConnImpl::WriteZeroCopy(const void* buf, int nbytes,
+                                          std::function<void()> done) {
+  LOG_IF(FATAL, nbytes == 0) << "WriteZeroCopy on zero buffer.";
+  int nwritten = 0;
+  int err = netfd_->WriteZeroCopy(buf, nbytes, std::move(done), &nwritten);
+  if (nwritten > 0) {
+    return Result<size_t>::Ok(static_cast<size_t>(nwritten));
+  }
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(0);
+}
+
+Status TcpConnImpl::WaitZeroCopy() {
+  int err = netfd_->WaitZeroCopy();
+  return Status::FromErrno(TinTranslateSysError(err));
+}
+
 void TcpConnImpl::SetDeadline(int64_t t) {
   netfd_->SetDeadline(t);
 }
@@ -130,6 +220,26 @@ void TcpConnImpl::Close() {
   netfd_->Close();
 }
 
+bool TcpConnImpl::ProbeIdle() {
+#if defined(OS_POSIX)
+  char c;
+  ssize_t n = recv(netfd_->IntFd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  // 0: the peer closed; > 0: unsolicited data, the stream is out of sync.
+  return n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#else
+  return true;
+#endif
+}
+
+Result<int> TcpConnImpl::File() {
+  int fd = -1;
+  int err = netfd_->Dup(&fd);
+  if (err != 0) {
+    return Result<int>::Err(TinTranslateSysError(err));
+  }
+  return Result<int>::Ok(fd);
+}
+
 // ---------------------------------------------------------------------------
 // TcpConn ? PIMPL forwarding methods (public API).
 // ---------------------------------------------------------------------------
@@ -144,6 +254,57 @@ Result<size_t> TcpConn::Write(const void* buf, int nbytes) {
                : Result<size_t>::Err(TIN_EBADF);
 }
 
+Result<size_t> TcpConn::Writev(std::span<const io::ConstBuffer> bufs) {
+  return impl_ ? impl_->Writev(bufs)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> TcpConn::Readv(std::span<const io::MutableBuffer> bufs) {
+  return impl_ ? impl_->Readv(bufs)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> TcpConn::Available() const {
+  return impl_ ? impl_->Available() : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> TcpConn::SendFile(int fd, int64_t offset, int64_t count) {
+  return impl_ ? impl_->SendFile(fd, offset, count)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> TcpConn::WriteZeroCopy(const void* buf, int nbytes,
+                                      std::function<void()> done) {
+  if (!impl_) {
+    done();
+    return Result<size_t>::Err(TIN_EBADF);
+  }
+  return impl_->WriteZeroCopy(buf, nbytes, std::move(done));
+}
+
+Status TcpConn::WaitZeroCopy() {
+  return impl_ ? impl_->WaitZeroCopy() : Status::FromErrno(TIN_EBADF);
+}
+
+Result<size_t> TcpConn::ReadFrom(io::Reader* r) {
+  if (TcpConn* src = dynamic_cast<TcpConn*>(r)) {
+    return Splice(*src, *this);
+  }
+  if (!impl_) {
+    return Result<size_t>::Err(TIN_EBADF);
+  }
+  const int kCopyBufferSize = 32 * 1024;
+  std::unique_ptr<char[]> buf(new char[kCopyBufferSize]);
+  return io::CopyBuffer(this, r, buf.get(), kCopyBufferSize);
+}
+
+Result<size_t> Splice(TcpConn& src, TcpConn& dst) {
+  if (!src.impl_ || !dst.impl_) {
+    return Result<size_t>::Err(TIN_EBADF);
+  }
+  return dst.impl_->SpliceFrom(src.impl_.get());
+}
+
 void TcpConn::SetDeadline(int64_t t) {
   if (impl_) impl_->SetDeadline(t);
 }
@@ -202,10 +363,18 @@ void TcpConn::Close() {
   if (impl_) impl_->Close();
 }
 
+Result<int> TcpConn::File() {
+  return impl_ ? impl_->File() : Result<int>::Err(TIN_EBADF);
+}
+
 int64_t TcpConn::TotalReadBytes() const {
   return impl_ ? impl_->TotalReadBytes() : 0;
 }
 
+bool ProbeIdleTcpConn(const TcpConn& conn) {
+  return conn.impl_ && conn.impl_->ProbeIdle();
+}
+
 // Factory: single allocation via std::make_shared.
 TcpConn MakeTcpConn(std::unique_ptr<NetFD> netfd) {
   return TcpConn(std::make_shared<TcpConnImpl>(std::move(netfd)));
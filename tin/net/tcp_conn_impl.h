@@ -8,7 +8,9 @@
 
 #ifndef TIN_NET_TCP_CONN_IMPL_H_
 #define TIN_NET_TCP_CONN_IMPL_H_
+#include <functional>
 #include <memory>
+#include <span>
 
 #include "tin/net/sys_socket.h"
 #include "tin/time/time.h"
@@ -24,6 +26,10 @@ class TcpConn;  // forward-declared; full definition in public header
 // Internal only —not exposed in the public API.
 TcpConn MakeTcpConn(std::unique_ptr<NetFD> netfd);
 
+// For connection pools: true if conn is open and has nothing to read,
+// checked with a non-blocking recv(MSG_PEEK). Defined in tcp_conn.cc.
+bool ProbeIdleTcpConn(const TcpConn& conn);
+
 class TcpConnImpl
   : public std::enable_shared_from_this<TcpConnImpl>
   , public tin::io::IoReadWriter {
@@ -36,6 +42,14 @@ class TcpConnImpl
 
   Result<size_t> Read(void* buf, int nbytes) override;
   Result<size_t> Write(const void* buf, int nbytes) override;
+  Result<size_t> Writev(std::span<const io::ConstBuffer> bufs);
+  Result<size_t> Readv(std::span<const io::MutableBuffer> bufs);
+  Result<size_t> Available() const;
+  Result<size_t> SendFile(int fd, int64_t offset, int64_t count);
+  Result<size_t> SpliceFrom(TcpConnImpl* src);
+  Result<size_t> WriteZeroCopy(const void* buf, int nbytes,
+                               std::function<void()> done);
+  Status WaitZeroCopy();
 
   void SetDeadline(int64_t t);
   void SetReadDeadline(int64_t t);
@@ -53,6 +67,8 @@ class TcpConnImpl
   Status CloseRead();
   Status CloseWrite();
   void Close();
+  Result<int> File();
+  bool ProbeIdle();
 
   int64_t TotalReadBytes() const {
     return total_read_bytes_;
@@ -0,0 +1,416 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "build/build_config.h"
+
+#include <string.h>
+
+#include <absl/log/log.h>
+#include <algorithm>
+#include <memory>
+
+#include "tin/net/sys_socket.h"
+#include "tin/error/error.h"
+#include "tin/net/netfd.h"
+#include "tin/net/sockaddr_storage.h"
+#include "tin/net/udp_conn_impl.h"  // internal: UdpConnImpl
+#include "tin/net/udp_conn.h"       // public: UdpConn (PIMPL)
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+namespace tin::net {
+
+namespace {
+
+// Messages handed to one recvmmsg/sendmmsg.
+const int kMaxBatch = 32;
+
+// Room for one UDP_GRO (int) or UDP_SEGMENT (uint16_t) control message.
+struct Control {
+  alignas(cmsghdr) char buf[CMSG_SPACE(sizeof(int))];
+};
+
+// The segment size the kernel reported for a GRO-coalesced receive.
+size_t GroSegmentSize(msghdr* msg) {
+  for (cmsghdr* c = CMSG_FIRSTHDR(msg); c != nullptr;
+       c = CMSG_NXTHDR(msg, c)) {
+    if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) {
+      int size = 0;
+      memcpy(&size, CMSG_DATA(c), sizeof(size));
+      return static_cast<size_t>(size);
+    }
+  }
+  return 0;
+}
+
+void SetGsoSegmentSize(msghdr* msg, Control* control, size_t size) {
+  msg->msg_control = control->buf;
+  msg->msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+  cmsghdr* c = CMSG_FIRSTHDR(msg);
+  c->cmsg_level = SOL_UDP;
+  c->cmsg_type = UDP_SEGMENT;
+  c->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  uint16_t segment = static_cast<uint16_t>(size);
+  memcpy(CMSG_DATA(c), &segment, sizeof(segment));
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// UdpConnImpl — full implementation (internal).
+// ---------------------------------------------------------------------------
+
+UdpConnImpl::UdpConnImpl(std::unique_ptr<NetFD> netfd)
+  : netfd_(std::move(netfd)) {
+}
+
+UdpConnImpl::~UdpConnImpl() = default;
+
+Result<size_t> UdpConnImpl::ReadFrom(void* buf, int nbytes, IpEndpoint* addr) {
+  SockaddrStorage from;
+  iovec iov = {buf, static_cast<size_t>(nbytes)};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = from.addr;
+  msg.msg_namelen = from.addr_len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  int n = 0;
+  int err = netfd_->ReadMsg(&msg, &n);
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  if (addr != nullptr && !addr->FromSockAddr(from.addr, msg.msg_namelen)) {
+    *addr = IpEndpoint();
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(n));
+}
+
+Result<size_t> UdpConnImpl::WriteTo(const void* buf, int nbytes,
+                                    const IpEndpoint& addr) {
+  SockaddrStorage to;
+  if (!addr.ToSockAddr(to.addr, &to.addr_len)) {
+    return Result<size_t>::Err(TIN_EINVAL);
+  }
+  iovec iov = {const_cast<void*>(buf), static_cast<size_t>(nbytes)};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = to.addr;
+  msg.msg_namelen = to.addr_len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  int n = 0;
+  int err = netfd_->WriteMsg(&msg, &n);
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(n));
+}
+
+Result<size_t> UdpConnImpl::Read(void* buf, int nbytes) {
+  int nread = 0;
+  int err = netfd_->Read(buf, nbytes, &nread);
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(nread));
+}
+
+Result<size_t> UdpConnImpl::Write(const void* buf, int nbytes) {
+  int nwritten = 0;
+  int err = netfd_->Write(buf, nbytes, &nwritten);
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(nwritten));
+}
+
+Result<int> UdpConnImpl::ReadBatch(std::span<Datagram> msgs) {
+  int count = static_cast<int>(std::min<size_t>(msgs.size(), kMaxBatch));
+  if (count == 0) {
+    return Result<int>::Ok(0);
+  }
+  MultiMsg mm[kMaxBatch];
+  iovec iov[kMaxBatch];
+  SockaddrStorage from[kMaxBatch];
+  Control control[kMaxBatch];
+  memset(mm, 0, sizeof(mm[0]) * count);
+  for (int i = 0; i < count; i++) {
+    iov[i].iov_base = msgs[i].data;
+    iov[i].iov_len = msgs[i].size;
+    msghdr* hdr = &mm[i].msg_hdr;
+    hdr->msg_name = from[i].addr;
+    hdr->msg_namelen = from[i].addr_len;
+    hdr->msg_iov = &iov[i];
+    hdr->msg_iovlen = 1;
+    hdr->msg_control = control[i].buf;
+    hdr->msg_controllen = sizeof(control[i].buf);
+  }
+  int n = 0;
+  int err = netfd_->ReadMsgs(mm, count, &n);
+  if (n == 0) {
+    return Result<int>::Err(TinTranslateSysError(err));
+  }
+  for (int i = 0; i < n; i++) {
+    msghdr* hdr = &mm[i].msg_hdr;
+    msgs[i].len = mm[i].msg_len;
+    msgs[i].segment_size = GroSegmentSize(hdr);
+    if (!msgs[i].addr.FromSockAddr(from[i].addr, hdr->msg_namelen)) {
+      msgs[i].addr = IpEndpoint();
+    }
+  }
+  return Result<int>::Ok(n);
+}
+
+Result<int> UdpConnImpl::WriteBatch(std::span<const Datagram> msgs) {
+  int total = static_cast<int>(msgs.size());
+  int sent = 0;
+  int err = 0;
+  while (sent < total && err == 0) {
+    int count = std::min(total - sent, kMaxBatch);
+    MultiMsg mm[kMaxBatch];
+    iovec iov[kMaxBatch];
+    SockaddrStorage to[kMaxBatch];
+    Control control[kMaxBatch];
+    memset(mm, 0, sizeof(mm[0]) * count);
+    for (int i = 0; i < count; i++) {
+      const Datagram& d = msgs[sent + i];
+      iov[i].iov_base = d.data;
+      iov[i].iov_len = d.size;
+      msghdr* hdr = &mm[i].msg_hdr;
+      hdr->msg_iov = &iov[i];
+      hdr->msg_iovlen = 1;
+      if (!d.addr.address().empty()) {
+        if (!d.addr.ToSockAddr(to[i].addr, &to[i].addr_len)) {
+          err = EINVAL;
+          count = i;
+          break;
+        }
+        hdr->msg_name = to[i].addr;
+        hdr->msg_namelen = to[i].addr_len;
+      }
+      if (d.segment_size != 0) {
+        SetGsoSegmentSize(hdr, &control[i], d.segment_size);
+      }
+    }
+    if (count == 0) {
+      break;
+    }
+    int n = 0;
+    int werr = netfd_->WriteMsgs(mm, count, &n);
+    sent += n;
+    if (werr != 0) {
+      err = werr;
+    }
+  }
+  if (sent == 0 && err != 0) {
+    return Result<int>::Err(TinTranslateSysError(err));
+  }
+  return Result<int>::Ok(sent);
+}
+
+Status UdpConnImpl::EnableGso(int segment_size) {
+#if defined(OS_LINUX)
+  int err = netfd_->SetSockOpt(SOL_UDP, UDP_SEGMENT, &segment_size,
+                               sizeof(segment_size));
+  return Status::FromErrno(TinTranslateSysError(err));
+#else
+  (void)segment_size;
+  return Status::FromErrno(TIN_ENOSYS);
+#endif
+}
+
+Status UdpConnImpl::EnableGro(bool enable) {
+#if defined(OS_LINUX)
+  int on = enable ? 1 : 0;
+  int err = netfd_->SetSockOpt(SOL_UDP, UDP_GRO, &on, sizeof(on));
+  return Status::FromErrno(TinTranslateSysError(err));
+#else
+  (void)enable;
+  return Status::FromErrno(TIN_ENOSYS);
+#endif
+}
+
+void UdpConnImpl::SetDeadline(int64_t t) {
+  netfd_->SetDeadline(t);
+}
+
+void UdpConnImpl::SetReadDeadline(int64_t t) {
+  netfd_->SetReadDeadline(t);
+}
+
+void UdpConnImpl::SetWriteDeadline(int64_t t) {
+  netfd_->SetWriteDeadline(t);
+}
+
+void UdpConnImpl::SetReadBuffer(int bytes) {
+  (void)netfd_->SetSockOpt(SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+}
+
+void UdpConnImpl::SetWriteBuffer(int bytes) {
+  (void)netfd_->SetSockOpt(SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+}
+
+Result<IpEndpoint> UdpConnImpl::LocalAddr() const {
+  SockaddrStorage storage;
+  if (getsockname(netfd_->IntFd(), storage.addr, &storage.addr_len) != 0) {
+    return Result<IpEndpoint>::Err(TinTranslateSysError(errno));
+  }
+  IpEndpoint local;
+  if (!local.FromSockAddr(storage.addr, storage.addr_len)) {
+    return Result<IpEndpoint>::Err(TIN_EINVAL);
+  }
+  return Result<IpEndpoint>::Ok(local);
+}
+
+void UdpConnImpl::Close() {
+  netfd_->Close();
+}
+
+// ---------------------------------------------------------------------------
+// UdpConn — PIMPL forwarding methods (public API).
+// ---------------------------------------------------------------------------
+
+Result<size_t> UdpConn::ReadFrom(void* buf, int nbytes, IpEndpoint* addr) {
+  return impl_ ? impl_->ReadFrom(buf, nbytes, addr)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> UdpConn::WriteTo(const void* buf, int nbytes,
+                                const IpEndpoint& addr) {
+  return impl_ ? impl_->WriteTo(buf, nbytes, addr)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> UdpConn::Read(void* buf, int nbytes) {
+  return impl_ ? impl_->Read(buf, nbytes)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> UdpConn::Write(const void* buf, int nbytes) {
+  return impl_ ? impl_->Write(buf, nbytes)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<int> UdpConn::ReadBatch(std::span<Datagram> msgs) {
+  return impl_ ? impl_->ReadBatch(msgs) : Result<int>::Err(TIN_EBADF);
+}
+
+Result<int> UdpConn::WriteBatch(std::span<const Datagram> msgs) {
+  return impl_ ? impl_->WriteBatch(msgs) : Result<int>::Err(TIN_EBADF);
+}
+
+Status UdpConn::EnableGso(int segment_size) {
+  return impl_ ? impl_->EnableGso(segment_size)
+               : Status::FromErrno(TIN_EBADF);
+}
+
+Status UdpConn::EnableGro(bool enable) {
+  return impl_ ? impl_->EnableGro(enable) : Status::FromErrno(TIN_EBADF);
+}
+
+void UdpConn::SetDeadline(int64_t t) {
+  if (impl_) impl_->SetDeadline(t);
+}
+
+void UdpConn::SetReadDeadline(int64_t t) {
+  if (impl_) impl_->SetReadDeadline(t);
+}
+
+void UdpConn::SetWriteDeadline(int64_t t) {
+  if (impl_) impl_->SetWriteDeadline(t);
+}
+
+void UdpConn::SetReadBuffer(int bytes) {
+  if (impl_) impl_->SetReadBuffer(bytes);
+}
+
+void UdpConn::SetWriteBuffer(int bytes) {
+  if (impl_) impl_->SetWriteBuffer(bytes);
+}
+
+Result<IpEndpoint> UdpConn::LocalAddr() const {
+  return impl_ ? impl_->LocalAddr() : Result<IpEndpoint>::Err(TIN_EBADF);
+}
+
+void UdpConn::Close() {
+  if (impl_) impl_->Close();
+}
+
+UdpConn MakeUdpConn(std::unique_ptr<NetFD> netfd) {
+  return UdpConn(std::make_shared<UdpConnImpl>(std::move(netfd)));
+}
+
+// ---------------------------------------------------------------------------
+// ListenUdp / DialUdp.
+// ---------------------------------------------------------------------------
+
+Result<UdpConn> ListenUdp(const IpAddress& address, uint16_t port) {
+  int err = 0;
+  AddressFamily family =
+    address.IsIPv4() ? ADDRESS_FAMILY_IPV4 : ADDRESS_FAMILY_IPV6;
+  NetFD* netfd = NewFD(family, SOCK_DGRAM, &err);
+  if (netfd != nullptr) {
+    err = netfd->Init();
+    if (err == 0) {
+      err = netfd->Bind(IpEndpoint(address, port));
+      if (err != 0) {
+        LOG(INFO) << "Bind failed: " << TinErrorName(TinTranslateSysError(err));
+      }
+    }
+    if (err != 0) {
+      delete netfd;
+      netfd = nullptr;
+    }
+  }
+  if (netfd == nullptr) {
+    return Result<UdpConn>::Err(TinTranslateSysError(err));
+  }
+  return Result<UdpConn>::Ok(MakeUdpConn(std::unique_ptr<NetFD>(netfd)));
+}
+
+Result<UdpConn> ListenUdp(const absl::string_view& address, uint16_t port) {
+  IpAddress ip_address;
+  if (!ip_address.AssignFromIPLiteral(address)) {
+    return Result<UdpConn>::Err(TIN_EINVAL);
+  }
+  return ListenUdp(ip_address, port);
+}
+
+Result<UdpConn> DialUdp(const IpAddress& address, uint16_t port) {
+  int err = 0;
+  AddressFamily family =
+    address.IsIPv4() ? ADDRESS_FAMILY_IPV4 : ADDRESS_FAMILY_IPV6;
+  NetFD* netfd = NewFD(family, SOCK_DGRAM, &err);
+  if (netfd != nullptr) {
+    IpEndpoint endpoint(address, port);
+    err = netfd->Dial(nullptr, &endpoint, 0);
+    if (err != 0) {
+      delete netfd;
+      netfd = nullptr;
+    }
+  }
+  if (netfd == nullptr) {
+    return Result<UdpConn>::Err(TinTranslateSysError(err));
+  }
+  return Result<UdpConn>::Ok(MakeUdpConn(std::unique_ptr<NetFD>(netfd)));
+}
+
+Result<UdpConn> DialUdp(const absl::string_view& address, uint16_t port) {
+  IpAddress ip_address;
+  if (!ip_address.AssignFromIPLiteral(address)) {
+    return Result<UdpConn>::Err(TIN_EINVAL);
+  }
+  return DialUdp(ip_address, port);
+}
+
+}  // namespace tin::net
@@ -0,0 +1,60 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Internal implementation header for UdpConnImpl.
+// The public UdpConn class is defined in include/tin/net/udp_conn.h.
+// This file is NOT part of the public API.
+
+#ifndef TIN_NET_UDP_CONN_IMPL_H_
+#define TIN_NET_UDP_CONN_IMPL_H_
+#include <memory>
+#include <span>
+
+#include "tin/net/sys_socket.h"
+#include "tin/net/udp_conn.h"
+#include "tin/result.h"
+
+namespace tin::net {
+
+class NetFD;
+
+// Factory: creates a UdpConn from a NetFD. Defined in udp_conn.cc.
+UdpConn MakeUdpConn(std::unique_ptr<NetFD> netfd);
+
+class UdpConnImpl {
+ public:
+  explicit UdpConnImpl(std::unique_ptr<NetFD> netfd);
+  ~UdpConnImpl();
+
+  UdpConnImpl(const UdpConnImpl&) = delete;
+  UdpConnImpl& operator=(const UdpConnImpl&) = delete;
+
+  Result<size_t> ReadFrom(void* buf, int nbytes, IpEndpoint* addr);
+  Result<size_t> WriteTo(const void* buf, int nbytes, const IpEndpoint& addr);
+  Result<size_t> Read(void* buf, int nbytes);
+  Result<size_t> Write(const void* buf, int nbytes);
+
+  Result<int> ReadBatch(std::span<Datagram> msgs);
+  Result<int> WriteBatch(std::span<const Datagram> msgs);
+
+  Status EnableGso(int segment_size);
+  Status EnableGro(bool enable);
+
+  void SetDeadline(int64_t t);
+  void SetReadDeadline(int64_t t);
+  void SetWriteDeadline(int64_t t);
+
+  void SetReadBuffer(int bytes);
+  void SetWriteBuffer(int bytes);
+
+  Result<IpEndpoint> LocalAddr() const;
+
+  void Close();
+
+ private:
+  std::unique_ptr<NetFD> netfd_;
+};
+
+}  // namespace tin::net
+#endif  // TIN_NET_UDP_CONN_IMPL_H_
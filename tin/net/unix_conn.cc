@@ -0,0 +1,496 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "build/build_config.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <absl/log/log.h>
+#include <memory>
+#include <string>
+
+#include "tin/net/sys_socket.h"
+#include "tin/error/error.h"
+#include "tin/net/netfd.h"
+#include "tin/net/sockaddr_storage.h"
+#include "tin/net/listener_impl.h"  // internal: TcpListenerImpl
+#include "tin/net/tcp_conn_impl.h"  // internal: MakeTcpConn
+#include "tin/net/unix_conn_impl.h"  // internal: UnixConnImpl
+#include "tin/net/unix_conn.h"       // public: UnixConn (PIMPL)
+
+namespace tin::net {
+
+namespace {
+
+#if defined(MSG_CMSG_CLOEXEC)
+const int kRecvFdsFlags = MSG_CMSG_CLOEXEC;
+#else
+const int kRecvFdsFlags = 0;
+#endif
+
+int SockType(UnixType type) {
+  return type == UnixType::kSeqPacket ? SOCK_SEQPACKET : SOCK_STREAM;
+}
+
+// FileTcpConn/FileTcpListener adopt TCP sockets only. Returns 0 or an
+// errno, closing fd on failure since the callers own it either way.
+int CheckTcpFile(int fd) {
+  int domain = 0;
+  int type = 0;
+  socklen_t len = sizeof(type);
+  int err = getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == -1 ? errno
+                                                                   : 0;
+#if defined(SO_DOMAIN)
+  if (err == 0) {
+    len = sizeof(domain);
+    err = getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &len) == -1 ? errno
+                                                                     : 0;
+  }
+#else
+  SockaddrStorage storage;
+  if (err == 0) {
+    err = getsockname(fd, storage.addr, &storage.addr_len) == -1 ? errno : 0;
+    domain = storage.addr->sa_family;
+  }
+#endif
+  if (err == 0 && domain != AF_INET && domain != AF_INET6) {
+    err = EAFNOSUPPORT;
+  }
+  if (err == 0 && type != SOCK_STREAM) {
+    err = EPROTOTYPE;
+  }
+#if defined(SO_PROTOCOL)
+  // SCTP sockets are SOCK_STREAM as well.
+  int protocol = 0;
+  if (err == 0) {
+    len = sizeof(protocol);
+    err = getsockopt(fd, SOL_SOCKET, SO_PROTOCOL, &protocol, &len) == -1
+              ? errno : 0;
+  }
+  if (err == 0 && protocol != IPPROTO_TCP) {
+    err = EPROTOTYPE;
+  }
+#endif
+  if (err != 0) {
+    close(fd);
+  }
+  return err;
+}
+
+// Fills *storage with the sockaddr_un for path; "@name" is abstract.
+int UnixSockaddr(const absl::string_view& path, SockaddrStorage* storage) {
+  sockaddr_un* sun = reinterpret_cast<sockaddr_un*>(storage->addr);
+  if (path.empty() || path.size() >= sizeof(sun->sun_path)) {
+    return path.empty() ? EINVAL : ENAMETOOLONG;
+  }
+  memset(sun, 0, sizeof(*sun));
+  sun->sun_family = AF_UNIX;
+  memcpy(sun->sun_path, path.data(), path.size());
+  size_t len = offsetof(sockaddr_un, sun_path) + path.size();
+  if (path[0] == '@') {
+#if defined(OS_LINUX)
+    sun->sun_path[0] = '\0';
+#else
+    return EINVAL;
+#endif
+  } else {
+    len++;  // the terminating NUL
+  }
+  storage->addr_len = static_cast<socklen_t>(len);
+  return 0;
+}
+
+// Closes descriptors received with a truncated control message.
+void CloseFds(std::vector<int>* fds, size_t from) {
+  for (size_t i = from; i < fds->size(); i++) {
+    close((*fds)[i]);
+  }
+  fds->resize(from);
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// UnixConnImpl — full implementation (internal).
+// ---------------------------------------------------------------------------
+
+UnixConnImpl::UnixConnImpl(std::unique_ptr<NetFD> netfd)
+  : netfd_(std::move(netfd)) {
+}
+
+UnixConnImpl::~UnixConnImpl() = default;
+
+Result<size_t> UnixConnImpl::Read(void* buf, int nbytes) {
+  LOG_IF(FATAL, nbytes == 0) << "Read on zero buffer.";
+  int nread = 0;
+  int err = netfd_->Read(buf, nbytes, &nread);
+  if (nread > 0) {
+    return Result<size_t>::Ok(static_cast<size_t>(nread));
+  }
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(0);
+}
+
+Result<size_t> UnixConnImpl::Write(const void* buf, int nbytes) {
+  LOG_IF(FATAL, nbytes == 0) << "Write on zero buffer.";
+  int nwritten = 0;
+  int err = netfd_->Write(buf, nbytes, &nwritten);
+  if (nwritten > 0) {
+    return Result<size_t>::Ok(static_cast<size_t>(nwritten));
+  }
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(0);
+}
+
+Result<size_t> UnixConnImpl::Writev(std::span<const io::ConstBuffer> bufs) {
+  size_t nwritten = 0;
+  int err = netfd_->Writev(bufs.data(), static_cast<int>(bufs.size()),
+                           &nwritten);
+  if (nwritten > 0) {
+    return Result<size_t>::Ok(nwritten);
+  }
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  return Result<size_t>::Ok(0);
+}
+
+Result<size_t> UnixConnImpl::SendFds(const void* buf, int nbytes,
+                                     std::span<const int> fds) {
+  if (nbytes <= 0 || fds.size() > UnixConn::kMaxFds) {
+    return Result<size_t>::Err(TIN_EINVAL);
+  }
+  if (fds.empty()) {
+    return Write(buf, nbytes);
+  }
+  alignas(cmsghdr) char control[CMSG_SPACE(UnixConn::kMaxFds * sizeof(int))];
+  size_t fds_len = fds.size() * sizeof(int);
+  iovec iov = {const_cast<void*>(buf), static_cast<size_t>(nbytes)};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = CMSG_SPACE(fds_len);
+  memset(control, 0, msg.msg_controllen);
+  cmsghdr* c = CMSG_FIRSTHDR(&msg);
+  c->cmsg_level = SOL_SOCKET;
+  c->cmsg_type = SCM_RIGHTS;
+  c->cmsg_len = CMSG_LEN(fds_len);
+  memcpy(CMSG_DATA(c), fds.data(), fds_len);
+  int n = 0;
+  int err = netfd_->WriteMsg(&msg, &n);
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  // The descriptors went with the first byte; a stream socket may have
+  // taken only part of the data.
+  while (n < nbytes) {
+    int nn = 0;
+    err = netfd_->Write(static_cast<const char*>(buf) + n, nbytes - n, &nn);
+    n += nn;
+    if (err != 0) {
+      return Result<size_t>::Err(TinTranslateSysError(err));
+    }
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(n));
+}
+
+Result<size_t> UnixConnImpl::RecvFds(void* buf, int nbytes,
+                                     std::vector<int>* fds) {
+  LOG_IF(FATAL, nbytes == 0) << "RecvFds on zero buffer.";
+  alignas(cmsghdr) char control[CMSG_SPACE(UnixConn::kMaxFds * sizeof(int))];
+  iovec iov = {buf, static_cast<size_t>(nbytes)};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  int n = 0;
+  int err = netfd_->ReadMsg(&msg, &n, kRecvFdsFlags);
+  if (err != 0) {
+    return Result<size_t>::Err(TinTranslateSysError(err));
+  }
+  size_t first = fds->size();
+  for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr;
+       c = CMSG_NXTHDR(&msg, c)) {
+    if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    size_t count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    const unsigned char* data = CMSG_DATA(c);
+    for (size_t i = 0; i < count; i++) {
+      int fd;
+      memcpy(&fd, data + i * sizeof(int), sizeof(fd));
+      if (kRecvFdsFlags == 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+      }
+      fds->push_back(fd);
+    }
+  }
+  if ((msg.msg_flags & MSG_CTRUNC) != 0) {
+    // The sender attached more than kMaxFds; the rest were dropped.
+    CloseFds(fds, first);
+    return Result<size_t>::Err(TIN_EMSGSIZE);
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(n));
+}
+
+void UnixConnImpl::SetDeadline(int64_t t) {
+  netfd_->SetDeadline(t);
+}
+
+void UnixConnImpl::SetReadDeadline(int64_t t) {
+  netfd_->SetReadDeadline(t);
+}
+
+void UnixConnImpl::SetWriteDeadline(int64_t t) {
+  netfd_->SetWriteDeadline(t);
+}
+
+void UnixConnImpl::SetReadBuffer(int bytes) {
+  (void)netfd_->SetSockOpt(SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+}
+
+void UnixConnImpl::SetWriteBuffer(int bytes) {
+  (void)netfd_->SetSockOpt(SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+}
+
+Status UnixConnImpl::CloseRead() {
+  int err = netfd_->CloseRead();
+  return Status::FromErrno(TinTranslateSysError(err));
+}
+
+Status UnixConnImpl::CloseWrite() {
+  int err = netfd_->CloseWrite();
+  return Status::FromErrno(TinTranslateSysError(err));
+}
+
+void UnixConnImpl::Close() {
+  netfd_->Close();
+}
+
+// ---------------------------------------------------------------------------
+// UnixListenerImpl
+// ---------------------------------------------------------------------------
+
+UnixListenerImpl::UnixListenerImpl(std::unique_ptr<NetFD> netfd,
+                                   std::string path)
+  : netfd_(std::move(netfd))
+  , path_(std::move(path)) {
+}
+
+UnixListenerImpl::~UnixListenerImpl() = default;
+
+Status UnixListenerImpl::SetDeadline(int64_t t) {
+  int err = netfd_->SetDeadline(t);
+  return Status::FromErrno(TinTranslateSysError(err));
+}
+
+Result<UnixConn> UnixListenerImpl::Accept() {
+  NetFD* newfd = nullptr;
+  int err = netfd_->Accept(&newfd);
+  if (err != 0) {
+    delete newfd;
+    return Result<UnixConn>::Err(TinTranslateSysError(err));
+  }
+  return Result<UnixConn>::Ok(MakeUnixConn(std::unique_ptr<NetFD>(newfd)));
+}
+
+Status UnixListenerImpl::Close() {
+  int err = netfd_->Close();
+  // Only the first Close succeeds, so the file is removed once.
+  if (err == 0 && !path_.empty()) {
+    unlink(path_.c_str());
+  }
+  return Status::FromErrno(TinTranslateSysError(err));
+}
+
+Result<int> UnixListenerImpl::File() {
+  int fd = -1;
+  int err = netfd_->Dup(&fd);
+  if (err != 0) {
+    return Result<int>::Err(TinTranslateSysError(err));
+  }
+  return Result<int>::Ok(fd);
+}
+
+// ---------------------------------------------------------------------------
+// UnixConn / UnixListener — PIMPL forwarding methods (public API).
+// ---------------------------------------------------------------------------
+
+Result<size_t> UnixConn::Read(void* buf, int nbytes) {
+  return impl_ ? impl_->Read(buf, nbytes)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> UnixConn::Write(const void* buf, int nbytes) {
+  return impl_ ? impl_->Write(buf, nbytes)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> UnixConn::Writev(std::span<const io::ConstBuffer> bufs) {
+  return impl_ ? impl_->Writev(bufs)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> UnixConn::SendFds(const void* buf, int nbytes,
+                                 std::span<const int> fds) {
+  return impl_ ? impl_->SendFds(buf, nbytes, fds)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+Result<size_t> UnixConn::RecvFds(void* buf, int nbytes,
+                                 std::vector<int>* fds) {
+  return impl_ ? impl_->RecvFds(buf, nbytes, fds)
+               : Result<size_t>::Err(TIN_EBADF);
+}
+
+void UnixConn::SetDeadline(int64_t t) {
+  if (impl_) impl_->SetDeadline(t);
+}
+
+void UnixConn::SetReadDeadline(int64_t t) {
+  if (impl_) impl_->SetReadDeadline(t);
+}
+
+void UnixConn::SetWriteDeadline(int64_t t) {
+  if (impl_) impl_->SetWriteDeadline(t);
+}
+
+void UnixConn::SetReadBuffer(int bytes) {
+  if (impl_) impl_->SetReadBuffer(bytes);
+}
+
+void UnixConn::SetWriteBuffer(int bytes) {
+  if (impl_) impl_->SetWriteBuffer(bytes);
+}
+
+Status UnixConn::CloseRead() {
+  return impl_ ? impl_->CloseRead() : Status::FromErrno(TIN_EBADF);
+}
+
+Status UnixConn::CloseWrite() {
+  return impl_ ? impl_->CloseWrite() : Status::FromErrno(TIN_EBADF);
+}
+
+void UnixConn::Close() {
+  if (impl_) impl_->Close();
+}
+
+UnixConn MakeUnixConn(std::unique_ptr<NetFD> netfd) {
+  return UnixConn(std::make_shared<UnixConnImpl>(std::move(netfd)));
+}
+
+Status UnixListener::SetDeadline(int64_t t) {
+  return impl_ ? impl_->SetDeadline(t) : Status::FromErrno(TIN_EBADF);
+}
+
+Result<UnixConn> UnixListener::Accept() {
+  return impl_ ? impl_->Accept() : Result<UnixConn>::Err(TIN_EBADF);
+}
+
+Status UnixListener::Close() {
+  return impl_ ? impl_->Close() : Status::FromErrno(TIN_EBADF);
+}
+
+Result<int> UnixListener::File() {
+  return impl_ ? impl_->File() : Result<int>::Err(TIN_EBADF);
+}
+
+// ---------------------------------------------------------------------------
+// ListenUnix / DialUnix / FileTcpConn / FileTcpListener.
+// ---------------------------------------------------------------------------
+
+Result<UnixListener> ListenUnix(const absl::string_view& path, UnixType type,
+                                int backlog) {
+  SockaddrStorage storage;
+  int err = UnixSockaddr(path, &storage);
+  if (err != 0) {
+    return Result<UnixListener>::Err(TinTranslateSysError(err));
+  }
+  NetFD* netfd = NewFD(ADDRESS_FAMILY_UNIX, SockType(type), &err);
+  if (netfd != nullptr) {
+    err = netfd->Init();
+    if (err == 0) {
+      err = netfd->BindAddr(storage);
+      if (err != 0) {
+        LOG(INFO) << "Bind failed: " << TinErrorName(TinTranslateSysError(err));
+      }
+    }
+    if (err == 0) {
+      err = netfd->Listen(backlog);
+    }
+    if (err != 0) {
+      delete netfd;
+      netfd = nullptr;
+    }
+  }
+  if (netfd == nullptr) {
+    return Result<UnixListener>::Err(TinTranslateSysError(err));
+  }
+  std::string unlink_path;
+  if (path[0] != '@') {
+    unlink_path.assign(path.data(), path.size());
+  }
+  return Result<UnixListener>::Ok(UnixListener(
+      std::make_shared<UnixListenerImpl>(std::unique_ptr<NetFD>(netfd),
+                                         std::move(unlink_path))));
+}
+
+Result<UnixConn> DialUnix(const absl::string_view& path, UnixType type) {
+  SockaddrStorage storage;
+  int err = UnixSockaddr(path, &storage);
+  if (err != 0) {
+    return Result<UnixConn>::Err(TinTranslateSysError(err));
+  }
+  NetFD* netfd = NewFD(ADDRESS_FAMILY_UNIX, SockType(type), &err);
+  if (netfd != nullptr) {
+    err = netfd->DialAddr(&storage, 0);
+    if (err != 0) {
+      delete netfd;
+      netfd = nullptr;
+    }
+  }
+  if (netfd == nullptr) {
+    return Result<UnixConn>::Err(TinTranslateSysError(err));
+  }
+  return Result<UnixConn>::Ok(MakeUnixConn(std::unique_ptr<NetFD>(netfd)));
+}
+
+Result<TcpConn> FileTcpConn(int fd) {
+  int err = CheckTcpFile(fd);
+  if (err != 0) {
+    return Result<TcpConn>::Err(TinTranslateSysError(err));
+  }
+  NetFD* netfd = NewFDFromFile(fd, &err);
+  if (netfd == nullptr) {
+    return Result<TcpConn>::Err(TinTranslateSysError(err));
+  }
+  return Result<TcpConn>::Ok(MakeTcpConn(std::unique_ptr<NetFD>(netfd)));
+}
+
+Result<TcpListener> FileTcpListener(int fd) {
+  int err = CheckTcpFile(fd);
+  if (err != 0) {
+    return Result<TcpListener>::Err(TinTranslateSysError(err));
+  }
+  NetFD* netfd = NewFDFromFile(fd, &err);
+  if (netfd == nullptr) {
+    return Result<TcpListener>::Err(TinTranslateSysError(err));
+  }
+  return Result<TcpListener>::Ok(TcpListener(
+      std::make_shared<TcpListenerImpl>(std::unique_ptr<NetFD>(netfd), 0)));
+}
+
+}  // namespace tin::net
@@ -0,0 +1,76 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Internal implementation header for UnixConnImpl/UnixListenerImpl.
+// The public classes are defined in include/tin/net/unix_conn.h.
+// This file is NOT part of the public API.
+
+#ifndef TIN_NET_UNIX_CONN_IMPL_H_
+#define TIN_NET_UNIX_CONN_IMPL_H_
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "tin/net/unix_conn.h"
+#include "tin/result.h"
+
+namespace tin::net {
+
+class NetFD;
+
+// Factory: creates a UnixConn from a NetFD. Defined in unix_conn.cc.
+UnixConn MakeUnixConn(std::unique_ptr<NetFD> netfd);
+
+class UnixConnImpl {
+ public:
+  explicit UnixConnImpl(std::unique_ptr<NetFD> netfd);
+  ~UnixConnImpl();
+
+  UnixConnImpl(const UnixConnImpl&) = delete;
+  UnixConnImpl& operator=(const UnixConnImpl&) = delete;
+
+  Result<size_t> Read(void* buf, int nbytes);
+  Result<size_t> Write(const void* buf, int nbytes);
+  Result<size_t> Writev(std::span<const io::ConstBuffer> bufs);
+  Result<size_t> SendFds(const void* buf, int nbytes,
+                         std::span<const int> fds);
+  Result<size_t> RecvFds(void* buf, int nbytes, std::vector<int>* fds);
+
+  void SetDeadline(int64_t t);
+  void SetReadDeadline(int64_t t);
+  void SetWriteDeadline(int64_t t);
+
+  void SetReadBuffer(int bytes);
+  void SetWriteBuffer(int bytes);
+
+  Status CloseRead();
+  Status CloseWrite();
+  void Close();
+
+ private:
+  std::unique_ptr<NetFD> netfd_;
+};
+
+class UnixListenerImpl {
+ public:
+  // path is unlinked on Close; empty for abstract sockets.
+  UnixListenerImpl(std::unique_ptr<NetFD> netfd, std::string path);
+  ~UnixListenerImpl();
+
+  UnixListenerImpl(const UnixListenerImpl&) = delete;
+  UnixListenerImpl& operator=(const UnixListenerImpl&) = delete;
+
+  Status SetDeadline(int64_t t);
+  Result<UnixConn> Accept();
+  Status Close();
+  Result<int> File();
+
+ private:
+  std::unique_ptr<NetFD> netfd_;
+  std::string path_;
+};
+
+}  // namespace tin::net
+#endif  // TIN_NET_UNIX_CONN_IMPL_H_
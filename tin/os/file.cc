@@ -0,0 +1,291 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "build/build_config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "tin/error/error.h"
+#include "tin/os/file.h"
+#include "tin/runtime.h"
+#if defined(OS_LINUX)
+#include "tin/runtime/net/netpoll_uring.h"
+#include "tin/runtime/net/poll_descriptor.h"
+#include "tin/runtime/net/pollops.h"
+#endif
+
+namespace tin::os {
+
+namespace {
+
+// Offset for the transfers that use and advance the file offset.
+const int64_t kFileOffset = -1;
+
+#if defined(OS_LINUX)
+// Issues one io_uring request and parks until it completes. The private
+// descriptor only carries the wakeup; it is never registered with the
+// poller, and with no deadline or close to interrupt the wait, the buffer
+// stays the kernel's until the completion.
+template <typename Submit>
+int UringFileOp(Submit submit) {
+  runtime::PollDescriptor* pd = runtime::NewPollDescriptor();
+  runtime::UringOp op;
+  submit(&op, pd);
+  while (!runtime::UringOpDone(&op)) {
+    runtime::pollops::WaitCanceled(pd, 'r');
+  }
+  pd->Release();
+  return op.res;
+}
+
+bool UseUring() {
+  return runtime::UringNetPollActive();
+}
+#else
+bool UseUring() {
+  return false;
+}
+#endif
+
+int ConvertFlags(int flags) {
+  int oflags = O_CLOEXEC;
+  if ((flags & kReadWrite) == kReadWrite) {
+    oflags |= O_RDWR;
+  } else if ((flags & kWrite) != 0) {
+    oflags |= O_WRONLY;
+  } else {
+    oflags |= O_RDONLY;
+  }
+  if ((flags & kCreate) != 0) {
+    oflags |= O_CREAT;
+  }
+  if ((flags & kTruncate) != 0) {
+    oflags |= O_TRUNC;
+  }
+  if ((flags & kAppend) != 0) {
+    oflags |= O_APPEND;
+  }
+  if ((flags & kExclusive) != 0) {
+    oflags |= O_EXCL;
+  }
+  return oflags;
+}
+
+}  // namespace
+
+class FileImpl {
+ public:
+  explicit FileImpl(int fd) : fd_(fd) {}
+  ~FileImpl() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  FileImpl(const FileImpl&) = delete;
+  FileImpl& operator=(const FileImpl&) = delete;
+
+  // Returns the bytes transferred, or -errno.
+  int64_t ReadOnce(void* buf, int nbytes, int64_t offset);
+  int64_t WriteOnce(const void* buf, int nbytes, int64_t offset);
+
+  Result<size_t> Read(void* buf, int nbytes, int64_t offset);
+  Result<size_t> Write(const void* buf, int nbytes, int64_t offset);
+  Status Fsync();
+  Result<int64_t> Size();
+  Status Close();
+
+  int Fd() const { return fd_; }
+
+ private:
+  int fd_;
+};
+
+int64_t FileImpl::ReadOnce(void* buf, int nbytes, int64_t offset) {
+#if defined(OS_LINUX)
+  if (UseUring()) {
+    return UringFileOp([&](runtime::UringOp* op,
+                           runtime::PollDescriptor* pd) {
+      runtime::UringSubmitRead(op, pd, fd_, buf, nbytes, offset);
+    });
+  }
+#endif
+  return Blocking([&]() -> int64_t {
+    ssize_t n = offset == kFileOffset ? ::read(fd_, buf, nbytes)
+                                      : ::pread(fd_, buf, nbytes, offset);
+    return n < 0 ? -errno : n;
+  });
+}
+
+int64_t FileImpl::WriteOnce(const void* buf, int nbytes, int64_t offset) {
+#if defined(OS_LINUX)
+  if (UseUring()) {
+    return UringFileOp([&](runtime::UringOp* op,
+                           runtime::PollDescriptor* pd) {
+      runtime::UringSubmitWrite(op, pd, fd_, buf, nbytes, offset);
+    });
+  }
+#endif
+  return Blocking([&]() -> int64_t {
+    ssize_t n = offset == kFileOffset ? ::write(fd_, buf, nbytes)
+                                      : ::pwrite(fd_, buf, nbytes, offset);
+    return n < 0 ? -errno : n;
+  });
+}
+
+Result<size_t> FileImpl::Read(void* buf, int nbytes, int64_t offset) {
+  if (nbytes <= 0) {
+    return Result<size_t>::Ok(0);
+  }
+  int64_t n = ReadOnce(buf, nbytes, offset);
+  while (n == -EINTR) {
+    n = ReadOnce(buf, nbytes, offset);
+  }
+  if (n < 0) {
+    return Result<size_t>::Err(TinTranslateSysError(static_cast<int>(-n)));
+  }
+  if (n == 0) {
+    return Result<size_t>::Err(TIN_EOF);
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(n));
+}
+
+Result<size_t> FileImpl::Write(const void* buf, int nbytes, int64_t offset) {
+  const char* p = static_cast<const char*>(buf);
+  int written = 0;
+  while (written < nbytes) {
+    int64_t n = WriteOnce(p + written, nbytes - written,
+                          offset == kFileOffset ? offset : offset + written);
+    if (n == -EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return Result<size_t>::Err(TinTranslateSysError(static_cast<int>(-n)));
+    }
+    if (n == 0) {
+      return Result<size_t>::Err(TIN_EIO);
+    }
+    written += static_cast<int>(n);
+  }
+  return Result<size_t>::Ok(static_cast<size_t>(written));
+}
+
+Status FileImpl::Fsync() {
+  int64_t res = 0;
+#if defined(OS_LINUX)
+  if (UseUring()) {
+    res = UringFileOp([&](runtime::UringOp* op,
+                          runtime::PollDescriptor* pd) {
+      runtime::UringSubmitFsync(op, pd, fd_);
+    });
+    return Status::FromErrno(
+        res < 0 ? TinTranslateSysError(static_cast<int>(-res)) : 0);
+  }
+#endif
+  res = Blocking([&]() -> int64_t {
+    return ::fsync(fd_) < 0 ? -errno : 0;
+  });
+  return Status::FromErrno(
+      res < 0 ? TinTranslateSysError(static_cast<int>(-res)) : 0);
+}
+
+Result<int64_t> FileImpl::Size() {
+  struct stat st;
+  if (::fstat(fd_, &st) < 0) {
+    return Result<int64_t>::Err(TinTranslateSysError(errno));
+  }
+  return Result<int64_t>::Ok(static_cast<int64_t>(st.st_size));
+}
+
+Status FileImpl::Close() {
+  if (fd_ < 0) {
+    return Status::FromErrno(TIN_EBADF);
+  }
+  int ret = ::close(fd_);
+  fd_ = -1;
+  return Status::FromErrno(ret < 0 ? TinTranslateSysError(errno) : 0);
+}
+
+Result<size_t> File::Read(void* buf, int nbytes) {
+  if (!impl_) {
+    return Result<size_t>::Err(TIN_EBADF);
+  }
+  return impl_->Read(buf, nbytes, kFileOffset);
+}
+
+Result<size_t> File::Write(const void* buf, int nbytes) {
+  if (!impl_) {
+    return Result<size_t>::Err(TIN_EBADF);
+  }
+  return impl_->Write(buf, nbytes, kFileOffset);
+}
+
+Result<size_t> File::ReadAt(void* buf, int nbytes, int64_t offset) {
+  if (!impl_) {
+    return Result<size_t>::Err(TIN_EBADF);
+  }
+  if (offset < 0) {
+    return Result<size_t>::Err(TIN_EINVAL);
+  }
+  return impl_->Read(buf, nbytes, offset);
+}
+
+Result<size_t> File::WriteAt(const void* buf, int nbytes, int64_t offset) {
+  if (!impl_) {
+    return Result<size_t>::Err(TIN_EBADF);
+  }
+  if (offset < 0) {
+    return Result<size_t>::Err(TIN_EINVAL);
+  }
+  return impl_->Write(buf, nbytes, offset);
+}
+
+Status File::Fsync() {
+  if (!impl_) {
+    return Status::FromErrno(TIN_EBADF);
+  }
+  return impl_->Fsync();
+}
+
+Result<int64_t> File::Size() {
+  if (!impl_) {
+    return Result<int64_t>::Err(TIN_EBADF);
+  }
+  return impl_->Size();
+}
+
+Status File::Close() {
+  if (!impl_) {
+    return Status::FromErrno(TIN_EBADF);
+  }
+  return impl_->Close();
+}
+
+int File::Fd() const {
+  return impl_ ? impl_->Fd() : -1;
+}
+
+Result<File> Open(const absl::string_view& path, int flags, int mode) {
+  std::string name(path.data(), path.size());
+  int oflags = ConvertFlags(flags);
+  int fd = Blocking([&]() -> int {
+    int ret = ::open(name.c_str(), oflags, mode);
+    return ret < 0 ? -errno : ret;
+  });
+  if (fd < 0) {
+    return Result<File>::Err(TinTranslateSysError(-fd));
+  }
+  return Result<File>::Ok(File(std::make_shared<FileImpl>(fd)));
+}
+
+Result<File> Create(const absl::string_view& path) {
+  return Open(path, kReadWrite | kCreate | kTruncate);
+}
+
+}  // namespace tin::os
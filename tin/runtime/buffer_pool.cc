@@ -0,0 +1,337 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/synchronization/mutex.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "tin/config/config.h"
+#include "tin/io/buffer_pool.h"
+#include "tin/runtime/coroutine.h"
+#include "tin/runtime/env.h"
+#include "tin/runtime/m.h"
+#include "tin/runtime/p.h"
+#include "tin/runtime/scheduler.h"
+#include "tin/runtime/util.h"
+#include "tin/time.h"
+#include "tin/time/time.h"
+
+#include "tin/runtime/buffer_pool.h"
+
+namespace tin::runtime {
+
+namespace {
+
+// Depot buffers unused for a whole period go back to the allocator.
+const int64_t kBufferPoolTrimPeriod = 5 * tin::kSecond;
+// Bytes a P caches per class; at least two buffers of any class.
+const size_t kBufferCacheClassBytes = 256 * 1024;
+const int64_t kNever = std::numeric_limits<int64_t>::max();
+
+size_t ClassSize(int c) {
+  return size_t(1) << (kBufferClassShiftMin + c);
+}
+
+// -1 for sizes the pool does not serve. Below the smallest class a
+// plain allocation is cheaper than holding a whole class buffer.
+int ClassOf(size_t size) {
+  if (size < io::kMinPooledBufferSize || size > io::kMaxPooledBufferSize) {
+    return -1;
+  }
+  int c = 0;
+  while (ClassSize(c) < size) {
+    ++c;
+  }
+  return c;
+}
+
+int CacheLimit(int c) {
+  return static_cast<int>(std::clamp<size_t>(
+      kBufferCacheClassBytes / ClassSize(c), 2, kBufferCacheMaxCount));
+}
+
+struct Depot {
+  absl::Mutex mu;
+  std::vector<void*> bufs[kBufferClassCount];
+  // Fewest buffers each class held since the last trim: that many sat
+  // unused the whole period.
+  size_t low[kBufferClassCount] = {};
+  size_t bytes = 0;
+  int64_t next_trim = kNever;
+};
+
+Depot* GetDepot() {
+  static Depot* depot = new Depot;  // never destroyed
+  return depot;
+}
+
+std::atomic<uint64_t> depot_hits{0};
+std::atomic<uint64_t> allocs{0};
+// Bumped when the pool is over its idle limit: every P then hands its
+// cache to the depot on its next pool access.
+std::atomic<uint32_t> trim_gen{0};
+
+size_t IdleLimit() {
+  return static_cast<size_t>(rtm_conf != nullptr
+                                 ? rtm_conf->BufferPoolIdleLimit()
+                                 : kDefaultBufferPoolIdleLimit);
+}
+
+BufferCache* CurrentCache() {
+  G* gp = GetG();
+  if (gp == nullptr || gp->M() == nullptr || gp->M()->P() == nullptr) {
+    return nullptr;
+  }
+  return gp->M()->P()->GetBufferCache();
+}
+
+void* NewBuffer(int c) {
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  void* buf = std::malloc(ClassSize(c));
+  if (buf == nullptr) {
+    throw std::bad_alloc();
+  }
+  return buf;
+}
+
+// Moves up to n buffers of class c into out. Returns how many.
+int DepotGet(int c, void** out, int n) {
+  Depot* depot = GetDepot();
+  absl::MutexLock guard(&depot->mu);
+  std::vector<void*>& bufs = depot->bufs[c];
+  int got = std::min(n, static_cast<int>(bufs.size()));
+  for (int i = 0; i < got; ++i) {
+    out[i] = bufs.back();
+    bufs.pop_back();
+  }
+  depot->low[c] = std::min(depot->low[c], bufs.size());
+  depot->bytes -= got * ClassSize(c);
+  return got;
+}
+
+// Takes n buffers of class c; what would push the depot past the idle
+// limit is freed instead.
+void DepotPut(int c, void* const* in, int n) {
+  Depot* depot = GetDepot();
+  size_t size = ClassSize(c);
+  size_t limit = IdleLimit();
+  int kept = 0;
+  int64_t first_trim = 0;
+  {
+    absl::MutexLock guard(&depot->mu);
+    while (kept < n && depot->bytes + size <= limit) {
+      depot->bufs[c].push_back(in[kept++]);
+      depot->bytes += size;
+    }
+    if (kept > 0 && depot->next_trim == kNever) {
+      depot->next_trim = MonoNow() + kBufferPoolTrimPeriod;
+      first_trim = depot->next_trim;
+    }
+  }
+  for (int i = kept; i < n; ++i) {
+    std::free(in[i]);
+  }
+  if (first_trim != 0 && sched != nullptr) {
+    // A parked sysmon has no trim deadline yet.
+    sched->WakeSysmon(first_trim);
+  }
+}
+
+// Owner only.
+void AddCacheBytes(BufferCache* cache, int c, int n) {
+  size_t bytes = cache->bytes.load(std::memory_order_relaxed);
+  cache->bytes.store(bytes + n * ClassSize(c), std::memory_order_relaxed);
+}
+
+void FlushCache(BufferCache* cache) {
+  for (int c = 0; c < kBufferClassCount; ++c) {
+    if (cache->len[c] > 0) {
+      DepotPut(c, cache->bufs[c], cache->len[c]);
+      cache->len[c] = 0;
+    }
+  }
+  cache->bytes.store(0, std::memory_order_relaxed);
+}
+
+// Owner only: a trim pass since the last access wants the cache back.
+void CheckTrimGen(BufferCache* cache) {
+  uint32_t gen = trim_gen.load(std::memory_order_relaxed);
+  if (cache->trim_gen != gen) {
+    cache->trim_gen = gen;
+    FlushCache(cache);
+  }
+}
+
+void* Get(int c) {
+  BufferCache* cache = CurrentCache();
+  if (cache == nullptr) {
+    void* buf = nullptr;
+    if (DepotGet(c, &buf, 1) == 1) {
+      depot_hits.fetch_add(1, std::memory_order_relaxed);
+      return buf;
+    }
+    return NewBuffer(c);
+  }
+  CheckTrimGen(cache);
+  if (cache->len[c] == 0) {
+    // Refill half the cache, so a P alternating Get and Put does not go
+    // to the depot every time.
+    int got = DepotGet(c, cache->bufs[c], CacheLimit(c) / 2);
+    if (got == 0) {
+      return NewBuffer(c);
+    }
+    depot_hits.fetch_add(1, std::memory_order_relaxed);
+    cache->len[c] = got;
+    AddCacheBytes(cache, c, got);
+  } else {
+    cache->hits.store(cache->hits.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+  }
+  AddCacheBytes(cache, c, -1);
+  return cache->bufs[c][--cache->len[c]];
+}
+
+void Put(int c, void* buf) {
+  BufferCache* cache = CurrentCache();
+  if (cache == nullptr) {
+    DepotPut(c, &buf, 1);
+    return;
+  }
+  CheckTrimGen(cache);
+  int limit = CacheLimit(c);
+  if (cache->len[c] == limit) {
+    int half = limit / 2;
+    DepotPut(c, cache->bufs[c] + half, limit - half);
+    cache->len[c] = half;
+    AddCacheBytes(cache, c, half - limit);
+  }
+  cache->bufs[c][cache->len[c]++] = buf;
+  AddCacheBytes(cache, c, 1);
+}
+
+}  // namespace
+
+int64_t BufferPoolTrim(int64_t now) {
+  Depot* depot = GetDepot();
+  std::vector<void*> freed;
+  int64_t next;
+  size_t depot_bytes;
+  {
+    absl::MutexLock guard(&depot->mu);
+    if (now < depot->next_trim) {
+      return depot->next_trim;
+    }
+    for (int c = 0; c < kBufferClassCount; ++c) {
+      std::vector<void*>& bufs = depot->bufs[c];
+      size_t n = std::min(depot->low[c], bufs.size());
+      freed.insert(freed.end(), bufs.end() - n, bufs.end());
+      bufs.resize(bufs.size() - n);
+      depot->bytes -= n * ClassSize(c);
+      depot->low[c] = bufs.size();
+    }
+    depot->next_trim = depot->bytes > 0 ? now + kBufferPoolTrimPeriod
+                                        : kNever;
+    next = depot->next_trim;
+    depot_bytes = depot->bytes;
+  }
+  for (void* buf : freed) {
+    std::free(buf);
+  }
+
+  // Over the limit counting what the Ps cache: take the caches back, so
+  // the next passes can free them.
+  size_t cached = 0;
+  if (sched != nullptr && rtm_conf != nullptr) {
+    for (int i = 0; i < rtm_conf->MaxProcs(); ++i) {
+      P* p = sched->AllpPublic()[i];
+      if (p != nullptr) {
+        cached += p->GetBufferCache()->bytes.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  if (cached > 0 && depot_bytes + cached > IdleLimit()) {
+    trim_gen.fetch_add(1, std::memory_order_relaxed);
+  }
+  return next;
+}
+
+}  // namespace tin::runtime
+
+namespace tin::io {
+
+void* AllocBuffer(size_t size, size_t* capacity) {
+  int c = runtime::ClassOf(size);
+  if (c < 0) {
+    if (capacity != nullptr) {
+      *capacity = size;
+    }
+    void* buf = std::malloc(std::max<size_t>(size, 1));
+    if (buf == nullptr) {
+      throw std::bad_alloc();
+    }
+    return buf;
+  }
+  if (capacity != nullptr) {
+    *capacity = runtime::ClassSize(c);
+  }
+  return runtime::Get(c);
+}
+
+void FreeBuffer(void* buf, size_t size) {
+  if (buf == nullptr) {
+    return;
+  }
+  int c = runtime::ClassOf(size);
+  if (c < 0) {
+    std::free(buf);
+    return;
+  }
+  runtime::Put(c, buf);
+}
+
+BufferPoolStats GetBufferPoolStats() {
+  BufferPoolStats stats = {};
+  if (runtime::sched != nullptr && runtime::rtm_conf != nullptr) {
+    for (int i = 0; i < runtime::rtm_conf->MaxProcs(); ++i) {
+      runtime::P* p = runtime::sched->AllpPublic()[i];
+      if (p != nullptr) {
+        stats.cache_hits +=
+            p->GetBufferCache()->hits.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  stats.depot_hits = runtime::depot_hits.load(std::memory_order_relaxed);
+  stats.allocs = runtime::allocs.load(std::memory_order_relaxed);
+  runtime::Depot* depot = runtime::GetDepot();
+  absl::MutexLock guard(&depot->mu);
+  stats.depot_bytes = depot->bytes;
+  return stats;
+}
+
+void TrimBufferPool() {
+  runtime::Depot* depot = runtime::GetDepot();
+  std::vector<void*> freed;
+  {
+    absl::MutexLock guard(&depot->mu);
+    for (int c = 0; c < runtime::kBufferClassCount; ++c) {
+      freed.insert(freed.end(), depot->bufs[c].begin(),
+                   depot->bufs[c].end());
+      depot->bufs[c].clear();
+      depot->low[c] = 0;
+    }
+    depot->bytes = 0;
+    depot->next_trim = runtime::kNever;
+  }
+  for (void* buf : freed) {
+    std::free(buf);
+  }
+  runtime::trim_gen.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace tin::io
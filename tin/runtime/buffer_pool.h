@@ -0,0 +1,43 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Runtime side of the I/O buffer pool (tin/io/buffer_pool.h). Buffers come
+// in power-of-two size classes. Each P caches a few free buffers per class
+// and trades half of them with a global depot when its cache runs empty or
+// full; threads without a P go to the depot directly. sysmon frees depot
+// buffers that sat unused for a whole trim period.
+
+#ifndef TIN_RUNTIME_BUFFER_POOL_H_
+#define TIN_RUNTIME_BUFFER_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace tin::runtime {
+
+// 512 B, 1 KiB, ..., 1 MiB.
+const int kBufferClassShiftMin = 9;
+const int kBufferClassCount = 12;
+// Per-P, per-class cache bound.
+const int kBufferCacheMaxCount = 64;
+
+// Owned by one P; only the coroutine running on that P touches the
+// buffers. The counters are read by GetBufferPoolStats from anywhere.
+struct BufferCache {
+  void* bufs[kBufferClassCount][kBufferCacheMaxCount] = {};
+  int len[kBufferClassCount] = {};
+  // Trim generation the cache last flushed at; see BufferPoolTrim.
+  uint32_t trim_gen = 0;
+  // Written by the owner only, read by sysmon and GetBufferPoolStats.
+  std::atomic<size_t> bytes{0};
+  std::atomic<uint64_t> hits{0};
+};
+
+// Called by sysmon. Frees what the depot held unused since the last
+// trim and asks every P to hand its cache back on its next pool access.
+// Returns when to call again, or INT64_MAX while the pool holds nothing.
+int64_t BufferPoolTrim(int64_t now);
+
+}  // namespace tin::runtime
+#endif  // TIN_RUNTIME_BUFFER_POOL_H_
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <absl/log/log.h>
+
 #include <utility>
 #include <functional>
 #include <string>
@@ -33,7 +35,8 @@ Coroutine::Coroutine()
   , goid_(g_next_goid.fetch_add(1, std::memory_order_relaxed))
   , waitsince_(0)
   , waitreason_(kWaitReasonZero)
-  , param_(nullptr) {
+  , param_(nullptr)
+  , home_p_(-1) {
 }
 
 Coroutine::~Coroutine() {
@@ -54,8 +57,8 @@ Timer* Coroutine::GetTimer() {
   return timer_;
 }
 
-Coroutine* Coroutine::Create(std::function<void()> closure,
-                           const SpawnOptions& opts) {
+Coroutine* Coroutine::New(std::function<void()> closure,
+                          const SpawnOptions& opts) {
   int stack_size = opts.stack_size > 0 ? opts.stack_size : kDefaultStackSize;
   std::unique_ptr<Coroutine> coro(new Coroutine);
   // Go 1.15 proc.go:newproc1 — override the goid assigned in the constructor
@@ -64,6 +67,10 @@ Coroutine* Coroutine::Create(std::function<void()> closure,
   P* curp = GetP();
   if (curp != nullptr) {
     coro->goid_ = curp->AllocGoid();
+    // Children of a no-steal P's coroutines stay on that P.
+    if (curp->NoSteal()) {
+      coro->home_p_ = curp->Id();
+    }
   }
   coro->flags_ = 0;
   coro->args_ = 0;
@@ -79,10 +86,55 @@ Coroutine* Coroutine::Create(std::function<void()> closure,
   // make_zcontext round address internally.
   coro->context_ =
     make_zcontext(coro->stack_->Pointer(), stack_size, StaticProc);
+  return coro.release();
+}
+
+Coroutine* Coroutine::Create(std::function<void()> closure,
+                           const SpawnOptions& opts) {
+  Coroutine* coro = New(std::move(closure), opts);
   // lock-free enqueue (unchanged).
-  GetP()->RunqPut(coro.get(), true);
+  GetP()->RunqPut(coro, true);
+  sched->WakePIfNecessary();
+  return coro;
+}
+
+void Coroutine::CreateBatch(std::vector<std::function<void()>> closures,
+                            const SpawnOptions& opts) {
+  if (closures.empty()) {
+    return;
+  }
+  G* head = nullptr;
+  G* tail = nullptr;
+  for (auto& closure : closures) {
+    Coroutine* coro = New(std::move(closure), opts);
+    coro->SetSchedLink(nullptr);
+    if (tail != nullptr) {
+      tail->SetSchedLink(coro);
+    } else {
+      head = coro;
+    }
+    tail = coro;
+  }
+  GetP()->RunqPutBatch(head);
   sched->WakePIfNecessary();
-  return coro.release();
+}
+
+Coroutine* Coroutine::CreateOn(int id, std::function<void()> closure,
+                               const SpawnOptions& opts) {
+  if (id < 0 || id >= rtm_conf->MaxProcs()) {
+    LOG(FATAL) << "CreateOn: invalid P id " << id;
+  }
+  P* p = sched->AllpPublic()[id];
+  Coroutine* coro = New(std::move(closure), opts);
+  coro->home_p_ = p->NoSteal() ? id : -1;
+  if (p == GetP()) {
+    p->RunqPut(coro, true);
+    sched->WakePIfNecessary();
+  } else {
+    p->InboxPut(coro);
+    sched->WakeP(p);
+  }
+  return coro;
 }
 
 Coroutine* Coroutine::CreateG0(ZContextEntry entry, intptr_t args,
@@ -127,6 +179,19 @@ void SpawnInternal(std::function<void()> closure, const char* name) {
   Coroutine::Create(std::move(closure), opts);
 }
 
+void SpawnBatchInternal(std::vector<std::function<void()>> closures,
+                        const char* name) {
+  SpawnOptions opts;
+  opts.name = name ? name : "internal";
+  Coroutine::CreateBatch(std::move(closures), opts);
+}
+
+void SpawnOnP(int id, std::function<void()> closure, const char* name) {
+  SpawnOptions opts;
+  opts.name = name ? name : "internal";
+  Coroutine::CreateOn(id, std::move(closure), opts);
+}
+
 }  // namespace runtime
 
 void SpawnClosure(std::function<void()> closure, const SpawnOptions& opts) {
@@ -8,6 +8,7 @@
 #include <memory>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "context/zcontext.h"
 #include "tin/config/config.h"
@@ -135,17 +136,35 @@ class Coroutine {
   void* Param() const { return param_; }
   void SetParam(void* p) { param_ = p; }
 
+  // Id of the no-steal P this G is bound to, or -1. Wherever a homed G
+  // is woken it is sent back to that P (thread-per-core mode).
+  int32_t HomeP() const { return home_p_; }
+
   Timer* GetTimer();
 
   // User coroutine factory: creates a coroutine with a closure and enqueues it.
   static Coroutine* Create(std::function<void()> closure,
                           const SpawnOptions& opts);
 
+  // Creates one coroutine per closure and makes them all runnable with a
+  // single runq publish and a single wakeup.
+  static void CreateBatch(std::vector<std::function<void()>> closures,
+                          const SpawnOptions& opts);
+
+  // Like Create, but enqueues the coroutine on P `id` (through its inbox
+  // when that is not the current P). On a no-steal P it stays there.
+  static Coroutine* CreateOn(int id, std::function<void()> closure,
+                             const SpawnOptions& opts);
+
   // G0 factory: creates a system-stack coroutine (C ABI entry, no enqueue).
   static Coroutine* CreateG0(ZContextEntry entry, intptr_t args,
                             int stack_size, const char* name);
 
  private:
+  // Builds a runnable user coroutine without enqueueing it.
+  static Coroutine* New(std::function<void()> closure,
+                        const SpawnOptions& opts);
+
   static void StaticProc(intptr_t args);
   void Proc();
 
@@ -170,12 +189,21 @@ class Coroutine {
   int64_t waitsince_;     // monotonic ns when blocking started
   int32_t waitreason_;    // WaitReason enum
   void* param_;           // wakeup parameter
+  int32_t home_p_;        // no-steal P id, -1 if none
 };
 
 // Internal spawn (replaces the old SpawnSimple overloads).
 void SpawnInternal(std::function<void()> closure,
                    const char* name = nullptr);
 
+// Internal batch spawn, see Coroutine::CreateBatch.
+void SpawnBatchInternal(std::vector<std::function<void()>> closures,
+                        const char* name = nullptr);
+
+// Internal spawn on a given P, see Coroutine::CreateOn.
+void SpawnOnP(int id, std::function<void()> closure,
+              const char* name = nullptr);
+
 }  // namespace runtime
 
 // Type-erased spawn entry point (replaces the old RuntimeSpawn).
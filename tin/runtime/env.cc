@@ -18,6 +18,8 @@
 #include "tin/runtime/threadpoll.h"
 #include "tin/runtime/scheduler.h"
 #include "tin/runtime/sysmon.h"
+#include "tin/runtime/net/netpoll.h"
+#include "tin/runtime/net/pollops.h"
 
 #include "tin/runtime/env.h"
 
@@ -66,10 +68,14 @@ int Env::Initialize(EntryFn fn, int argc, char** argv, tin::Config* new_conf) {
 void Env::Deinitialize() {
   // If OnMainExit() hasn't run yet (Stop() was called before the entry
   // function returned), do the cleanup now from the main thread.
-  // JoinAll() sends nullptr to all thread pool workers and joins them.
+  // JoinAll() drains the thread pool and joins its workers.
   if (!main_exited_) {
     ThreadPool::GetInstance()->JoinAll();
   }
+  // No coroutine runs any more; release the poller's kernel resources.
+  if (NetPollInited()) {
+    pollops::ServerDeinit();
+  }
   delete coro_tls;
   coro_tls = nullptr;
   // Clear non-owning global pointer before unique_ptr member is reset.
@@ -107,6 +113,7 @@ void Env::OnMainExit() {
   // purpose of the lifecycle API.
   exit_flag_ = true;
   main_exited_ = true;  // signal to Deinitialize() that cleanup is done
+  sched->WakeSysmon();  // let a parked sysmon observe ExitFlag
   ThreadPool::GetInstance()->JoinAll();
   rtm_env->main_signal_.Notify();
 }
@@ -0,0 +1,215 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "tin/sync/atomic.h"
+#include "tin/runtime/net/io_uring.h"
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+namespace tin::runtime {
+
+namespace {
+
+int SysSetup(uint32_t entries, io_uring_params* p) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int SysEnter(int fd, uint32_t to_submit, uint32_t min_complete,
+             uint32_t flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+template <typename T>
+T* At(void* base, uint32_t off) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + off);
+}
+
+}  // namespace
+
+IoUring::IoUring()
+  : ring_fd_(-1)
+  , features_(0)
+  , sq_ptr_(MAP_FAILED)
+  , sq_len_(0)
+  , cq_ptr_(MAP_FAILED)
+  , cq_len_(0)
+  , sqes_(nullptr)
+  , sqes_len_(0)
+  , sq_khead_(nullptr)
+  , sq_ktail_(nullptr)
+  , sq_kflags_(nullptr)
+  , sq_mask_(0)
+  , sq_entries_(0)
+  , sqe_tail_(0)
+  , submitted_(0)
+  , cq_khead_(nullptr)
+  , cq_ktail_(nullptr)
+  , cq_mask_(0)
+  , cqes_(nullptr) {
+}
+
+IoUring::~IoUring() {
+  Close();
+}
+
+int IoUring::Init(uint32_t entries, uint32_t cq_entries) {
+  io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  if (cq_entries > entries) {
+    p.flags |= IORING_SETUP_CQSIZE;
+    p.cq_entries = cq_entries;
+  }
+  int fd = SysSetup(entries, &p);
+  if (fd < 0) {
+    return errno;
+  }
+  ring_fd_ = fd;
+  features_ = p.features;
+
+  sq_len_ = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+  cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_len_ = cq_len_ = std::max(sq_len_, cq_len_);
+  }
+  sq_ptr_ = mmap(nullptr, sq_len_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    int err = errno;
+    Close();
+    return err;
+  }
+  if (single_mmap) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ = mmap(nullptr, cq_len_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      int err = errno;
+      Close();
+      return err;
+    }
+  }
+  sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    int err = errno;
+    Close();
+    return err;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  sq_khead_ = At<uint32_t>(sq_ptr_, p.sq_off.head);
+  sq_ktail_ = At<uint32_t>(sq_ptr_, p.sq_off.tail);
+  sq_kflags_ = At<uint32_t>(sq_ptr_, p.sq_off.flags);
+  sq_mask_ = *At<uint32_t>(sq_ptr_, p.sq_off.ring_mask);
+  sq_entries_ = *At<uint32_t>(sq_ptr_, p.sq_off.ring_entries);
+  // Identity-map the indirection array once; SQEs are then used in ring
+  // order and publishing is a single tail store.
+  uint32_t* array = At<uint32_t>(sq_ptr_, p.sq_off.array);
+  for (uint32_t i = 0; i < sq_entries_; i++) {
+    array[i] = i;
+  }
+  sqe_tail_ = submitted_ = *sq_ktail_;
+
+  cq_khead_ = At<uint32_t>(cq_ptr_, p.cq_off.head);
+  cq_ktail_ = At<uint32_t>(cq_ptr_, p.cq_off.tail);
+  cq_mask_ = *At<uint32_t>(cq_ptr_, p.cq_off.ring_mask);
+  cqes_ = At<io_uring_cqe>(cq_ptr_, p.cq_off.cqes);
+  return 0;
+}
+
+void IoUring::Close() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_len_);
+    sqes_ = nullptr;
+  }
+  if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+    munmap(cq_ptr_, cq_len_);
+  }
+  cq_ptr_ = MAP_FAILED;
+  if (sq_ptr_ != MAP_FAILED) {
+    munmap(sq_ptr_, sq_len_);
+    sq_ptr_ = MAP_FAILED;
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+io_uring_sqe* IoUring::GetSqe() {
+  uint32_t head = atomic::acquire_load32(sq_khead_);
+  if (sqe_tail_ - head >= sq_entries_) {
+    return nullptr;
+  }
+  io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+  sqe_tail_++;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+int IoUring::Submit(uint32_t min_complete, uint32_t flags) {
+  uint32_t to_submit = sqe_tail_ - submitted_;
+  if (to_submit != 0) {
+    atomic::release_store32(sq_ktail_, sqe_tail_);
+  }
+  int n = SysEnter(ring_fd_, to_submit, min_complete, flags);
+  int err = errno;
+  // Without SQPOLL the kernel consumes SQEs synchronously, so its head
+  // is exact even when the wait part was interrupted.
+  submitted_ = atomic::acquire_load32(sq_khead_);
+  return n < 0 ? -err : n;
+}
+
+int IoUring::Wait(uint32_t min_complete) {
+  int n = SysEnter(ring_fd_, 0, min_complete, IORING_ENTER_GETEVENTS);
+  return n < 0 ? -errno : 0;
+}
+
+bool IoUring::CqOverflow() const {
+  return (atomic::acquire_load32(sq_kflags_) & IORING_SQ_CQ_OVERFLOW) != 0;
+}
+
+int IoUring::Register(uint32_t opcode, const void* arg, uint32_t nr_args) {
+  int ret = static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd_, opcode, arg, nr_args));
+  return ret < 0 ? -errno : ret;
+}
+
+io_uring_cqe* IoUring::PeekCqe() {
+  uint32_t head = *cq_khead_;
+  if (head == atomic::acquire_load32(cq_ktail_)) {
+    return nullptr;
+  }
+  return &cqes_[head & cq_mask_];
+}
+
+void IoUring::CqAdvance(uint32_t n) {
+  atomic::release_store32(cq_khead_, *cq_khead_ + n);
+}
+
+bool IoUring::CqReady() {
+  return *cq_khead_ != atomic::acquire_load32(cq_ktail_);
+}
+
+}  // namespace tin::runtime
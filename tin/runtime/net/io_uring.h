@@ -0,0 +1,86 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TIN_RUNTIME_NET_IO_URING_H_
+#define TIN_RUNTIME_NET_IO_URING_H_
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tin::runtime {
+
+// IoUring is a minimal io_uring ring built on the raw syscalls, so the
+// runtime does not depend on liburing. It does no locking of its own:
+// callers serialize the submission side (GetSqe/Submit) and the
+// completion side (PeekCqe/CqAdvance) separately.
+class IoUring {
+ public:
+  IoUring();
+  ~IoUring();
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  // Returns 0, or an errno (ENOSYS/EPERM when io_uring is unavailable).
+  int Init(uint32_t entries, uint32_t cq_entries);
+  void Close();
+
+  bool Inited() const { return ring_fd_ >= 0; }
+  int Fd() const { return ring_fd_; }
+  uint32_t Features() const { return features_; }
+
+  // Returns a zeroed SQE, or nullptr if the SQ is full (Submit first).
+  io_uring_sqe* GetSqe();
+
+  // Number of SQEs handed out by GetSqe and not yet submitted.
+  uint32_t Pending() const { return sqe_tail_ - submitted_; }
+
+  // Publishes pending SQEs and enters the kernel. With
+  // IORING_ENTER_GETEVENTS in flags, waits for min_complete CQEs.
+  // Returns the number of SQEs consumed, or -errno.
+  int Submit(uint32_t min_complete, uint32_t flags);
+
+  // Waits for min_complete CQEs without touching the SQ, so it may run
+  // concurrently with a submitter. Returns 0 or -errno.
+  int Wait(uint32_t min_complete);
+
+  // True if the kernel holds completions that did not fit in the CQ
+  // (IORING_FEAT_NODROP); an enter with GETEVENTS flushes them.
+  bool CqOverflow() const;
+
+  // io_uring_register(2). Returns 0 or -errno.
+  int Register(uint32_t opcode, const void* arg, uint32_t nr_args);
+
+  // Completion side. PeekCqe returns nullptr when the CQ is empty.
+  io_uring_cqe* PeekCqe();
+  void CqAdvance(uint32_t n);
+  bool CqReady();
+
+ private:
+  int ring_fd_;
+  uint32_t features_;
+
+  void* sq_ptr_;
+  size_t sq_len_;
+  void* cq_ptr_;
+  size_t cq_len_;
+  io_uring_sqe* sqes_;
+  size_t sqes_len_;
+
+  uint32_t* sq_khead_;
+  uint32_t* sq_ktail_;
+  uint32_t* sq_kflags_;
+  uint32_t sq_mask_;
+  uint32_t sq_entries_;
+  uint32_t sqe_tail_;   // next SQE to hand out
+  uint32_t submitted_;  // SQEs already published to the kernel
+
+  uint32_t* cq_khead_;
+  uint32_t* cq_ktail_;
+  uint32_t cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+}  // namespace tin::runtime
+#endif  // TIN_RUNTIME_NET_IO_URING_H_
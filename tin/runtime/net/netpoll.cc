@@ -4,11 +4,15 @@
 
 #include <absl/log/check.h>
 #include <absl/log/log.h>
+#include "build/build_config.h"
 #include "tin/sync/atomic.h"
 #include "tin/runtime/runtime.h"
 #include "tin/runtime/coroutine.h"
 #include "tin/runtime/scheduler.h"
 #include "tin/runtime/net/netpoll.h"
+#if defined(OS_LINUX)
+#include "tin/runtime/net/netpoll_uring.h"
+#endif
 
 namespace tin::runtime {
 
@@ -72,6 +76,12 @@ int NetPollCheckErr(PollDescriptor* pd, int32_t mode) {
 bool NetPollBlockCommit(void* arg1, void* arg2) {
   uintptr_t gp = reinterpret_cast<uintptr_t>(arg1);
   uintptr_t* gpp = reinterpret_cast<uintptr_t*>(arg2);
+#if defined(OS_LINUX)
+  // The op this G waits for may still sit in the SQ.
+  if (UringNetPollActive()) {
+    UringNetPollFlush();
+  }
+#endif
   if (!atomic::release_cas(gpp, kPdWait, gp)) {
     return false;
   }
@@ -32,7 +32,9 @@ void NetPollDeinit();
 
 int32_t NetPollOpen(uintptr_t fd, PollDescriptor* pd);
 
-int32_t NetPollClose(uintptr_t fd);
+// pd is the descriptor registered by NetPollOpen; backends that track
+// registrations by descriptor (io_uring) need it to cancel the poll.
+int32_t NetPollClose(uintptr_t fd, PollDescriptor* pd);
 
 void NetPollArm(PollDescriptor* pd, int mode);
 
@@ -42,6 +44,14 @@ void NetPollArm(PollDescriptor* pd, int mode);
 //   delay_ns > 0   → block at most delay_ns nanoseconds
 G* NetPoll(int64_t delay_ns);
 
+// True if the backend keeps one poll set per P
+// (Config::EnableNetPollSharding, epoll only).
+bool NetPollSharded();
+
+// Non-blocking poll of only the descriptors registered from P `id`.
+// Returns nullptr when the backend is not sharded.
+G* NetPollLocal(int id);
+
 // Wake up a blocked NetPoll call. Used by WakeNetPoller (timer add)
 // and NetPollShutdown to interrupt epoll_wait / kevent / IOCP.
 void NetPollBreak();
@@ -6,14 +6,20 @@
 #include <sys/epoll.h>
 #include <fcntl.h>
 
+#include <vector>
+
 #include <absl/base/macros.h>
 #include <absl/log/log.h>
 #include <absl/log/check.h>
 
 #include "base/posix/eintr_wrapper.h"
+#include "tin/config/config.h"
 #include "tin/runtime/runtime.h"
+#include "tin/runtime/env.h"
+#include "tin/runtime/p.h"
 #include "tin/runtime/posix_util.h"
 #include "tin/runtime/net/netpoll.h"
+#include "tin/runtime/net/netpoll_uring.h"
 
 namespace {
 int epfd = -1;
@@ -26,19 +32,42 @@ int g_break_wr = -1;
 // Sentinel stored in epoll_event.data.ptr to identify break events.
 // A valid PollDescriptor* is always aligned (at least 2), so 1 is safe.
 constexpr uintptr_t kNetpollBreak = 1;
+
+// Sharded mode (Config::EnableNetPollSharding): every P owns an epoll set
+// holding the descriptors opened on that P, and each shard's epfd is in
+// turn registered, level-triggered, in epfd itself with data
+// (index << kShardShift) | kShardTag. A P drains its own shard through
+// NetPollLocal; the single blocking NetPoll still waits on epfd and
+// drains whichever shards became ready, so nothing is ever missed.
+constexpr uintptr_t kShardTag = 2;
+constexpr int kShardShift = 3;
+std::vector<int> shard_epfds;
+
+int CreateEpoll() {
+  int fd = epoll_create(1024);
+  DCHECK_NE(fd, -1);
+  if (fd < 0) {
+    LOG(FATAL) << "epoll_create failed";
+  }
+  DCHECK_EQ(tin::Cloexec(fd, true), 0);
+  return fd;
+}
 }  // namespace
 
 namespace tin::runtime {
 
 struct PollDescriptor;
 
+// Every entry point below forwards to netpoll_uring.cc when the io_uring
+// backend was selected and initialized; epoll is the fallback.
 void NetPollInit() {
-  epfd = epoll_create(1024);
-  DCHECK_NE(epfd, -1);
-  if (epfd < 0) {
-    LOG(FATAL) << "epoll_create failed";
+  if (rtm_conf->GetNetPoller() == NetPoller::kIoUring) {
+    if (UringNetPollInit()) {
+      return;
+    }
+    LOG(WARNING) << "io_uring netpoll unavailable, falling back to epoll";
   }
-  DCHECK_EQ(tin::Cloexec(epfd, true), 0);
+  epfd = CreateEpoll();
 
   // Create break pipe (Go 1.15 netpoll_epoll.go:42-58).
   int pipefd[2];
@@ -60,6 +89,19 @@ void NetPollInit() {
   if (epoll_ctl(epfd, EPOLL_CTL_ADD, g_break_rd, &ev) == -1) {
     LOG(FATAL) << "NetPollInit: epoll_ctl break fd failed: " << errno;
   }
+
+  // No-steal Ps (Config::SetNoStealProcs) always poll their own set.
+  if (rtm_conf->IsNetPollShardingEnabled() || rtm_conf->NoStealProcs() > 0) {
+    for (int i = 0; i < rtm_conf->MaxProcs(); i++) {
+      int fd = CreateEpoll();
+      ev.events = EPOLLIN;
+      ev.data.u64 = (static_cast<uint64_t>(i) << kShardShift) | kShardTag;
+      if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        LOG(FATAL) << "NetPollInit: epoll_ctl shard fd failed: " << errno;
+      }
+      shard_epfds.push_back(fd);
+    }
+  }
 }
 
 void NetPollShutdown() {
@@ -68,9 +110,16 @@ void NetPollShutdown() {
 }
 
 void NetPollPreDeinit() {
+  if (UringNetPollActive()) {
+    UringNetPollDeinit();
+  }
 }
 
 void NetPollBreak() {
+  if (UringNetPollActive()) {
+    UringNetPollBreak();
+    return;
+  }
   if (g_break_wr >= 0) {
     char c = 0;
     HANDLE_EINTR(write(g_break_wr, &c, 1));
@@ -82,17 +131,31 @@ void NetPollBreak() {
 #endif
 
 int32_t NetPollOpen(uintptr_t fd, PollDescriptor* pd) {
+  if (UringNetPollActive()) {
+    return UringNetPollOpen(fd, pd);
+  }
+  int set = epfd;
+  if (!shard_epfds.empty()) {
+    // The P that accepted or dialed the connection keeps polling it.
+    P* p = GetP();
+    pd->shard = p != nullptr ? p->Id() : 0;
+    set = shard_epfds[pd->shard];
+  }
   struct epoll_event ev;
   ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
   ev.data.ptr = pd;
-  if (epoll_ctl(epfd, EPOLL_CTL_ADD, static_cast<int>(fd), &ev) == -1)
+  if (epoll_ctl(set, EPOLL_CTL_ADD, static_cast<int>(fd), &ev) == -1)
     return errno;
   return 0;
 }
 
-int32_t NetPollClose(uintptr_t fd) {
+int32_t NetPollClose(uintptr_t fd, PollDescriptor* pd) {
+  if (UringNetPollActive()) {
+    return UringNetPollClose(fd, pd);
+  }
+  int set = pd->shard >= 0 ? shard_epfds[pd->shard] : epfd;
   struct epoll_event ev;
-  if (epoll_ctl(epfd, EPOLL_CTL_DEL,  static_cast<int>(fd), &ev) == -1)
+  if (epoll_ctl(set, EPOLL_CTL_DEL,  static_cast<int>(fd), &ev) == -1)
     return errno;
   return 0;
 }
@@ -101,8 +164,78 @@ void NetPollArm(PollDescriptor* pd, int mode) {
   LOG(FATAL) << "unused";
 }
 
+namespace {
+
+void DrainShard(int id, G** gpp);
+
+// Turns n epoll events into ready Gs on *gpp.
+void ProcessEvents(epoll_event* events, int n, G** gpp) {
+  for (int i = 0; i < n; ++i) {
+    epoll_event& ev = events[i];
+    if (ev.events == 0) {
+      continue;
+    }
+    uintptr_t data = static_cast<uintptr_t>(ev.data.u64);
+    // Check for break event (netpoll_epoll.go:81-99).
+    if (data == kNetpollBreak) {
+      char buf[16];
+      // Drain the pipe — there may be multiple pending bytes.
+      while (HANDLE_EINTR(read(g_break_rd, buf, sizeof(buf))) > 0) {
+        // discard
+      }
+      continue;  // skip, not a ready G
+    }
+    if ((data & ((1 << kShardShift) - 1)) == kShardTag) {
+      DrainShard(static_cast<int>(data >> kShardShift), gpp);
+      continue;
+    }
+    int mode = 0;
+    if ((ev.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0) {
+      mode += 'r';
+    }
+    if ((ev.events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0) {
+      mode += 'w';
+    }
+    if (mode != 0) {
+      PollDescriptor* pd = static_cast<PollDescriptor*>(ev.data.ptr);
+      NetPollReady(gpp, pd, mode);
+    }
+  }
+}
+
+// One non-blocking pass over a shard. Anything left behind keeps the
+// shard's epfd readable in the root set, so it is picked up later.
+void DrainShard(int id, G** gpp) {
+  epoll_event events[128];
+  int n = HANDLE_EINTR(
+      epoll_wait(shard_epfds[id], &events[0], ABSL_ARRAYSIZE(events), 0));
+  if (n < 0) {
+    LOG(FATAL) << "epoll_wait, fatal error, error code: " << errno;
+  }
+  ProcessEvents(events, n, gpp);
+}
+
+}  // namespace
+
+bool NetPollSharded() {
+  return !shard_epfds.empty();
+}
+
+G* NetPollLocal(int id) {
+  if (shard_epfds.empty() || id < 0 ||
+      id >= static_cast<int>(shard_epfds.size())) {
+    return nullptr;
+  }
+  G* gp = nullptr;
+  DrainShard(id, &gp);
+  return gp;
+}
+
 // Go 1.15 netpoll_epoll.go:106-123
 G* NetPoll(int64_t delay_ns) {
+  if (UringNetPollActive()) {
+    return UringNetPoll(delay_ns);
+  }
   if (epfd == -1)
     return nullptr;
 
@@ -131,32 +264,7 @@ G* NetPoll(int64_t delay_ns) {
     waitms = 0;
 
     G* gp = nullptr;
-    for (int i = 0; i < n; ++i) {
-      epoll_event& ev = events[i];
-      if (ev.events == 0) {
-        continue;
-      }
-      // Check for break event (netpoll_epoll.go:81-99).
-      if (reinterpret_cast<uintptr_t>(ev.data.ptr) == kNetpollBreak) {
-        char buf[16];
-        // Drain the pipe — there may be multiple pending bytes.
-        while (HANDLE_EINTR(read(g_break_rd, buf, sizeof(buf))) > 0) {
-          // discard
-        }
-        continue;  // skip, not a ready G
-      }
-      int mode = 0;
-      if ((ev.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0) {
-        mode += 'r';
-      }
-      if ((ev.events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0) {
-        mode += 'w';
-      }
-      if (mode != 0) {
-        PollDescriptor* pd = static_cast<PollDescriptor*>(ev.data.ptr);
-        NetPollReady(&gp, pd, mode);
-      }
-    }
+    ProcessEvents(events, n, &gp);
     // Return if non-blocking, or if we got ready Gs, or if the first
     // (blocking) wait returned 0 events (timeout).
     if (gp != nullptr || delay_ns == 0 || n == 0) {
@@ -89,8 +89,9 @@ int32_t NetPollOpen(uintptr_t fd, PollDescriptor* pd) {
   return n == -1 ? errno : 0;
 }
 
-int32_t NetPollClose(uintptr_t fd) {
+int32_t NetPollClose(uintptr_t fd, PollDescriptor* pd) {
   (void)fd;
+  (void)pd;
   // Don't need to unregister because calling close()
   // on fd will remove any kevents that reference the descriptor.
   return 0;
@@ -100,6 +101,14 @@ void NetPollArm(PollDescriptor* pd, int mode) {
   LOG(FATAL) << "unused";
 }
 
+bool NetPollSharded() {
+  return false;
+}
+
+G* NetPollLocal(int id) {
+  return nullptr;
+}
+
 // Go 1.15 netpoll_kqueue.go equivalent.
 G* NetPoll(int64_t delay_ns) {
   if (kq == -1) {
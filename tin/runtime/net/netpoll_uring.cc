@@ -0,0 +1,544 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// io_uring netpoll backend. Readiness comes from one multishot
+// IORING_OP_POLL_ADD per descriptor (the io_uring analogue of an EPOLLET
+// registration), so steady-state polling costs no epoll_ctl at all, and a
+// non-blocking NetPoll(0) that finds nothing to submit is just a CQ ring
+// read. Registrations queued by NetPollOpen are batched and handed to the
+// kernel by the next NetPoll in the same io_uring_enter that reaps.
+//
+// NetFD on Linux additionally performs every socket read and write as an
+// IORING_OP_RECV/SEND through UringOp; the completion is reported as
+// readiness on the descriptor, so the woken coroutine already holds the
+// transfer result.
+// tin::os::File reads and writes disk files the same way. Transfers are
+// queued too, and reach the kernel with the next reaper's enter or when
+// their issuer parks, whichever comes first.
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include <thread>
+#include <vector>
+
+#include <absl/log/log.h>
+#include <absl/log/check.h>
+
+#include "tin/sync/atomic.h"
+#include "tin/runtime/runtime.h"
+#include "tin/runtime/raw_mutex.h"
+#include "tin/runtime/scheduler.h"
+#include "tin/runtime/net/io_uring.h"
+#include "tin/runtime/net/netpoll.h"
+#include "tin/runtime/net/netpoll_uring.h"
+
+namespace tin::runtime {
+
+namespace {
+
+// user_data tags. PollDescriptor pointers are at least 8-byte aligned, so
+// values below kTagMax never collide with them.
+constexpr uint64_t kTagBreak = 1;
+constexpr uint64_t kTagTimeout = 2;
+constexpr uint64_t kTagRemove = 3;
+constexpr uint64_t kTagCancel = 4;
+constexpr uint64_t kTagMax = 8;
+// Set in the user_data of a UringOp (also at least 8-byte aligned) to tell
+// it apart from a PollDescriptor.
+constexpr uint64_t kOpBit = 1;
+
+constexpr uint32_t kSqEntries = 4096;
+constexpr uint32_t kCqEntries = 4 * kSqEntries;
+
+IoUring* ring = nullptr;
+uint32_t uring_active = 0;
+
+// sq_mu serializes the submission side, cq_mu the completion side (one
+// reaper at a time). Lock order: pd->lock -> sq_mu; cq_mu -> sq_mu.
+RawMutex sq_mu;
+RawMutex cq_mu;
+
+// Go 1.15 netpoll_epoll.go:netpollWakeSig — coalesces NetPollBreak calls.
+uint32_t break_pending = 0;
+// Set while a reaper sleeps in io_uring_enter. SQEs queued meanwhile must
+// be submitted by their producer, since the reaper won't see them.
+uint32_t waiter_blocked = 0;
+// Set under sq_mu while a UringNetPoll holds the reaper role; it submits
+// what was queued meanwhile before giving the role up.
+bool reaping = false;
+// The reaper's IORING_OP_TIMEOUT reads this when the SQE is submitted,
+// which an overflow backlog can defer past the UringNetPoll that queued
+// it, so it does not live on that stack. Guarded by cq_mu.
+__kernel_timespec reap_timeout;
+// Set when an op is queued that no awake reaper will submit; the issuer
+// does when it parks.
+uint32_t flush_pending = 0;
+
+// Multishot polls that ended while the SQ was full and the kernel refused
+// to take more; the next Reap re-arms them. Guarded by cq_mu.
+std::vector<PollDescriptor*> rearm_backlog;
+
+G* Reap();
+
+// Caller holds sq_mu. Returns false if the kernel refused the SQEs
+// because completions overflowed the CQ (-EBUSY/-EAGAIN). They stay
+// queued and go out with the first submission after the CQ is drained;
+// retrying here would spin, since draining needs cq_mu and the reaper
+// may be the caller or waiting on sq_mu.
+bool SubmitLocked() {
+  while (ring->Pending() > 0) {
+    int ret = ring->Submit(0, 0);
+    if (ret >= 0 || ret == -EINTR) {
+      continue;
+    }
+    if (ret == -EAGAIN || ret == -EBUSY) {
+      return false;
+    }
+    LOG(FATAL) << "io_uring_enter failed: " << -ret;
+  }
+  return true;
+}
+
+// Caller holds sq_mu. Returns nullptr if the SQ is full and cannot be
+// submitted until the CQ is drained.
+io_uring_sqe* TryGetSqeLocked() {
+  io_uring_sqe* sqe = ring->GetSqe();
+  if (sqe == nullptr && SubmitLocked()) {
+    sqe = ring->GetSqe();
+  }
+  return sqe;
+}
+
+// Called without sq_mu. Flushes the kernel's overflow backlog into the CQ
+// and reaps it, unless another M holds cq_mu and will.
+void DrainCq() {
+  if (!cq_mu.TryLock()) {
+    std::this_thread::yield();
+    return;
+  }
+  G* gp = nullptr;
+  if (ring->Inited()) {
+    // GETEVENTS with min_complete 0 flushes the overflow without waiting.
+    ring->Wait(0);
+    gp = Reap();
+  }
+  cq_mu.Unlock();
+  if (gp != nullptr) {
+    sched->InjectGList(gp);
+  }
+}
+
+// Caller holds sq_mu, and neither cq_mu nor a pd->lock, so it can step out
+// of sq_mu to drain the CQ when the SQ is full. Returns nullptr once the
+// ring is closed.
+io_uring_sqe* GetSqeLocked() {
+  if (!ring->Inited()) {
+    return nullptr;
+  }
+  io_uring_sqe* sqe = TryGetSqeLocked();
+  while (sqe == nullptr) {
+    sq_mu.Unlock();
+    DrainCq();
+    sq_mu.Lock();
+    if (!ring->Inited()) {
+      return nullptr;
+    }
+    sqe = TryGetSqeLocked();
+  }
+  return sqe;
+}
+
+// Caller holds sq_mu.
+void PrepPollMultishot(io_uring_sqe* sqe, uintptr_t fd, PollDescriptor* pd) {
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = static_cast<int32_t>(fd);
+  sqe->poll32_events = POLLIN | POLLOUT | POLLRDHUP;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = reinterpret_cast<uint64_t>(pd);
+}
+
+// A multishot poll ended (CQE without IORING_CQE_F_MORE). Re-arm it if the
+// descriptor is still open; otherwise drop the reference the armed request
+// held. Checking closing under pd->lock orders the re-arm SQE before the
+// POLL_REMOVE that UringNetPollClose queues after Unblock. The caller
+// reaps, so with no SQE to be had the re-arm waits in rearm_backlog,
+// still holding the reference. Caller holds cq_mu.
+void RearmOrRelease(PollDescriptor* pd, int32_t res) {
+  pd->lock.Lock();
+  bool rearm = !pd->closing && res != -EBADF && res != -EINVAL;
+  if (rearm) {
+    RawMutexGuard guard(&sq_mu);
+    io_uring_sqe* sqe = TryGetSqeLocked();
+    if (sqe != nullptr) {
+      PrepPollMultishot(sqe, pd->fd, pd);
+    } else {
+      rearm_backlog.push_back(pd);
+    }
+  }
+  pd->lock.Unlock();
+  if (!rearm) {
+    if (res == -EBADF || res == -EINVAL) {
+      LOG(ERROR) << "io_uring poll on fd " << pd->fd << " failed: " << -res;
+    }
+    pd->Release();
+  }
+}
+
+// Delivers a UringOp completion. The issuing coroutine may return (and
+// its stack frame with op) as soon as done is stored, so pd is read first
+// and kept alive by the reference taken at submission.
+void CompleteOp(G** gpp, UringOp* op, int32_t res) {
+  PollDescriptor* pd = op->pd;
+  int32_t mode = op->mode;
+  op->res = res;
+  atomic::release_store32(&op->done, 1);
+  NetPollReady(gpp, pd, mode);
+  pd->Release();
+}
+
+// An op issued after UringNetPollDeinit closed the ring fails at once;
+// the issuer has not parked yet, so no G is readied. Caller holds sq_mu.
+void CancelLocked(UringOp* op) {
+  G* gp = nullptr;
+  CompleteOp(&gp, op, -ECANCELED);
+  DCHECK(gp == nullptr);
+}
+
+// Takes mu on a thread that may not be an M (the contended RawMutex path
+// parks the M).
+void LockFromAnyThread(RawMutex* mu) {
+  while (!mu->TryLock()) {
+    std::this_thread::yield();
+  }
+}
+
+// Socket and file transfers are queued, not submitted: an awake reaper
+// publishes them in the enter that reaps, or on its way out. Otherwise
+// the issuer submits what is queued when it parks (UringNetPollFlush), so
+// ops queued by other coroutines meanwhile share its io_uring_enter, and
+// sq_mu is never held across a syscall on this path.
+void QueueOp(UringOp* op, PollDescriptor* pd, int32_t mode, uint8_t opcode,
+             uintptr_t fd, const void* buf, uint32_t len, int64_t offset,
+             uint32_t msg_flags) {
+  op->pd = pd;
+  op->mode = mode;
+  op->res = 0;
+  op->done = 0;
+  // Dropped by CompleteOp.
+  pd->AddRef();
+  RawMutexGuard guard(&sq_mu);
+  io_uring_sqe* sqe = GetSqeLocked();
+  if (sqe == nullptr) {
+    CancelLocked(op);
+    return;
+  }
+  sqe->opcode = opcode;
+  sqe->fd = static_cast<int32_t>(fd);
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = len;
+  sqe->off = static_cast<uint64_t>(offset);
+  sqe->msg_flags = msg_flags;
+  sqe->user_data = reinterpret_cast<uint64_t>(op) | kOpBit;
+  if (!reaping || atomic::acquire_load32(&waiter_blocked) != 0) {
+    atomic::store32(&flush_pending, 1);
+  }
+}
+
+// Caller holds cq_mu.
+G* Reap() {
+  if (!rearm_backlog.empty()) {
+    std::vector<PollDescriptor*> backlog;
+    backlog.swap(rearm_backlog);
+    for (PollDescriptor* pd : backlog) {
+      RearmOrRelease(pd, 0);
+    }
+  }
+  G* gp = nullptr;
+  while (io_uring_cqe* cqe = ring->PeekCqe()) {
+    uint64_t ud = cqe->user_data;
+    int32_t res = cqe->res;
+    uint32_t flags = cqe->flags;
+    ring->CqAdvance(1);
+
+    if (ud < kTagMax) {
+      if (ud == kTagBreak) {
+        atomic::store32(&break_pending, 0);
+      }
+      continue;  // timeouts, removes and cancels carry no G
+    }
+    if ((ud & kOpBit) != 0) {
+      CompleteOp(&gp, reinterpret_cast<UringOp*>(ud & ~kOpBit), res);
+      continue;
+    }
+    PollDescriptor* pd = reinterpret_cast<PollDescriptor*>(ud);
+    int mode = 0;
+    if (res > 0) {
+      if ((res & (POLLIN | POLLRDHUP | POLLHUP | POLLERR)) != 0) {
+        mode += 'r';
+      }
+      if ((res & (POLLOUT | POLLHUP | POLLERR)) != 0) {
+        mode += 'w';
+      }
+    }
+    if (mode != 0) {
+      NetPollReady(&gp, pd, mode);
+    }
+    if ((flags & IORING_CQE_F_MORE) == 0) {
+      RearmOrRelease(pd, res);
+    }
+  }
+  return gp;
+}
+
+}  // namespace
+
+bool UringNetPollInit() {
+  IoUring* r = new IoUring;
+  int err = r->Init(kSqEntries, kCqEntries);
+  if (err != 0) {
+    LOG(WARNING) << "io_uring_setup failed: " << err;
+    delete r;
+    return false;
+  }
+  // Multishot poll landed in 5.13 together with IORING_FEAT_RSRC_TAGS;
+  // NODROP keeps multishot CQEs from being lost on CQ overflow.
+  uint32_t need = IORING_FEAT_RSRC_TAGS | IORING_FEAT_NODROP;
+  if ((r->Features() & need) != need) {
+    LOG(WARNING) << "io_uring lacks multishot poll support";
+    delete r;
+    return false;
+  }
+  ring = r;
+  atomic::store32(&uring_active, 1);
+  return true;
+}
+
+bool UringNetPollActive() {
+  return atomic::acquire_load32(&uring_active) != 0;
+}
+
+// Runs once the runtime is shutting down, possibly while some M is still
+// asleep in UringNetPoll. Entry points that already saw the backend
+// active find the ring closed once they hold its lock, and back out.
+// Descriptors still registered are not released: their polls die with
+// the ring.
+void UringNetPollDeinit() {
+  if (atomic::exchange32(&uring_active, 0) == 0) {
+    return;
+  }
+  // A reaper asleep in the kernel holds cq_mu; the NOP gets it out.
+  // With no SQE to be had the CQ is full, and no reaper sleeps.
+  LockFromAnyThread(&sq_mu);
+  if (atomic::cas32(&break_pending, 0, 1)) {
+    io_uring_sqe* sqe = TryGetSqeLocked();
+    if (sqe != nullptr) {
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = kTagBreak;
+      SubmitLocked();
+    }
+  }
+  sq_mu.Unlock();
+  LockFromAnyThread(&cq_mu);
+  rearm_backlog.clear();
+  LockFromAnyThread(&sq_mu);
+  ring->Close();
+  sq_mu.Unlock();
+  cq_mu.Unlock();
+}
+
+int32_t UringNetPollOpen(uintptr_t fd, PollDescriptor* pd) {
+  // Held by the armed poll request; dropped on its final CQE.
+  pd->AddRef();
+  RawMutexGuard guard(&sq_mu);
+  io_uring_sqe* sqe = GetSqeLocked();
+  if (sqe == nullptr) {
+    pd->Release();
+    return EBADF;
+  }
+  PrepPollMultishot(sqe, fd, pd);
+  if (atomic::acquire_load32(&waiter_blocked) != 0) {
+    SubmitLocked();
+  }
+  return 0;
+}
+
+int32_t UringNetPollClose(uintptr_t fd, PollDescriptor* pd) {
+  RawMutexGuard guard(&sq_mu);
+  io_uring_sqe* sqe = GetSqeLocked();
+  if (sqe == nullptr) {
+    return 0;
+  }
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(pd);
+  sqe->user_data = kTagRemove;
+  // Not batched: an armed poll pins the file, so the socket would outlive
+  // close(fd) until the remove reaches the kernel.
+  SubmitLocked();
+  return 0;
+}
+
+void UringSubmitRecv(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                     void* buf, uint32_t len) {
+  QueueOp(op, pd, 'r', IORING_OP_RECV, fd, buf, len, 0, 0);
+}
+
+void UringSubmitSend(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                     const void* buf, uint32_t len) {
+  // EPIPE is reported through res either way; MSG_NOSIGNAL keeps the
+  // kernel from raising SIGPIPE on an io-wq worker's behalf.
+  QueueOp(op, pd, 'w', IORING_OP_SEND, fd, buf, len, 0, MSG_NOSIGNAL);
+}
+
+void UringSubmitRead(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                     void* buf, uint32_t len, int64_t offset) {
+  QueueOp(op, pd, 'r', IORING_OP_READ, fd, buf, len, offset, 0);
+}
+
+void UringSubmitWrite(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                      const void* buf, uint32_t len, int64_t offset) {
+  QueueOp(op, pd, 'r', IORING_OP_WRITE, fd, buf, len, offset, 0);
+}
+
+void UringSubmitFsync(UringOp* op, PollDescriptor* pd, uintptr_t fd) {
+  QueueOp(op, pd, 'r', IORING_OP_FSYNC, fd, nullptr, 0, 0, 0);
+}
+
+void UringNetPollFlush() {
+  if (atomic::acquire_load32(&flush_pending) == 0) {
+    return;
+  }
+  RawMutexGuard guard(&sq_mu);
+  if (!ring->Inited() ||
+      (reaping && atomic::acquire_load32(&waiter_blocked) == 0)) {
+    // An awake reaper submits on its way out.
+    return;
+  }
+  atomic::store32(&flush_pending, 0);
+  if (!SubmitLocked()) {
+    // The next reaper drains the overflow and submits.
+    atomic::store32(&flush_pending, 1);
+  }
+}
+
+void UringCancel(UringOp* op) {
+  RawMutexGuard guard(&sq_mu);
+  io_uring_sqe* sqe = GetSqeLocked();
+  if (sqe == nullptr) {
+    // Closing the ring cancelled everything in flight.
+    return;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(op) | kOpBit;
+  sqe->user_data = kTagCancel;
+  SubmitLocked();
+}
+
+bool UringOpDone(UringOp* op) {
+  return atomic::acquire_load32(&op->done) != 0;
+}
+
+void UringNetPollBreak() {
+  if (!atomic::cas32(&break_pending, 0, 1)) {
+    return;
+  }
+  RawMutexGuard guard(&sq_mu);
+  if (!ring->Inited()) {
+    return;
+  }
+  // Callers may hold the scheduler lock, so no draining here. A full SQ
+  // means a full CQ, which no reaper sleeps through anyway.
+  io_uring_sqe* sqe = TryGetSqeLocked();
+  if (sqe == nullptr) {
+    atomic::store32(&break_pending, 0);
+    return;
+  }
+  sqe->opcode = IORING_OP_NOP;
+  sqe->user_data = kTagBreak;
+  SubmitLocked();
+}
+
+// Same contract as the epoll NetPoll: delay_ns < 0 blocks, 0 polls, > 0
+// blocks at most delay_ns. The timeout is a count=1 IORING_OP_TIMEOUT, so
+// it has nanosecond resolution (epoll_wait rounds sub-ms sleeps up to
+// 1ms) and completes on its own as soon as any other CQE is posted,
+// leaving no stale kernel timer behind.
+G* UringNetPoll(int64_t delay_ns) {
+  if (delay_ns == 0) {
+    // Another M is reaping (possibly asleep in the kernel); it will hand
+    // out whatever completes.
+    if (!cq_mu.TryLock()) {
+      return nullptr;
+    }
+  } else {
+    cq_mu.Lock();
+  }
+  if (!ring->Inited()) {
+    cq_mu.Unlock();
+    return nullptr;
+  }
+
+  bool wait = false;
+  {
+    RawMutexGuard guard(&sq_mu);
+    wait = delay_ns != 0 && !ring->CqReady();
+    if (wait && delay_ns > 0) {
+      io_uring_sqe* sqe = TryGetSqeLocked();
+      if (sqe != nullptr) {
+        reap_timeout.tv_sec = delay_ns / 1000000000;
+        reap_timeout.tv_nsec = delay_ns % 1000000000;
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<uint64_t>(&reap_timeout);
+        sqe->len = 1;
+        sqe->off = 1;  // also complete after one other CQE
+        sqe->user_data = kTagTimeout;
+      } else {
+        wait = false;
+      }
+    }
+    reaping = true;
+    // One enter publishes every registration queued since the last poll.
+    // An overflow backlog refuses it; then drain rather than sleep.
+    if (!SubmitLocked()) {
+      wait = false;
+    }
+    if (wait) {
+      atomic::store32(&waiter_blocked, 1);
+    }
+  }
+  if (wait || ring->CqOverflow()) {
+    int ret = ring->Wait(wait ? 1 : 0);
+    if (ret < 0 && ret != -EINTR && ret != -ETIME && ret != -EBUSY) {
+      LOG(FATAL) << "io_uring_enter wait failed: " << -ret;
+    }
+    atomic::store32(&waiter_blocked, 0);
+  }
+
+  G* gp = Reap();
+  // File ops queued after the enter above count on this one. While the
+  // kernel still holds overflowed completions it refuses them, and only
+  // the holder of cq_mu can drain those.
+  sq_mu.Lock();
+  reaping = false;
+  atomic::store32(&flush_pending, 0);
+  while (!SubmitLocked()) {
+    sq_mu.Unlock();
+    ring->Wait(0);
+    G* more = Reap();
+    if (more != nullptr) {
+      sched->InjectGList(more);
+    }
+    sq_mu.Lock();
+  }
+  sq_mu.Unlock();
+  cq_mu.Unlock();
+  return gp;
+}
+
+}  // namespace tin::runtime
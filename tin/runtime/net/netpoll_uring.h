@@ -0,0 +1,82 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TIN_RUNTIME_NET_NETPOLL_URING_H_
+#define TIN_RUNTIME_NET_NETPOLL_URING_H_
+#include <cstdint>
+
+#include "tin/runtime/net/poll_descriptor.h"
+
+namespace tin::runtime {
+
+// io_uring netpoll backend (Linux, Config::SetNetPoller(kIoUring)).
+// netpoll_epoll.cc forwards every NetPoll* entry point here once
+// UringNetPollInit() has succeeded; the contract (PollDescriptor,
+// NetPollReady, NetPollBreak) is the same as for epoll.
+
+// Returns false (and leaves the backend inactive) if the kernel lacks
+// io_uring or multishot poll support.
+bool UringNetPollInit();
+
+// True once UringNetPollInit() succeeded, until UringNetPollDeinit().
+bool UringNetPollActive();
+
+// Unmaps the rings and closes the ring fd. Called from NetPollDeinit at
+// runtime shutdown; Ms still inside the backend may race with it.
+void UringNetPollDeinit();
+
+int32_t UringNetPollOpen(uintptr_t fd, PollDescriptor* pd);
+
+int32_t UringNetPollClose(uintptr_t fd, PollDescriptor* pd);
+
+G* UringNetPoll(int64_t delay_ns);
+
+void UringNetPollBreak();
+
+// A completion-based socket transfer (IORING_OP_RECV/SEND). The op lives
+// on the issuer's stack and must not go away before UringOpDone(). Its
+// completion is reported as readiness on pd (NetPollReady), so the issuer
+// parks through PollDesc::Wait and deadlines or Close interrupt it the
+// usual way; after an interrupt the issuer cancels and waits out the op.
+// Ops are queued rather than submitted: an awake reaper or the issuer's
+// park (UringNetPollFlush) hands them to the kernel, see netpoll_uring.cc.
+struct UringOp {
+  PollDescriptor* pd;
+  int32_t mode;
+  int32_t res;  // bytes transferred or -errno, valid once done
+  uint32_t done;
+};
+
+void UringSubmitRecv(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                     void* buf, uint32_t len);
+
+void UringSubmitSend(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                     const void* buf, uint32_t len);
+
+// Positional file transfers and fsync (IORING_OP_READ/WRITE/FSYNC) for
+// tin::os::File. pd belongs to the issuer alone and is not registered with
+// the poller; the completion readies it in mode 'r', so the issuer waits
+// with pollops::WaitCanceled. offset -1 means the file position. Queued
+// like the socket transfers.
+void UringSubmitRead(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                     void* buf, uint32_t len, int64_t offset);
+
+void UringSubmitWrite(UringOp* op, PollDescriptor* pd, uintptr_t fd,
+                      const void* buf, uint32_t len, int64_t offset);
+
+void UringSubmitFsync(UringOp* op, PollDescriptor* pd, uintptr_t fd);
+
+// Requests cancellation; the op still completes (with -ECANCELED, or with
+// its result if it had already finished).
+void UringCancel(UringOp* op);
+
+bool UringOpDone(UringOp* op);
+
+// Submits the queued ops unless an awake reaper will. Called by every G
+// committing to park in NetPollBlock, so an issuer never sleeps on an op
+// that has not reached the kernel.
+void UringNetPollFlush();
+
+}  // namespace tin::runtime
+#endif  // TIN_RUNTIME_NET_NETPOLL_URING_H_
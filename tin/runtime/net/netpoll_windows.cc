@@ -61,7 +61,7 @@ int32_t NetPollOpen(uintptr_t fd, PollDescriptor* pd) {
   return 0;
 }
 
-int32_t NetPollClose(uintptr_t fd) {
+int32_t NetPollClose(uintptr_t fd, PollDescriptor* pd) {
   // nothing to do
   return 0;
 }
@@ -90,6 +90,14 @@ void handlecompletion(G** gpp, NetOP* op, DWORD error_no, uint32_t qty) {
   NetPollReady(gpp, op->pd, mode);
 }
 
+bool NetPollSharded() {
+  return false;
+}
+
+G* NetPollLocal(int id) {
+  return nullptr;
+}
+
 // Go 1.15 netpoll_windows.go equivalent.
 // IOCP natively supports timeouts via GetQueuedCompletionStatusEx.
 G* NetPoll(int64_t delay_ns) {
@@ -15,6 +15,7 @@ PollDescriptor::PollDescriptor() {
   wg = 0;
   wd = 0;
   user = 0;
+  shard = -1;
 }
 
 }  // namespace tin::runtime
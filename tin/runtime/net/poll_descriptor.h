@@ -60,6 +60,8 @@ class RefCountedThreadSafe
   int64_t wd;
 
   uint32_t user;
+  // Sharded epoll: index of the per-P set fd is registered in, else -1.
+  int32_t shard;
 
 };
 
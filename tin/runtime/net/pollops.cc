@@ -61,7 +61,7 @@ void Close(PollDescriptor* pd) {
   if (pd->rg != 0 && pd->rg != kPdReady) {
     LOG(FATAL) << "netpollOpen: blocked read on closing descriptor";
   }
-  NetPollClose(pd->fd);
+  NetPollClose(pd->fd, pd);
   pd->Release();
 }
 
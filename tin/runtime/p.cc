@@ -26,12 +26,18 @@ P::P(int id)
   , sched_tick_(0)
   , syscalltick_(0)
   , sysmontick_(0)
-  , m_(nullptr) {
+  , m_(nullptr)
+  , no_steal_(false)
+  , overflow_head_(nullptr)
+  , overflow_tail_(nullptr)
+  , inbox_head_(0)
+  , inbox_tail_(nullptr) {
   runq_head_ = runq_tail_ = 0;
 }
 
 bool P::RunqEmpty() {
-  return runq_head_ == runq_tail_ && run_next_.Integer() == 0;
+  return runq_head_ == runq_tail_ && run_next_.Integer() == 0 &&
+         overflow_head_.load(std::memory_order_relaxed) == nullptr;
 }
 
 void P::RunqPut(G* gp, bool next) {
@@ -47,6 +53,12 @@ void P::RunqPut(G* gp, bool next) {
     gp = GpCastBack(oldnext);
   }
 
+  // Keep FIFO order while older Gs wait in the overflow list.
+  if (overflow_head_.load(std::memory_order_relaxed) != nullptr) {
+    OverflowPut(gp, gp);
+    return;
+  }
+
   while (true) {
     uint32_t h = atomic::acquire_load32(&runq_head_);
     uint32_t t = atomic::acquire_load32(&runq_tail_);
@@ -57,12 +69,87 @@ void P::RunqPut(G* gp, bool next) {
       atomic::release_store32(&runq_tail_, t + 1);
       return;
     }
+    if (no_steal_) {
+      OverflowPut(gp, gp);
+      return;
+    }
     if (RunqPutSlow(gp, h, t)) {
       return;
     }
   }
 }
 
+void P::OverflowPut(G* ghead, G* gtail) {
+  gtail->SetSchedLink(nullptr);
+  if (overflow_tail_ != nullptr) {
+    overflow_tail_->SetSchedLink(ghead);
+  } else {
+    overflow_head_.store(ghead, std::memory_order_relaxed);
+  }
+  overflow_tail_ = gtail;
+}
+
+void P::InboxPut(G* gp) {
+  RawMutexGuard guard(&inbox_lock_);
+  gp->SetSchedLink(nullptr);
+  if (inbox_tail_ != nullptr) {
+    inbox_tail_->SetSchedLink(gp);
+  } else {
+    atomic::release_store(&inbox_head_, reinterpret_cast<uintptr_t>(gp));
+  }
+  inbox_tail_ = gp;
+}
+
+void P::InboxDrain() {
+  G* glist = nullptr;
+  {
+    RawMutexGuard guard(&inbox_lock_);
+    glist = reinterpret_cast<G*>(inbox_head_);
+    atomic::release_store(&inbox_head_, 0);
+    inbox_tail_ = nullptr;
+  }
+  if (glist != nullptr) {
+    RunqPutBatch(glist);
+  }
+}
+
+// Go 1.16 proc.go:runqputbatch. Executed only by the owner P.
+void P::RunqPutBatch(G* glist) {
+  if (overflow_head_.load(std::memory_order_relaxed) != nullptr) {
+    G* gtail = glist;
+    while (gtail->SchedLink() != 0) {
+      gtail = GpCastBack(gtail->SchedLink());
+    }
+    OverflowPut(glist, gtail);
+    return;
+  }
+  uint32_t h = atomic::acquire_load32(&runq_head_);
+  uint32_t t = runq_tail_;
+  while (glist != nullptr && t - h < static_cast<uint32_t>(kRunqCapacity)) {
+    G* gp = glist;
+    glist = GpCastBack(gp->SchedLink());
+    runq_[t % static_cast<uint32_t>(kRunqCapacity)] = gp;
+    t++;
+  }
+  // store-release, makes the items available for consumption
+  atomic::release_store32(&runq_tail_, t);
+  if (glist == nullptr) {
+    return;
+  }
+  G* gtail = glist;
+  int32_t n = 1;
+  while (gtail->SchedLink() != 0) {
+    gtail = GpCastBack(gtail->SchedLink());
+    n++;
+  }
+  if (no_steal_) {
+    OverflowPut(glist, gtail);
+    return;
+  }
+  SchedulerLocker guard;
+  sched->GlobalRunqBatch(glist, gtail, n);
+}
+
 G* P::RunqGet(bool* inherit_time) {
   // If there's a runnext, it's the next G to run.
   while (true) {
@@ -84,7 +171,15 @@ G* P::RunqGet(bool* inherit_time) {
     if (t == h) {
       if (inherit_time != nullptr)
         *inherit_time = false;
-      return nullptr;
+      G* gp = overflow_head_.load(std::memory_order_relaxed);
+      if (gp != nullptr) {
+        G* next = GpCastBack(gp->SchedLink());
+        overflow_head_.store(next, std::memory_order_relaxed);
+        if (next == nullptr) {
+          overflow_tail_ = nullptr;
+        }
+      }
+      return gp;
     }
     G* gp = runq_[h % static_cast<uint32_t>(kRunqCapacity)].Pointer();
     // cas-release, commits consume
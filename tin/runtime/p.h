@@ -7,9 +7,11 @@
 #include <atomic>
 #include <vector>
 
+#include "tin/sync/atomic.h"
 #include "tin/runtime/util.h"
 #include "tin/runtime/guintptr.h"
 #include "tin/runtime/raw_mutex.h"
+#include "tin/runtime/buffer_pool.h"
 #include "tin/runtime/timer/timer_queue.h"
 
 namespace tin::runtime {
@@ -71,6 +73,10 @@ class P {
 
   void RunqPut(G* gp, bool next);
 
+  // Puts every G of glist (linked through SchedLink) on the local runq
+  // with a single tail publish; what does not fit goes to the global runq.
+  void RunqPutBatch(G* glist);
+
   G* RunqGet(bool* inherit_time = nullptr);
 
   G* RunqSteal(P* p2, bool steal_nextg);
@@ -137,6 +143,22 @@ class P {
   Sudog* AcquireSudogFromCache();
   void ReleaseSudogToCache(Sudog* s);
 
+  // ---- Per-P I/O buffer cache (buffer_pool.h) ----
+  BufferCache* GetBufferCache() { return &buffer_cache_; }
+
+  // ---- Thread-per-core (Config::SetNoStealProcs) ----
+  // A no-steal P never steals and is never stolen from. Its runq overflows
+  // into a private list instead of the global runq.
+  bool NoSteal() const { return no_steal_; }
+  void SetNoSteal(bool no_steal) { no_steal_ = no_steal; }
+
+  // Hands gp to this P from any thread. The owner moves it to its runq on
+  // its next scheduling round (see Scheduler::WakeP).
+  void InboxPut(G* gp);
+  bool InboxEmpty() const { return atomic::acquire_load(&inbox_head_) == 0; }
+  // Owner only.
+  void InboxDrain();
+
   // ---- Per-P goid cache (Go 1.15 runtime2.go:582-583) ----
   // Batch-allocates goroutine IDs to reduce contention on the global
   // counter. When goidcache_ >= goidcacheend_, refills a batch of 16
@@ -145,6 +167,7 @@ class P {
 
  private:
   bool RunqPutSlow(G* gp, uint32_t h, uint32_t t);
+  void OverflowPut(G* ghead, G* gtail);
   uint32_t RunqGrab(GUintptr* batch, int batch_size, uint32_t batch_head,
                   bool steal_nextg);
 
@@ -164,6 +187,14 @@ class P {
   uint32_t sysmontick_;    // Go 1.15 runtime2.go:572
   tin::runtime::M* m_;
 
+  bool no_steal_;
+  // Written by the owner only; RunqEmpty reads the head from any thread.
+  std::atomic<G*> overflow_head_;
+  G* overflow_tail_;  // owner only
+  RawMutex inbox_lock_;
+  uintptr_t inbox_head_;
+  G* inbox_tail_;
+
   // ---- Per-P Timer fields ----
   RawMutex timers_lock_;
   std::vector<Timer*> timers_;
@@ -176,6 +207,8 @@ class P {
   Sudog* sudogcache_[kSudogCacheSize] = {};
   int sudogcache_len_ = 0;
 
+  BufferCache buffer_cache_;
+
   // ---- Per-P goid cache (Go 1.15 runtime2.go:582-583) ----
   int64_t goidcache_ = 0;     // next available goid
   int64_t goidcacheend_ = 0;  // upper bound of current batch
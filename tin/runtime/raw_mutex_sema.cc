@@ -204,8 +204,7 @@ bool Note::TimedSleep(int64_t ns) {
     LOG(FATAL) << "TimedSleep on g0";
   }
   GetM()->EnsureSemaphoreExists();
-  SleepInternal(ns);
-  return true;
+  return SleepInternal(ns);
 }
 
 bool Note::TimedSleepG(int64_t ns) {
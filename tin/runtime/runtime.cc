@@ -5,6 +5,9 @@
 #include <absl/log/log.h>
 #include <absl/log/check.h>
 
+#include <exception>
+#include <functional>
+
 
 #include "tin/error/error.h"
 #include "tin/runtime/util.h"
@@ -12,6 +15,7 @@
 #include "tin/runtime/m.h"
 #include "tin/runtime/p.h"
 #include "tin/runtime/scheduler.h"
+#include "tin/runtime/threadpoll.h"
 #include "tin/runtime/timer/timer_queue.h"
 
 #include "tin/runtime/runtime.h"
@@ -93,6 +97,40 @@ void Sched() {
   tin::runtime::InternalYield();
 }
 
+namespace {
+
+class BlockingWork : public runtime::CoroWork {
+ public:
+  explicit BlockingWork(std::function<void()>* closure)
+    : closure_(closure) {
+  }
+
+  void Run() override {
+    try {
+      (*closure_)();
+    } catch (...) {
+      exception_ = std::current_exception();
+    }
+    Finalize();
+  }
+
+  std::exception_ptr exception() const { return exception_; }
+
+ private:
+  std::function<void()>* closure_;
+  std::exception_ptr exception_;
+};
+
+}  // namespace
+
+void BlockingClosure(std::function<void()> closure) {
+  BlockingWork work(&closure);
+  runtime::SubmitCoroWork(&work);
+  if (work.exception()) {
+    std::rethrow_exception(work.exception());
+  }
+}
+
 void NanoSleep(int64_t ns) {
   return tin::runtime::InternalNanoSleep(ns);
 }
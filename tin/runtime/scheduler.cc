@@ -30,6 +30,22 @@ bool ShouldStealTimers(P* p2) {
   return p2->GetStatus() != kPrunning;
 }
 
+// Sharded netpoll: Gs woken from a P's poll set stay on the P that polled
+// it. The first one is returned to run next, the rest go to p's runq
+// (RunqPut spills to the global queue when it is full).
+G* RunqPutPolled(P* p, G* glist) {
+  G* gp = glist;
+  glist = GpCastBack(gp->SchedLink());
+  gp->SetState(CoroutineState::kRunnable);
+  while (glist != nullptr) {
+    G* next = GpCastBack(glist->SchedLink());
+    glist->SetState(CoroutineState::kRunnable);
+    p->RunqPut(glist, false);
+    glist = next;
+  }
+  return gp;
+}
+
 // Go 1.15 proc.go:2289-2336 — stealOrder deterministic traversal.
 // Instead of rand()%MaxProcs (which may revisit the same P multiple times
 // and skip others), stealOrder visits every P exactly once per round in
@@ -76,7 +92,8 @@ Scheduler::Scheduler()
   , nr_idlem_locked_(0)
   , mcount_(0)
   , max_mcount_(10000)
-  , last_poll_(0) {
+  , last_poll_(0)
+  , sysmon_wake_(0) {
   last_poll_ = static_cast<uint32_t>(MonoNow() / tin::kMillisecond);
   if (last_poll_ == 0)
     last_poll_ = 1;
@@ -109,6 +126,7 @@ P* Scheduler::ResizeProc(int nprocs) {
       atomic::store(reinterpret_cast<uintptr_t*>(&allp_[i]),
                     reinterpret_cast<uintptr_t>(pp));
     }
+    pp->SetNoSteal(i < rtm_conf->NoStealProcs());
   }
 
   for (int i = nprocs; i < old; i++) {
@@ -249,6 +267,7 @@ G* Scheduler::GlobalRunqGet(P* p, int32_t maximum) {
 }
 
 void Scheduler::InjectGList(G* glist) {
+  glist = SendHome(glist, GetP());
   if (glist == nullptr) {
     return;
   }
@@ -279,10 +298,21 @@ void Scheduler::PIdlePut(P* p) {
   atomic::relaxed_inc32(&nr_idlep_, 1);
 }
 
-P* Scheduler::PIdleGet() {
+P* Scheduler::PIdleGet(int32_t home) {
+  // A no-steal P running a G with no home there would leave everything
+  // that G spawns on a run queue no other P may steal from.
+  P* prev = nullptr;
   P* p = idlep_;
+  while (p != nullptr && p->NoSteal() && p->Id() != home) {
+    prev = p;
+    p = p->Link();
+  }
   if (p != nullptr) {
-    idlep_ = p->Link();
+    if (prev != nullptr) {
+      prev->SetLink(p->Link());
+    } else {
+      idlep_ = p->Link();
+    }
     atomic::relaxed_inc32(&nr_idlep_, -1);
     if (!p->RunqEmpty()) {
       LOG(FATAL) << "pidleput: P has non-empty run queue";
@@ -291,6 +321,73 @@ P* Scheduler::PIdleGet() {
   return p;
 }
 
+// Take p off the _Pidle list.
+// Sched must be locked.
+bool Scheduler::PIdleRemove(P* p) {
+  P* prev = nullptr;
+  for (P* it = idlep_; it != nullptr; prev = it, it = it->Link()) {
+    if (it != p) {
+      continue;
+    }
+    if (prev != nullptr) {
+      prev->SetLink(p->Link());
+    } else {
+      idlep_ = p->Link();
+    }
+    atomic::relaxed_inc32(&nr_idlep_, -1);
+    return true;
+  }
+  return false;
+}
+
+// Starts p if it is idle so that it picks up the Gs just put in its
+// inbox. A running P drains its inbox on its next scheduling round, and
+// FindRunnable re-checks the inbox under lock_ before idling the P.
+void Scheduler::WakeP(P* p) {
+  {
+    RawMutexGuard guard(&lock_);
+    if (p->GetStatus() != kPidle || !PIdleRemove(p)) {
+      return;
+    }
+  }
+  StartM(p, false);
+}
+
+// Thread-per-core: a G homed on a no-steal P (Coroutine::HomeP) is sent
+// back to that P's inbox wherever it was woken. Returns the remaining Gs
+// of glist, in order; curp may be nullptr.
+G* Scheduler::SendHome(G* glist, P* curp) {
+  if (rtm_conf->NoStealProcs() == 0) {
+    return glist;
+  }
+  G* head = nullptr;
+  G* tail = nullptr;
+  while (glist != nullptr) {
+    G* gp = glist;
+    glist = GpCastBack(gp->SchedLink());
+    int32_t home = gp->HomeP();
+    if (home >= 0 && (curp == nullptr || home != curp->Id())) {
+      PutHome(gp);
+      continue;
+    }
+    gp->SetSchedLink(nullptr);
+    if (tail != nullptr) {
+      tail->SetSchedLink(gp);
+    } else {
+      head = gp;
+    }
+    tail = gp;
+  }
+  return head;
+}
+
+void Scheduler::PutHome(G* gp) {
+  gp->SetState(CoroutineState::kRunnable);
+  P* p = Allp()[gp->HomeP()];
+  p->InboxPut(gp);
+  WakeP(p);
+}
+
 G* Scheduler::FindRunnable(bool* inherit_time) {
   G* curg = GetG();
   M* curm = curg->M();
@@ -324,6 +421,9 @@ top:
     }
   }
 
+  if (!curp->InboxEmpty()) {
+    curp->InboxDrain();
+  }
   G* gp = curp->RunqGet(inherit_time);
   if (gp != nullptr) {
     return gp;
@@ -342,16 +442,32 @@ top:
 
   // Go 1.15 proc.go:2888-2897 — non-blocking NetPoll, but only if there
   // are netpoll waiters and the scheduler hasn't polled recently.
+  // With a sharded netpoll only our own set is polled here; other sets
+  // are left to their Ps, to stealing below and to the blocking poll.
   if (NetPollInited() && last_poll_ != 0 && NetPollWaiters() > 0) {
-    gp = NetPoll(0);
-    if (gp != 0) {
-      InjectGList(GpCastBack(gp->SchedLink()));
-      gp->SetState(CoroutineState::kRunnable);
-      *inherit_time = false;
-      return gp;
+    if (NetPollSharded()) {
+      gp = SendHome(NetPollLocal(curp->Id()), curp);
+      if (gp != nullptr) {
+        *inherit_time = false;
+        return RunqPutPolled(curp, gp);
+      }
+    } else {
+      gp = SendHome(NetPoll(0), curp);
+      if (gp != 0) {
+        InjectGList(GpCastBack(gp->SchedLink()));
+        gp->SetState(CoroutineState::kRunnable);
+        *inherit_time = false;
+        return gp;
+      }
     }
   }
 
+  // A no-steal P neither steals nor spins: its work arrives through its
+  // own runq, its inbox and its own netpoll set.
+  if (curp->NoSteal()) {
+    goto stop;
+  }
+
   // If number of spinning M's >= number of busy P's, block.
   // This is necessary to prevent excessive CPU consumption
   // when GOMAXPROCS>>1 but the program parallelism is low.
@@ -375,7 +491,7 @@ top:
              curm->Fastrand());
     while (!so.Done()) {
       P* p = Allp()[so.Next()];
-      if (p == nullptr)
+      if (p == nullptr || (p != curp && p->NoSteal()))
         continue;
       if (p == curp) {
         gp = p->RunqGet();
@@ -394,6 +510,14 @@ top:
             gp = curp->RunqGet(inherit_time);
           }
         }
+        // Likewise fall back to the victim's netpoll set.
+        if (gp == nullptr && round > 1 && NetPollSharded() &&
+            NetPollWaiters() > 0) {
+          gp = SendHome(NetPollLocal(p->Id()), curp);
+          if (gp != nullptr) {
+            gp = RunqPutPolled(curp, gp);
+          }
+        }
       }
       if (gp != nullptr) {
         *inherit_time = false;
@@ -409,6 +533,10 @@ stop: {
       *inherit_time = false;
       return gp;
     }
+    // Pairs with WakeP: Gs sent here before we idle the P are ours.
+    if (!curp->InboxEmpty()) {
+      goto top;
+    }
 
     P* p = ReleaseP();
     PIdlePut(p);
@@ -422,9 +550,11 @@ stop: {
     }
   }
 
+  // Only Ps whose Gs can be stolen are worth waking up for; a no-steal
+  // P's owner finds its own work.
   for (int i = 0; i < rtm_conf->MaxProcs(); i++) {
     P* p = Allp()[i];
-    if (p != nullptr && !p->RunqEmpty()) {
+    if (p != nullptr && !p->NoSteal() && !p->RunqEmpty()) {
       {
         RawMutexGuard guard(&lock_);
         p = PIdleGet();
@@ -451,7 +581,7 @@ stop: {
         delta = 0;  // timer already expired, poll non-blocking
       }
     }
-    gp = NetPoll(delta);
+    gp = SendHome(NetPoll(delta), nullptr);
     uint32_t now = static_cast<uint32_t>(MonoNow() / tin::kMillisecond);
     if (now == 0)
       now = 1;
@@ -543,6 +673,9 @@ bool Scheduler::OneRoundSched(G* curg) {
     }
     // from local queue.
     if (nextg == nullptr) {
+      if (!p->InboxEmpty()) {
+        p->InboxDrain();
+      }
       nextg = p->RunqGet(&inherit_time);
       if (nextg != nullptr && curg->M()->GetSpinning()) {
         LOG(FATAL) << "schedule: spinning with local work";
@@ -616,7 +749,12 @@ void Scheduler::MakeReady(G* gp) {
   }
   gp->SetState(CoroutineState::kRunnable);
 
-  GetP()->RunqPut(gp, true);
+  P* p = GetP();
+  if (gp->HomeP() >= 0 && gp->HomeP() != p->Id()) {
+    PutHome(gp);
+    return;
+  }
+  p->RunqPut(gp, true);
 
   if (atomic::load32(&nr_idlep_) != 0 && atomic::load32(&nr_spinning_) == 0) {
     WakeupP();
@@ -649,7 +787,8 @@ void Scheduler::HandoffP(P* p) {
   // will idle it if the syscall runs too long (>10ms).
 
   // If P has local work, start a new M straight away.
-  if (!p->RunqEmpty() || sched->GlobalRunqSize() != 0) {
+  if (!p->RunqEmpty() || !p->InboxEmpty() ||
+      sched->GlobalRunqSize() != 0) {
     if (p->GetStatus() == kPsyscall &&
         !p->CasStatus(kPsyscall, kPidle)) {
       return;  // ExitSyscallFast reacquired P
@@ -719,7 +858,7 @@ void Scheduler::ExitSyscall0(G* gp) {
   P* p = nullptr;
   {
     RawMutexGuard guard(&lock_);
-    p = PIdleGet();
+    p = PIdleGet(gp->HomeP());
   }
 
   if (p != nullptr) {
@@ -766,7 +905,7 @@ bool Scheduler::ExitSyscallPIdle() {
   P* p = nullptr;
   {
     RawMutexGuard guard(&lock_);
-    p = PIdleGet();
+    p = PIdleGet(GetG()->HomeP());
   }
   if (p != nullptr) {
     AcquireP(p);
@@ -795,6 +934,38 @@ uint32_t Scheduler::LastPollTime() {
   return atomic::acquire_load32(&last_poll_);
 }
 
+// Go 1.15 proc.go:sysmon — sysmonwait is published under sched.lock.
+// sysmon arms before the pass that precedes a long park, so any event
+// that happens while it computes its deadline still wakes it (the Note
+// then returns immediately). While armed the deadline only moves earlier.
+void Scheduler::SysMonArm(int64_t until) {
+  SchedulerLocker guard;
+  int64_t wake = atomic::load64(&sysmon_wake_);
+  if (wake == 0 || until < wake) {
+    atomic::store64(&sysmon_wake_, until);
+  }
+}
+
+void Scheduler::SysMonSleep(int64_t ns) {
+  sysmon_note_.TimedSleep(ns);
+  SchedulerLocker guard;
+  atomic::store64(&sysmon_wake_, 0);
+  sysmon_note_.Clear();
+}
+
+// Go 1.15 proc.go:entersyscall_sysmon. The lock serializes wakers with
+// SysMonSleep's Clear, so a Note is never woken twice.
+void Scheduler::WakeSysmon(int64_t when) {
+  if (when >= atomic::acquire_load64(&sysmon_wake_)) {
+    return;
+  }
+  SchedulerLocker guard;
+  if (when < atomic::load64(&sysmon_wake_)) {
+    atomic::store64(&sysmon_wake_, 0);
+    sysmon_note_.Wakeup();
+  }
+}
+
 // Go 1.15 proc.go:4746-4813 — sysmon calls this to take back Ps stuck
 // in kPsyscall for too long. Returns the number of Ps retaken.
 //
@@ -955,6 +1126,9 @@ void EnterSyscallBlock() {
   // Go 1.15 runtime2.go:571 — increment syscalltick so sysmon retake
   // can detect long-running syscalls.
   p->IncSyscallTick();
+  // Go 1.15 proc.go:reentersyscall — sysmon may be parked with no
+  // retake check armed; wake it so this syscall gets observed.
+  sched->WakeSysmon();
   // Set P to kPsyscall (not kPidle) so:
   // 1. ExitSyscallFast can quickly reacquire it (syscall affinity)
   // 2. retake can take it back if the syscall runs too long (>10ms)
@@ -35,7 +35,11 @@ class Scheduler {
   }
 
   void PIdlePut(P* p);
-  P* PIdleGet();
+  // Takes an idle P that may run any G: no-steal Ps are skipped, except
+  // home, the no-steal P of the G about to run, if any. Other no-steal Ps
+  // are only started through WakeP. Sched must be locked.
+  P* PIdleGet(int32_t home = -1);
+  void WakeP(P* p);
 
   void MPut(M* m);
   M* MGet();
@@ -72,6 +76,16 @@ class Scheduler {
     return &last_poll_;
   }
 
+  // Go 1.15 proc.go sched.sysmonwait/sysmonnote. Before a long park
+  // sysmon publishes when it means to wake with SysMonArm (int64 max:
+  // never), then parks with SysMonSleep for up to ns (< 0: until woken).
+  // WakeSysmon(when) cuts the park short only if when is earlier than the
+  // published deadline; while nothing is published it returns after one
+  // load. WakeSysmon must not be called with the scheduler lock held.
+  void SysMonArm(int64_t until);
+  void SysMonSleep(int64_t ns);
+  void WakeSysmon(int64_t when = 0);
+
   // Public so per-P timer code (TimeSleepUntil) can iterate all P heaps.
   P** AllpPublic() { return allp_; }
 
@@ -80,6 +94,9 @@ class Scheduler {
   void DoUnlock(UnLockInfo* info);
   P** Allp() { return allp_;}
   P* ResizeProc(int nprocs);
+  bool PIdleRemove(P* p);
+  G* SendHome(G* glist, P* curp);
+  void PutHome(G* gp);
 
  private:
   RawMutex lock_;
@@ -99,6 +116,10 @@ class Scheduler {
 
   uint32_t last_poll_;
 
+  // Published sysmon deadline; 0 while sysmon is not armed.
+  int64_t sysmon_wake_;
+  Note sysmon_note_;
+
   P** allp_;
 
   friend class SchedulerLocker;
@@ -34,6 +34,10 @@ bool SemAcquire(uint32_t* addr);
 // without going through CanSemAcquire. (Go 1.15 sema.go:semrelease1)
 void SemRelease(uint32_t* addr, bool handoff = false);
 
+// CanSemAcquire takes one token from *addr without parking. Returns false
+// if the count is zero. Safe to call from g0 and timer callbacks.
+bool CanSemAcquire(uint32_t* addr);
+
 // AcquireSudog returns a Sudog from the per-P sudogcache, or allocates
 // a new one if the cache is empty. (Go 1.15 proc.go:acquireSudog)
 Sudog* AcquireSudog();
@@ -6,7 +6,6 @@
 #include <cstdint>
 #include <limits>
 
-#include <absl/time/clock.h>
 #include <absl/log/log.h>
 
 #include "tin/sync/atomic.h"
@@ -15,6 +14,7 @@
 #include "tin/runtime/scheduler.h"
 #include "tin/runtime/p.h"
 #include "tin/runtime/env.h"
+#include "tin/runtime/buffer_pool.h"
 #include "tin/runtime/net/netpoll.h"
 #include "tin/runtime/timer/timer_queue.h"
 
@@ -54,6 +54,30 @@ void CheckDead() {
   // All checks failed — deadlock.
   LOG(FATAL) << "all goroutines are asleep - deadlock!";
 }
+
+// Go 1.15 sysmon polls on a 20us..10ms cadence. tin's sysmon instead
+// computes when it next has something to do and parks on a Note until
+// then (see Scheduler::SysMonSleep / WakeSysmon).
+const int64_t kSysmonMinDelay = 20 * tin::kMicrosecond;
+// Busy Ps still get a starvation/retake check at Go's 10ms max delay.
+const int64_t kSysmonMaxDelay = 10 * tin::kMillisecond;
+// Retake hands a P back after two observations of the same syscall.
+const int64_t kRetakeDelay = 10 * tin::kMillisecond;
+// Force a netpoll if the scheduler hasn't polled for this long (ms).
+const uint32_t kNetPollStarveMs = 10;
+// Expired timer nobody picked up yet: re-check after this long.
+const int64_t kTimerRecheckDelay = 1 * tin::kMillisecond;
+// How long the runtime must be completely quiet before CheckDead runs.
+const int64_t kCheckDeadDelay = 1 * tin::kSecond;
+
+bool AnyPInSyscall() {
+  int nprocs = rtm_conf->MaxProcs();
+  for (int i = 0; i < nprocs; i++) {
+    P* p = sched->AllpPublic()[i];
+    if (p != nullptr && p->GetStatus() == kPsyscall) return true;
+  }
+  return false;
+}
 }  // namespace
 
 // SysMon is the runtime watchdog. It runs on its own OS thread (no P
@@ -62,26 +86,24 @@ void CheckDead() {
 //   - waking up idle Ps when timers expire (per-P timer model)
 //   - retaking Ps stuck in long syscalls
 //   - detecting deadlocks (Go 1.15 checkdead)
+//   - trimming the I/O buffer pool
 //   - optional SCHEDTRACE debug output
+//
+// Each pass ends by parking until the earliest of: the next timer, the
+// next retake check (only while a P is in a syscall), the next netpoll
+// starvation check (only while Gs wait on the poller and nobody blocks in
+// it) and the next schedtrace. With all Ps idle and nothing pending it
+// parks indefinitely; EnterSyscallBlock and WakeNetPoller wake it early.
 void SysMon() {
-  uint32_t idle = 0;
-  uint32_t delay = 20 * 1000;  // 20ms initial (in microseconds)
-  const uint32_t kMaxDelayUs = 10 * 1000;  // 10ms cap
   int64_t last_schedtrace = 0;  // ms timestamp of last schedtrace output
+  int64_t quiet_since = 0;      // MonoNow() when the runtime went quiet
+  bool dead_checked = false;
+  bool armed = false;
+  const int64_t max_when = std::numeric_limits<int64_t>::max();
 
   while (!rtm_env->ExitFlag()) {
-    // Adaptive sleep.
-    if (idle == 0) {
-      delay = 20 * 1000;  // 20ms when busy
-    } else if (idle > 50) {
-      delay = std::min(delay * 2, kMaxDelayUs);
-    }
-    if (delay > kMaxDelayUs) {
-      delay = kMaxDelayUs;
-    }
-    absl::SleepFor(absl::Microseconds(delay));
-
     int64_t now = MonoNow();
+    int64_t wake = max_when;
 
     // --- SCHEDTRACE debug output (Go 1.15 proc.go:4875+)
     int trace_ms = rtm_env->schedtrace_ms();
@@ -91,6 +113,7 @@ void SysMon() {
         sched->SchedTrace(rtm_env->scheddetail());
         last_schedtrace = now_ms;
       }
+      wake = std::min(wake, (last_schedtrace + trace_ms) * tin::kMillisecond);
     }
 
     // --- Net poll: if the scheduler hasn't polled in the last 10ms, do
@@ -100,7 +123,8 @@ void SysMon() {
     if (now_ms == 0) {
       now_ms = 1;
     }
-    if (NetPollInited() && last_poll != 0 && (last_poll + 10 < now_ms)) {
+    if (NetPollInited() && last_poll != 0 &&
+        (last_poll + kNetPollStarveMs < now_ms)) {
       if (atomic::cas32(sched->MutableLastPollTime(), last_poll, now_ms)) {
         G* gp = NetPoll(0);
         if (gp != nullptr) {
@@ -108,43 +132,94 @@ void SysMon() {
         }
       }
     }
+    // last_poll == 0 means an M is blocked in NetPoll; no check needed.
+    if (NetPollInited() && NetPollWaiters() > 0) {
+      last_poll = sched->LastPollTime();
+      if (last_poll != 0) {
+        wake = std::min(wake, (static_cast<int64_t>(last_poll) +
+                               kNetPollStarveMs + 1) * tin::kMillisecond);
+      }
+    }
 
     // --- Per-P timer check: ask the heap for the earliest pending
     // deadline. If it has already expired and no P is awake to run it,
-    // wake an idle P. If it's pending soon, keep idle=0 so sysmon
-    // doesn't deepen its sleep.
+    // wake an idle P. Otherwise sleep until it is due.
     P* timer_pp = nullptr;
     int64_t next = TimeSleepUntil(&timer_pp);
-    int64_t max_when = std::numeric_limits<int64_t>::max();
     if (next != max_when) {
       if (next > now) {
-        // Timer pending. Stay responsive so we can wake a P in time.
-        idle = 0;
+        wake = std::min(wake, next);
       } else if (timer_pp != nullptr) {
         // Timer expired but apparently no P has run CheckTimers yet.
         // Wake one up (if any idle) so FindRunnable -> CheckTimers fires.
-        sched->WakeupP();
-        idle = 0;
+        // Timers of a no-steal P are never stolen; wake its owner.
+        if (timer_pp->NoSteal()) {
+          sched->WakeP(timer_pp);
+        } else {
+          sched->WakeupP();
+        }
+        wake = std::min(wake, now + kTimerRecheckDelay);
       }
-    } else {
-      idle++;
     }
 
     // --- Retake: take back Ps stuck in kPsyscall for too long
     // (Go 1.15 proc.go:4746-4813). EnterSyscallBlock sets P to
-    // kPsyscall; if the syscall runs longer than one sysmon cycle
-    // (~10ms), retake CASes it to kPidle and hands it off to a new M.
-    uint32_t retaken = sched->Retake(now);
-    if (retaken > 0) {
-      idle = 0;  // reset idle count — we did work
+    // kPsyscall; if the syscall is still running at the next check
+    // (kRetakeDelay later), retake CASes it to kPidle and hands it off
+    // to a new M.
+    sched->Retake(now);
+    if (AnyPInSyscall()) {
+      wake = std::min(wake, now + kRetakeDelay);
     }
 
-    // --- CheckDead: if idle for a long time and nothing is happening,
-    // check for deadlock (Go 1.15 proc.go:4503-4597).
+    // --- Buffer pool: return buffers idle for a whole trim period to the
+    // allocator; scheduled only while the depot holds any.
+    wake = std::min(wake, BufferPoolTrim(now));
+
     int nprocs = rtm_conf->MaxProcs();
-    if (idle > 100 && sched->NrIdleP() == static_cast<uint32_t>(nprocs)) {
-      CheckDead();
+    bool all_idle = sched->NrIdleP() == static_cast<uint32_t>(nprocs);
+    if (!all_idle) {
+      // Running Ps may hog the CPU without polling; keep Go's cadence.
+      wake = std::min(wake, now + kSysmonMaxDelay);
+      quiet_since = 0;
+      dead_checked = false;
+    } else if (wake == max_when) {
+      // --- CheckDead: once the runtime has been completely quiet for a
+      // while, check for deadlock (Go 1.15 proc.go:4503-4597), then park
+      // until something wakes us.
+      if (quiet_since == 0) {
+        quiet_since = now;
+      }
+      if (!dead_checked) {
+        if (now - quiet_since >= kCheckDeadDelay) {
+          CheckDead();
+          dead_checked = true;
+        } else {
+          wake = quiet_since + kCheckDeadDelay;
+        }
+      }
+    } else {
+      quiet_since = 0;
+      dead_checked = false;
+    }
+
+    int64_t sleep = -1;
+    if (wake != max_when) {
+      sleep = std::max(wake - now, kSysmonMinDelay);
+    }
+    // Short sleeps are not published: no waker has to wait longer than
+    // kSysmonMaxDelay for them to end. Before a longer park, publish the
+    // deadline and run the pass once more, so an event that raced the
+    // checks above is either seen by that pass or wakes us.
+    if (sleep < 0 || sleep > kSysmonMaxDelay) {
+      sched->SysMonArm(wake);
+      if (!armed) {
+        armed = true;
+        continue;
+      }
     }
+    armed = false;
+    sched->SysMonSleep(sleep);
   }
 }
 
@@ -4,6 +4,8 @@
 
 #include <absl/functional/bind_front.h>
 
+#include <algorithm>
+
 #include "tin/error/error.h"
 #include "tin/runtime/m.h"
 #include "tin/runtime/util.h"
@@ -42,9 +44,11 @@ void SubmitCoroWork(CoroWork* work) {
   SetErrorCode(TinTranslateSysError(work->LastError()));
 }
 
+// LastError is the worker's errno like for any work item; the
+// getaddrinfo return code travels in the work item itself.
 void SubmitGetAddrInfoCoroWork(CoroWork* work) {
   Park(SubmitCoroWorkUnlockF, work, nullptr);
-  SetErrorCode(TinGetaddrinfoTranslateError(work->LastError()));
+  SetErrorCode(TinTranslateSysError(work->LastError()));
 }
 
 absl::once_flag thread_pool_once;
@@ -59,63 +63,113 @@ ThreadPool* ThreadPool::GetInstance() {
 
 // ThreadPool implementation.
 ThreadPool::ThreadPool()
-  : num_threads_(64)
-  , dry_(false) {
+  : idle_(0)
+  , starting_(0)
+  , quit_(false) {
 }
 
 void ThreadPool::Start() {
-  for (int i = 0; i < num_threads_; ++i) {
-//    M* m = M::New(base::Bind(&ThreadPool::Run, base::Unretained(this)), nullptr);
-    M* m = M::New(absl::bind_front(&ThreadPool::Run, this), nullptr);
-    threads_.push_back(m);
-  }
+  absl::MutexLock guard(&lock_);
+  quit_ = false;
 }
 
 void ThreadPool::JoinAll() {
-  for (int i = 0; i < num_threads_; ++i) {
-    AddWork(nullptr);
+  std::vector<M*> threads;
+  {
+    absl::MutexLock guard(&lock_);
+    quit_ = true;
+    cond_.SignalAll();
+    threads.swap(threads_);
   }
-
   // Join and destroy all the worker threads.
-  for (int i = 0; i < num_threads_; ++i) {
-    threads_[i]->Join();
-    delete threads_[i];
+  for (M* m : threads) {
+    if (m != nullptr) {
+      m->Join();
+      delete m;
+    }
+  }
+  {
+    // A worker whose slot was reserved before quit_ lands in exited_ once
+    // M::New returns; wait for it so the reap below sees it.
+    absl::MutexLock guard(&lock_);
+    lock_.Await(absl::Condition(
+        +[](int* starting) { return *starting == 0; }, &starting_));
+  }
+  ReapExited();
+}
+
+void ThreadPool::ReapExited() {
+  std::vector<M*> exited;
+  {
+    absl::MutexLock guard(&lock_);
+    exited.swap(exited_);
+  }
+  for (M* m : exited) {
+    m->Join();
+    delete m;
   }
-  threads_.clear();
 }
 
 void ThreadPool::AddWork(Work* work) {
-  absl::MutexLock guard(&lock_);
-  tasks_.push_back(work);
-  // If we were empty, signal that we have work now.
-  if (!dry_.HasBeenNotified())
-    dry_.Notify();
+  bool grow = false;
+  bool reap = false;
+  {
+    absl::MutexLock guard(&lock_);
+    tasks_.push_back(work);
+    // No new workers once JoinAll started; the live ones drain tasks_.
+    if (!quit_ && static_cast<int>(tasks_.size()) > idle_ &&
+        static_cast<int>(threads_.size()) < kMaxThreads) {
+      grow = true;
+      // Reserve the slot now so concurrent callers do not overshoot.
+      threads_.push_back(nullptr);
+      starting_++;
+    } else {
+      cond_.Signal();
+    }
+    reap = !exited_.empty();
+  }
+  if (reap) {
+    ReapExited();
+  }
+  if (grow) {
+    M* m = M::New(absl::bind_front(&ThreadPool::Run, this), nullptr);
+    absl::MutexLock guard(&lock_);
+    auto it = std::find(threads_.begin(), threads_.end(), nullptr);
+    if (it != threads_.end()) {
+      *it = m;
+    } else {
+      // JoinAll ran meanwhile; m sees quit_ and returns.
+      exited_.push_back(m);
+    }
+    starting_--;
+  }
 }
 
-// consider replace with conditional variable.
 void ThreadPool::Run() {
-  Work* work = nullptr;
-
+  M* self = GetM();
   while (true) {
-    dry_.WaitForNotification();
+    Work* work = nullptr;
     {
       absl::MutexLock guard(&lock_);
-      if (!dry_.HasBeenNotified())
-        continue;
-
-      DCHECK(!tasks_.empty());
+      while (tasks_.empty() && !quit_) {
+        idle_++;
+        bool timed_out = cond_.WaitWithTimeout(
+            &lock_, absl::Seconds(kIdleTimeoutSeconds));
+        idle_--;
+        auto it = std::find(threads_.begin(), threads_.end(), self);
+        if (timed_out && tasks_.empty() && !quit_ && it != threads_.end()) {
+          // The next AddWork or JoinAll joins this thread.
+          threads_.erase(it);
+          exited_.push_back(self);
+          return;
+        }
+      }
+      if (tasks_.empty()) {
+        return;
+      }
       work = tasks_.front();
       tasks_.pop_front();
-
-      // Signal to any other threads that we're currently out of work.
-      if (tasks_.empty())
-        dry_.Notify(); // TODO
     }
-
-    // A nullptr delegate pointer signals us to quit.
-    if (!work)
-      break;
-
     work->Run();
   }
 }
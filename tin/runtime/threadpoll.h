@@ -8,7 +8,6 @@
 #include <vector>
 #include <deque>
 
-#include <absl/synchronization/notification.h>
 #include <absl/synchronization/mutex.h>
 #include <absl/base/call_once.h>
 
@@ -49,27 +48,38 @@ void SubmitCoroWork(CoroWork* work);
 void SubmitGetAddrInfoCoroWork(CoroWork* work);
 
 
+// Runs blocking work (getaddrinfo, tin::Blocking) off the Ps. Workers are
+// started on demand while more work is queued than there are idle workers,
+// up to kMaxThreads, and exit after kIdleTimeout without work.
 class ThreadPool {
  public:
-    ThreadPool(const ThreadPool&) = delete;
-    ThreadPool& operator=(const ThreadPool&) = delete;
+  static const int kMaxThreads = 64;
+  static const int kIdleTimeoutSeconds = 10;
 
-    static ThreadPool* GetInstance();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  static ThreadPool* GetInstance();
 
   void Start();
+  // Runs the queued work, then stops and joins every worker.
   void JoinAll();
   void AddWork(Work* work);
-  void Run();
 
-private:
-    ThreadPool();
  private:
-  int num_threads_;
-  std::vector<M*> threads_;
-  std::deque<Work*> tasks_;
-  absl::Mutex lock_;
+  ThreadPool();
+  void Run();
+  // Joins the workers that exited on their idle timeout.
+  void ReapExited();
 
-  absl::Notification dry_;
+  absl::Mutex lock_;
+  absl::CondVar cond_;
+  std::deque<Work*> tasks_;
+  std::vector<M*> threads_;  // live workers
+  std::vector<M*> exited_;   // idle workers that returned, to be joined
+  int idle_;
+  int starting_;  // reserved slots whose M::New has not returned
+  bool quit_;
 };
 
 }  // namespace tin::runtime
@@ -171,7 +171,6 @@ void WakeupSleeperFn(void* arg, uintptr_t seq) {
 }
 
 void WakeNetPoller(int64_t when) {
-  (void)when;
   // Go 1.15 time.go:resettimer — wake up any M blocked in NetPoll so
   // its epoll_wait/kevent/IOCP returns early and the scheduler loop
   // can pick up the newly-added timer.
@@ -179,6 +178,8 @@ void WakeNetPoller(int64_t when) {
     NetPollBreak();
   }
   sched->WakePIfNecessary();
+  // An idle runtime may have sysmon parked past this timer's deadline.
+  sched->WakeSysmon(when);
 }
 
 void AddTimer(Timer* t) {
@@ -319,7 +320,8 @@ bool ModTimer(Timer* t, int64_t when, int64_t period,
         DoAddTimer(pp, t);
         pp->TimersLock().Unlock();
         WakeNetPoller(when);
-        return true;
+        // Not pending before: tin::Timer counts heap residencies on this.
+        return false;
       }
       case kTimerDeleted: {
         // Already deleted but still in heap. Treat like a modification.
@@ -70,13 +70,13 @@ bool DelTimer(Timer* t);
 
 // ModTimer modifies an existing timer (or re-adds a removed one) to fire
 // at the new `when` with the given callback/arg/seq. Returns true if the
-// timer was previously waiting/modified, false if it had already fired
-// or was never added (in which case it is re-added).
+// timer was still in a heap (waiting, modified or deleted), false if it
+// had already fired or was never added (in which case it is re-added).
 bool ModTimer(Timer* t, int64_t when, int64_t period,
               TimerCallback f, void* arg, uintptr_t seq);
 
 // ResetTimer resets t to fire at the new `when`. Equivalent to ModTimer
-// keeping the existing callback/arg/seq. Returns true on success.
+// keeping the existing callback/arg/seq; returns what ModTimer returns.
 bool ResetTimer(Timer* t, int64_t when);
 
 // ---- Scheduler-loop entry points (called from FindRunnable) ----
@@ -0,0 +1,218 @@
+// Copyright (c) 2016 Tin Project. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/log/log.h>
+
+#include <utility>
+
+#include "tin/runtime/runtime.h"
+#include "tin/runtime/raw_mutex.h"
+#include "tin/runtime/coroutine.h"
+#include "tin/runtime/timer/timer_queue.h"
+
+#include "tin/time/timer.h"
+
+namespace tin {
+
+// TimerImpl owns one runtime::Timer. The per-P heap keeps a raw pointer to
+// it, and (unlike Go) there is no GC to tell us when the heap lets go, so
+// the impl pins itself through self_ for as long as the runtime timer may
+// be referenced by a heap or by a callback in flight.
+//
+// Lifetime accounting: every ModTimer() that returns false puts the timer
+// back into a heap ("residency"). A residency always ends with exactly one
+// one-shot firing, tagged by kOneShotBit in seq. Periodic firings never end
+// a residency. We never use DelTimer (it would leave the timer in the heap
+// with no notification when it is finally removed); Stop instead turns the
+// timer into an immediate one-shot that delivers nothing.
+class TimerImpl : public std::enable_shared_from_this<TimerImpl> {
+ public:
+  explicit TimerImpl(std::function<void()> fn)
+    : c_(1)
+    , fn_(std::move(fn))
+    , period_(0)
+    , gen_(0)
+    , residencies_(0)
+    , armed_(false) {
+  }
+
+  Chan<int64_t> C() const { return c_; }
+
+  // Arms the timer d ns from now; period > 0 makes it periodic.
+  // Returns true if the timer had been armed.
+  bool Reset(int64_t d, int64_t period) {
+    if (d < 0) {
+      d = 0;
+    }
+    runtime::RawMutexGuard guard(&mu_);
+    bool was_armed = armed_;
+    armed_ = true;
+    period_ = period;
+    Modify(runtime::NanoFromNow(d), period);
+    return was_armed;
+  }
+
+  bool Stop() {
+    runtime::RawMutexGuard guard(&mu_);
+    if (!armed_) {
+      return false;
+    }
+    armed_ = false;
+    period_ = 0;
+    Modify(MonoNow(), 0);
+    return true;
+  }
+
+ private:
+  static const uintptr_t kOneShotBit = 1;
+
+  // Caller holds mu_.
+  void Modify(int64_t when, int64_t period) {
+    ++gen_;
+    uintptr_t seq = (gen_ << 1) | (period > 0 ? 0 : kOneShotBit);
+    if (!runtime::ModTimer(&timer_, when, period, &TimerImpl::OnTimer,
+                           this, seq)) {
+      if (residencies_++ == 0) {
+        self_ = shared_from_this();
+      }
+    }
+  }
+
+  // Runs on the scheduler loop (CheckTimers) with no timer lock held.
+  // Must not park.
+  static void OnTimer(void* arg, uintptr_t seq) {
+    TimerImpl* impl = static_cast<TimerImpl*>(arg);
+    // Declared first so the impl outlives the delivery below.
+    std::shared_ptr<TimerImpl> release;
+    bool deliver;
+    {
+      runtime::RawMutexGuard guard(&impl->mu_);
+      // A stale firing (superseded by Reset/Stop) delivers nothing.
+      deliver = impl->armed_ && (seq >> 1) == impl->gen_;
+      if (deliver && impl->period_ == 0) {
+        impl->armed_ = false;
+      }
+      if ((seq & kOneShotBit) != 0 && --impl->residencies_ == 0) {
+        release = std::move(impl->self_);
+      }
+    }
+    if (!deliver) {
+      return;
+    }
+    if (impl->fn_) {
+      runtime::SpawnInternal(impl->fn_, "afterfunc");
+    } else {
+      // Go time.go:sendTime — non-blocking; drop the tick if C is full.
+      impl->c_->TryPush(MonoNow());
+    }
+  }
+
+  runtime::RawMutex mu_;
+  runtime::Timer timer_;
+  Chan<int64_t> c_;
+  std::function<void()> fn_;
+  int64_t period_;
+  uintptr_t gen_;
+  int residencies_;
+  bool armed_;
+  std::shared_ptr<TimerImpl> self_;
+};
+
+// ---- Timer ----
+
+Timer::Timer(int64_t d)
+  : impl_(std::make_shared<TimerImpl>(nullptr)) {
+  impl_->Reset(d, 0);
+}
+
+Timer::Timer(std::shared_ptr<TimerImpl> impl)
+  : impl_(std::move(impl)) {
+}
+
+Timer::~Timer() = default;
+
+Timer::Timer(Timer&& other) noexcept = default;
+
+Timer& Timer::operator=(Timer&& other) noexcept = default;
+
+Chan<int64_t> Timer::C() const {
+  if (impl_ == nullptr) {
+    LOG(FATAL) << "Timer::C on a moved-from Timer";
+  }
+  return impl_->C();
+}
+
+bool Timer::Stop() {
+  if (impl_ == nullptr) {
+    return false;
+  }
+  return impl_->Stop();
+}
+
+bool Timer::Reset(int64_t d) {
+  if (impl_ == nullptr) {
+    return false;
+  }
+  return impl_->Reset(d, 0);
+}
+
+// ---- Ticker ----
+
+Ticker::Ticker(int64_t d)
+  : impl_(std::make_shared<TimerImpl>(nullptr)) {
+  if (d <= 0) {
+    LOG(FATAL) << "non-positive interval for Ticker";
+  }
+  impl_->Reset(d, d);
+}
+
+Ticker::~Ticker() {
+  Stop();
+}
+
+Ticker::Ticker(Ticker&& other) noexcept = default;
+
+Ticker& Ticker::operator=(Ticker&& other) noexcept {
+  if (this != &other) {
+    Stop();
+    impl_ = std::move(other.impl_);
+  }
+  return *this;
+}
+
+Chan<int64_t> Ticker::C() const {
+  if (impl_ == nullptr) {
+    LOG(FATAL) << "Ticker::C on a moved-from Ticker";
+  }
+  return impl_->C();
+}
+
+void Ticker::Stop() {
+  if (impl_ != nullptr) {
+    impl_->Stop();
+  }
+}
+
+void Ticker::Reset(int64_t d) {
+  if (d <= 0) {
+    LOG(FATAL) << "non-positive interval for Ticker::Reset";
+  }
+  if (impl_ != nullptr) {
+    impl_->Reset(d, d);
+  }
+}
+
+// ---- Helpers ----
+
+Timer AfterFunc(int64_t d, std::function<void()> fn) {
+  auto impl = std::make_shared<TimerImpl>(std::move(fn));
+  impl->Reset(d, 0);
+  return Timer(std::move(impl));
+}
+
+Chan<int64_t> After(int64_t d) {
+  return Timer(d).C();
+}
+
+}  // namespace tin